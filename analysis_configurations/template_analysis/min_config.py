@@ -24,6 +24,7 @@ def build_config(
     available_sample_types: List[str],
     available_eras: List[str],
     available_scopes: List[str],
+    systematics_backend: str = "duplicate",
 ):
 
     configuration = Configuration(
@@ -34,6 +35,7 @@ def build_config(
         available_sample_types,
         available_eras,
         available_scopes,
+        systematics_backend=systematics_backend,
     )
 
     configuration.add_config_parameters(
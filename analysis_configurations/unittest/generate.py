@@ -70,6 +70,7 @@ def run(args):
         available_samples,
         available_eras,
         available_scopes,
+        systematics_backend=args.systematics_backend,
     )
     # create a CodeGenerator object
     generator = CodeGenerator(
@@ -81,8 +82,7 @@ def run(args):
         output_folder=args.output,
         threads=args.threads,
     )
-    if args.debug == "true":
-        generator.debug = True
+    generator.set_build_options(args)
     # generate the code
     generator.generate_code()
 
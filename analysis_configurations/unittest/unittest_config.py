@@ -33,6 +33,7 @@ def build_config(
     available_sample_types: List[str],
     available_eras: List[str],
     available_scopes: List[str],
+    systematics_backend: str = "duplicate",
 ):
 
     configuration = Configuration(
@@ -43,6 +44,7 @@ def build_config(
         available_sample_types,
         available_eras,
         available_scopes,
+        systematics_backend=systematics_backend,
     )
     # first add default parameters necessary for all scopes
     configuration.add_config_parameters(
@@ -14,10 +14,18 @@
 #include "include/reweighting.hxx"
 #include "include/scalefactors.hxx"
 #include "include/triggers.hxx"
+#include "include/utility/EventIndex.hxx"
+#include "include/utility/LockProfiler.hxx"
 #include "include/utility/Logger.hxx"
+#include "include/utility/MemoryBudget.hxx"
+#include "include/utility/Narrowing.hxx"
+#include "include/utility/Sampling.hxx"
 #include <ROOT/RLogger.hxx>
 #include <TFile.h>
 #include <TTree.h>
+#include <cstdlib>
+#include <fstream>
+#include <nlohmann/json.hpp>
 #include <regex>
 #include <string>
 
@@ -49,6 +57,7 @@ int main(int argc, char *argv[]) {
     int nevents = 0;
     int sumw_num = 0;
     Double_t sumofgenweight = 0;
+    std::vector<double> sumofgenweight_per_file;
     Logger::get("main")->info("Checking input files");
     for (int i = 2; i < argc; i++) {
         input_files.push_back(std::string(argv[i]));
@@ -67,15 +76,26 @@ int main(int argc, char *argv[]) {
         Double_t variable;
         t2->SetBranchAddress("genEventSumw", &variable);
         sumw_num = t2->GetEntries();
+        const Double_t sumofgenweight_before = sumofgenweight;
         for (int i = 0; i < sumw_num; i++) {
             t2->GetEntry(i);
             sumofgenweight += variable;
         }
+        sumofgenweight_per_file.push_back(sumofgenweight - sumofgenweight_before);
         Logger::get("main")->info("input_file {}: {} - {} Events", i - 1,
                                   argv[i], t1->GetEntries());
         Logger::get("main")->info("input_file {}: {} - SumOfGenWeight: {} ", i - 1,
                                   argv[i], sumofgenweight);
     }
+    // quick-look sampling of a fraction of the input clusters, configured via
+    // the environment variable CROWN_SAMPLE_FRACTION
+    const auto sampling =
+        utility::sampling::ClusterSampling::FromEnvironment(input_files, "Events");
+    if (sampling.enabled()) {
+        nevents = sampling.SelectedEvents();
+        sumofgenweight = sampling.SumOfWeights(sumofgenweight_per_file);
+        Logger::get("main")->info("Sampled SumOfGenWeight: {}", sumofgenweight);
+    }
     const auto output_path = argv[1];
     Logger::get("main")->info("Output directory: {}", output_path);
     TStopwatch timer;
@@ -88,16 +108,24 @@ int main(int argc, char *argv[]) {
     // {MULTITHREADING}
 
     // initialize df
-    ROOT::RDataFrame df0("Events", input_files);
+    ROOT::RDataFrame df0 = sampling.enabled()
+                               ? ROOT::RDataFrame(sampling.chain())
+                               : ROOT::RDataFrame("Events", input_files);
     Logger::get("main")->info("Starting Setup of Dataframe with {} events",
                               nevents);
+    // primary dataset of the input files, used by the overlap veto of data
+    trigger::IdentifyPrimaryDataset(input_files, {PRIMARY_DATASETS});
 
     // {CODE_GENERATION}
 
+    // {TYPE_PROBE}
+
     ROOT::RDF::RSnapshotOptions dfconfig;
     dfconfig.fLazy = true;
 
     // {RUN_COMMANDS}
+    metfilter::PrintReports();
+    trigger::PrintOverlapReports();
 
     // Add meta-data
     // clang-format off
@@ -133,6 +161,9 @@ int main(int argc, char *argv[]) {
         commit_meta.Branch(commit_hash.c_str(), &setup_clean);
         commit_meta.Fill();
         commit_meta.Write();
+        sampling.Write();
+        metfilter::WriteReports();
+        trigger::WriteOverlapReports();
         outputfile.Close();
     }
 
@@ -140,4 +171,10 @@ int main(int argc, char *argv[]) {
     Logger::get("main")->info(
         "Overall runtime (real time: {0:.2f}, CPU time: {1:.2f})",
         timer.RealTime(), timer.CpuTime());
+    if (LockProfiler::enabled) {
+        Logger::get("main")->info(
+            "{}",
+            LockProfiler::summary(timer.RealTime(), timer.CpuTime(),
+                                  std::max(1u, ROOT::GetThreadPoolSize())));
+    }
 }
@@ -1,17 +1,388 @@
 from __future__ import annotations  # needed for type annotations in > python 3.7
 
 import logging
-from typing import Any, Dict, List, Union, Tuple
+from typing import Any, Dict, List, Optional, Set, Union, Tuple
+import json
 import os
 import filecmp
+import hashlib
+import importlib
+import shutil
+import sys
 from git import Repo, InvalidGitRepositoryError, NoSuchPathError
 
 from code_generation.producer import SafeDict, Producer, ProducerGroup
 
 from code_generation.configuration import Configuration
+from code_generation.quantity import NanoAODQuantity, Quantity, QuantityGroup
 
 log = logging.getLogger(__name__)
 
+# approximate size of a cached column value of a given type in bytes, used for the estimate of the memory per slot
+COLUMN_SIZES: Dict[str, int] = {
+    "bool": 1,
+    "Bool_t": 1,
+    "UChar_t": 1,
+    "int": 4,
+    "Int_t": 4,
+    "UInt_t": 4,
+    "float": 4,
+    "Float_t": 4,
+    "double": 8,
+    "Double_t": 8,
+    "Long64_t": 8,
+    "ULong64_t": 8,
+    "ROOT::Math::PtEtaPhiMVector": 32,
+}
+# default size for columns of unknown or vector type
+COLUMN_SIZE_DEFAULT = 64
+# column types supported by the Arrow output sink, and RVecs of them
+ARROW_SCALAR_TYPES = {
+    "bool",
+    "Bool_t",
+    "char",
+    "Char_t",
+    "UChar_t",
+    "short",
+    "Short_t",
+    "UShort_t",
+    "int",
+    "Int_t",
+    "unsigned int",
+    "UInt_t",
+    "long",
+    "Long_t",
+    "ULong_t",
+    "Long64_t",
+    "ULong64_t",
+    "float",
+    "Float_t",
+    "double",
+    "Double_t",
+}
+ARROW_FORMATS = {"ipc": ("IPC", "arrow"), "parquet": ("Parquet", "parquet")}
+# integer column types and their size in bytes, outputs of these types are narrowed if their calibrated range allows it
+INTEGER_TYPE_SIZES: Dict[str, int] = {
+    "bool": 1,
+    "Bool_t": 1,
+    "char": 1,
+    "Char_t": 1,
+    "UChar_t": 1,
+    "short": 2,
+    "Short_t": 2,
+    "UShort_t": 2,
+    "int": 4,
+    "Int_t": 4,
+    "unsigned int": 4,
+    "UInt_t": 4,
+    "long": 8,
+    "Long_t": 8,
+    "ULong_t": 8,
+    "Long64_t": 8,
+    "ULong64_t": 8,
+}
+# storage types of narrowed outputs with their size in bytes and value range, in the order they are tried
+NARROW_TYPES: List[Tuple[str, int, int, int]] = [
+    ("Bool_t", 1, 0, 1),
+    ("Char_t", 1, -128, 127),
+    ("UChar_t", 1, 0, 255),
+    ("Short_t", 2, -32768, 32767),
+    ("UShort_t", 2, 0, 65535),
+]
+# the calibrated range has to fit into the narrowed type, even if scaled by this factor, flags in [0, 1] are
+# stored as Bool_t without headroom
+NARROWING_HEADROOM = 2
+# the event identifiers depend on the processed sample, not on the physics content, and are never narrowed
+NARROWING_EXCLUDED = {"run", "lumi", "event"}
+# start of the subset function in the subset template, the part before it is shared by all subsets of a unity build source
+SUBSET_FUNCTION_MARKER = "ROOT::RDF::RNode {subsetname}"
+# subfolder of the generated sources containing the unity build sources
+UNITY_FOLDER = "unity"
+# the estimated cost of a unity build source may exceed the average cost of all sources by this factor
+UNITY_BUILD_SLACK = 1.25
+
+
+def arrow_supported(ctype: str) -> bool:
+    """
+    Check if a column type can be written by the Arrow output sink
+
+    Args:
+        ctype: the C++ type of the column
+
+    Returns:
+        bool - True if the type is supported
+    """
+    for prefix in ["ROOT::VecOps::RVec<", "ROOT::RVec<"]:
+        if ctype.startswith(prefix) and ctype.endswith(">"):
+            return ctype[len(prefix) : -1].strip() in ARROW_SCALAR_TYPES
+    return ctype in ARROW_SCALAR_TYPES
+
+
+def split_vector_type(ctype: str) -> Tuple[str, str, str]:
+    """
+    Split a column type into the RVec prefix, the element type and the closing bracket.
+    For scalar types, prefix and suffix are empty.
+
+    Args:
+        ctype: the C++ type of the column
+
+    Returns:
+        tuple of prefix, element type and suffix
+    """
+    for prefix in ["ROOT::VecOps::RVec<", "ROOT::RVec<"]:
+        if ctype.startswith(prefix) and ctype.endswith(">"):
+            return prefix, ctype[len(prefix) : -1].strip(), ">"
+    return "", ctype, ""
+
+
+def narrow_type(ctype: str, value_range: List[int]) -> Optional[str]:
+    """
+    Get the narrowest storage type of an integer column, that covers the calibrated value range of the column.
+
+    Args:
+        ctype: the C++ type of the column
+        value_range: the calibrated minimum and maximum of the column
+
+    Returns:
+        the narrowed type, or None if the column cannot be stored in a smaller type
+    """
+    prefix, element, suffix = split_vector_type(ctype)
+    if element not in INTEGER_TYPE_SIZES:
+        return None
+    low, high = value_range
+    for narrowed, size, minimum, maximum in NARROW_TYPES:
+        if size >= INTEGER_TYPE_SIZES[element]:
+            break
+        headroom = 1 if narrowed == "Bool_t" else NARROWING_HEADROOM
+        if low * headroom >= minimum and high * headroom <= maximum:
+            return prefix + narrowed + suffix
+    return None
+
+
+def write_if_changed(filename: str, content: str) -> bool:
+    """
+    Write a file, unless it already exists with identical content. Unchanged files keep their timestamp,
+    so that they are not recompiled.
+
+    Args:
+        filename: the path of the file
+        content: the content of the file
+
+    Returns:
+        bool: True if the file was written, False if it was unchanged
+    """
+    with open(filename + ".new", "w") as f:
+        f.write(content)
+    if os.path.isfile(filename) and filecmp.cmp(filename + ".new", filename):
+        os.remove(filename + ".new")
+        return False
+    os.rename(filename + ".new", filename)
+    return True
+
+
+def stable_bin(name: str, nbins: int) -> int:
+    """
+    Map a name onto one of nbins bins. The bin only depends on the name, and not on the Python hash seed.
+
+    Args:
+        name: the name
+        nbins: the number of bins
+
+    Returns:
+        int: the bin of the name
+    """
+    return int(hashlib.sha1(name.encode("utf-8")).hexdigest(), 16) % nbins
+
+
+def balance_groups(costs: Dict[str, int], ngroups: int) -> List[List[str]]:
+    """
+    Distribute items with an estimated cost onto a number of groups with similar total cost. Every item is
+    assigned to the group given by a stable hash of its name, so adding, removing or changing one item does
+    not move the other items. The cost is only used to limit the total cost of a group to 125% of the
+    average (UNITY_BUILD_SLACK): an item not fitting into its group is moved to the next group with enough room, or to the group
+    with the lowest total cost if no group has enough room. The items are assigned in the order of their
+    names, so the grouping is reproducible.
+
+    Args:
+        costs: mapping of the items to their cost
+        ngroups: the number of groups, empty groups are dropped
+
+    Returns:
+        List[List[str]]: the items of each group, sorted by name
+    """
+    if len(costs) == 0:
+        return []
+    groups: List[List[str]] = [[] for _ in range(max(ngroups, 1))]
+    loads = [0] * len(groups)
+    capacity = max(
+        sum(costs.values()) * UNITY_BUILD_SLACK / len(groups), max(costs.values())
+    )
+    for item in sorted(costs):
+        first = stable_bin(item, len(groups))
+        candidates = [(first + i) % len(groups) for i in range(len(groups))]
+        target = next(
+            (
+                group
+                for group in candidates
+                if loads[group] + costs[item] <= capacity
+            ),
+            loads.index(min(loads)),
+        )
+        groups[target].append(item)
+        loads[target] += costs[item]
+    return [sorted(group) for group in groups if len(group) > 0]
+
+
+def load_primary_datasets(era: str, database: Optional[str] = None) -> Dict[str, str]:
+    """
+    Read the data samples of an era from the sample database and determine their primary dataset,
+    which is the first part of the dataset path, e.g. SingleMuon for
+    /SingleMuon/Run2018A-UL2018_MiniAODv2_NanoAODv9-v2/NANOAOD.
+
+    Args:
+        era: the era of the samples
+        database: the datasets file of the sample database, defaults to sample_database/datasets.yaml
+
+    Returns:
+        Dict[str, str]: mapping of the nicknames of the samples to their primary dataset
+    """
+    if database is None:
+        database = os.path.join(
+            os.path.dirname(os.path.realpath(__file__)),
+            "..",
+            "sample_database",
+            "datasets.yaml",
+        )
+    if not os.path.exists(database):
+        log.warning("Sample database {} not found".format(database))
+        return {}
+    # only needed for data, so simulated samples do not require PyYAML
+    import yaml
+
+    with open(database, "r") as f:
+        samples = yaml.safe_load(f)
+    return {
+        nick: sample["dbs"].split("/")[1]
+        for nick, sample in samples.items()
+        if sample["sample_type"] == "data" and str(sample["era"]) == str(era)
+    }
+
+
+def load_usage_manifest(filenames: List[str]) -> Dict[str, List[str]]:
+    """
+    Read the usage manifests of the downstream jobs, which list the branch name patterns read from the
+    output of each scope. The manifests can be written by hand or recorded via utility::usage::Record.
+    The patterns of all files are merged, so a branch is kept if any downstream job reads it.
+
+    Args:
+        filenames: the json files of the manifests
+
+    Returns:
+        Dict[str, List[str]]: mapping of the scopes to the sorted branch name patterns
+    """
+    patterns: Dict[str, Set[str]] = {}
+    for filename in filenames:
+        with open(filename, "r") as f:
+            manifest = json.load(f)
+        for scope, branches in manifest.items():
+            patterns.setdefault(scope, set()).update(branches)
+    return {scope: sorted(branches) for scope, branches in patterns.items()}
+
+
+def build_configurations(
+    analysis_name: str, confignames: List[str], *args: Any, **kwargs: Any
+) -> Dict[str, Configuration]:
+    """
+    Build several configurations of an analysis, each from a fresh instance of the analysis modules. The producers
+    and quantities are module level objects, which are modified while a configuration is built, so a second
+    configuration can not be built from the same module instances. For every configuration, the modules of the
+    analysis are imported anew and the numbering of the internal quantities is reset, so identical producers result in
+    identical code. Afterwards, the previously imported modules are restored.
+
+    Args:
+        analysis_name: the name of the analysis folder in analysis_configurations
+        confignames: the names of the configuration modules within the analysis
+        args: the arguments passed to the build_config function of each configuration
+        kwargs: optional keyword arguments passed to the build_config function of each configuration
+
+    Returns:
+        Dict[str, Configuration]: the configurations, keyed by their name
+    """
+    package = "analysis_configurations.{}.".format(analysis_name)
+
+    def analysis_modules() -> List[str]:
+        # the generate module is running the code generation and is kept
+        return [
+            module
+            for module in sys.modules
+            if module.startswith(package) and not module.endswith(".generate")
+        ]
+
+    configurations: Dict[str, Configuration] = {}
+    for configname in confignames:
+        previous = {module: sys.modules.pop(module) for module in analysis_modules()}
+        ProducerGroup.PG_count = 1
+        try:
+            config = importlib.import_module(package + configname)
+            log.info("Configuration used: {}".format(config))
+            configurations[configname] = config.build_config(*args, **kwargs)
+        finally:
+            for module in analysis_modules():
+                del sys.modules[module]
+            sys.modules.update(previous)
+    return configurations
+
+
+def shared_prefix(sequences: Dict[str, List[Any]], key) -> int:
+    """
+    Determine the length of the common prefix of several sequences. Only a prefix can be shared: once two sequences
+    differ at a position, the following elements operate on different inputs, even if they are identical.
+
+    Args:
+        sequences: the sequences to compare
+        key: function mapping an element to the value to be compared
+
+    Returns:
+        int: the number of leading elements, that are identical in all sequences
+    """
+    lengths = [len(sequence) for sequence in sequences.values()]
+    if len(lengths) == 0:
+        return 0
+    first = list(sequences.values())[0]
+    for i in range(min(lengths)):
+        if any(key(sequence[i]) != key(first[i]) for sequence in sequences.values()):
+            return i
+    return min(lengths)
+
+
+def count_pruned_columns(
+    configuration: Configuration, quantity_types: Dict[str, Dict[str, str]]
+) -> Tuple[int, int]:
+    """
+    Count the output columns removed by the usage manifest of a configuration, and estimate their size per event.
+    The outputs of the global scope are written to the output of every scope, so they are counted once per scope.
+
+    Args:
+        configuration: the configuration
+        quantity_types: the cached types of the output quantities, per scope
+
+    Returns:
+        tuple of the number of removed columns and their estimated size in bytes per event and element
+    """
+    nscopes = len(
+        [scope for scope in configuration.scopes if scope != configuration.global_scope]
+    )
+    columns = 0
+    nbytes = 0
+    for scope, outputs in configuration.pruned_outputs.items():
+        copies = nscopes if scope == configuration.global_scope else 1
+        for output in outputs:
+            leaves = copies * len(output.get_leaves_of_scope(scope))
+            ctype = output.ctype or quantity_types.get(scope, {}).get(output.name)
+            columns += leaves
+            nbytes += leaves * COLUMN_SIZES.get(ctype, COLUMN_SIZE_DEFAULT)  # type: ignore
+    return columns, nbytes
+
 
 class CodeSubset(object):
 
@@ -25,6 +396,9 @@ class CodeSubset(object):
         scope: The scope of the code generation.
         folder: The folder in which the code will be generated.
         parameters: The parameters to be used for the generation.
+        tag: Optional tag, used to distinguish subsets of the same producer and scope
+            originating from different configurations. The tag is prepended to the scope
+            in the function name and the subfolder of the generated files.
 
     Returns:
         None
@@ -38,21 +412,41 @@ class CodeSubset(object):
         scope: str,
         folder: str,
         configuration_parameters: Dict[str, Any],
+        tag: str = "",
     ):
         self.file_name = file_name
         self.template = template
         self.producer = producer
         self.scope = scope
-        self.name = producer.name + "_" + scope
+        self.tag = tag
         self.configuration_parameters = configuration_parameters
         self.count = 0
         self.folder = folder
         self.commands: List[str] = []
-        self.headerfile = os.path.join(
-            self.folder, "include", self.scope, "{}.hxx".format(self.file_name)
+
+    @property
+    def label(self) -> str:
+        """
+        The scope label of the subset, this is the scope, prefixed with the tag if one is set.
+        """
+        if self.tag:
+            return "{}_{}".format(self.tag, self.scope)
+        return self.scope
+
+    @property
+    def name(self) -> str:
+        return self.producer.name + "_" + self.label
+
+    @property
+    def headerfile(self) -> str:
+        return os.path.join(
+            self.folder, "include", self.label, "{}.hxx".format(self.file_name)
         )
-        self.sourcefile = os.path.join(
-            self.folder, "src", self.scope, "{}.cxx".format(self.file_name)
+
+    @property
+    def sourcefile(self) -> str:
+        return os.path.join(
+            self.folder, "src", self.label, "{}.cxx".format(self.file_name)
         )
 
     def create(self):
@@ -89,14 +483,52 @@ class CodeSubset(object):
             log.debug("|---> {}".format(self.commands))
         self.commands.append("    return df{};\n".format(self.count))
 
-    def write(self):
+    @property
+    def cost(self) -> int:
+        """
+        Estimate of the compilation cost of the subset, used to balance the unity build sources. Each call
+        instantiates the templates of a producer function and of the RDataFrame nodes it books.
+        """
+        return 1 + self.count
+
+    def source(self) -> str:
+        """
+        The source code of the subset, the template with the generated commands
+
+        Args:
+            None
+
+        Returns:
+            str: the source code
+        """
+        return self.template.replace(
+            "//    { commands }", "".join(self.commands)
+        ).replace("{subsetname}", self.name)
+
+    def function(self) -> str:
+        """
+        The function of the subset, the source code without the includes of the template. Used to
+        combine several subsets into a single unity build source.
+
+        Args:
+            None
+
+        Returns:
+            str: the source code of the function
+        """
+        source = self.source()
+        marker = SUBSET_FUNCTION_MARKER.replace("{subsetname}", self.name)
+        return source[source.index(marker) :]
+
+    def write(self, source: bool = True):
         """
         Write the code subset to a file, both the header and the source. Before writing the files,
         check if they already exists, and if they exist and are not different, skip writing them.
         This is to avoid unnecessary recompilation, since the compiler will check the timestamps of the files.
 
         Args:
-            None
+            source: write the source file of the subset, disabled for unity builds, where the function
+                is written into a shared source instead
 
         Returns:
             None
@@ -104,32 +536,18 @@ class CodeSubset(object):
         log.debug("Writing code subset {}".format(self.name))
         log.debug("folder: {}, file_name: {}".format(self.folder, self.file_name))
         # write the header file if it does not exist or is different
-        with open(self.headerfile + ".new", "w") as f:
-            f.write(f"ROOT::RDF::RNode {self.name}(ROOT::RDF::RNode df);")
-        if os.path.isfile(self.headerfile):
-            if filecmp.cmp(self.headerfile + ".new", self.headerfile):
-                log.debug("--> Identical header file, skipping")
-                os.remove(self.headerfile + ".new")
-            else:
-                os.rename(self.headerfile + ".new", self.headerfile)
-        else:
-            os.rename(self.headerfile + ".new", self.headerfile)
+        if not write_if_changed(
+            self.headerfile, f"ROOT::RDF::RNode {self.name}(ROOT::RDF::RNode df);"
+        ):
+            log.debug("--> Identical header file, skipping")
+        if not source:
+            # remove the source of a previous build without unity build
+            if os.path.isfile(self.sourcefile):
+                os.remove(self.sourcefile)
+            return
         # write the source file if it does not exist or is different
-        with open(self.sourcefile + ".new", "w") as f:
-            commandstring = "".join(self.commands)
-            f.write(
-                self.template.replace("//    { commands }", commandstring).replace(
-                    "{subsetname}", self.name
-                )
-            )
-        if os.path.isfile(self.sourcefile):
-            if filecmp.cmp(self.sourcefile + ".new", self.sourcefile):
-                os.remove(self.sourcefile + ".new")
-                log.debug("--> Identical source file, skipping")
-            else:
-                os.rename(self.sourcefile + ".new", self.sourcefile)
-        else:
-            os.rename(self.sourcefile + ".new", self.sourcefile)
+        if not write_if_changed(self.sourcefile, self.source()):
+            log.debug("--> Identical source file, skipping")
 
     def call(self, inputscope: str, outputscope: str) -> str:
         """
@@ -171,6 +589,12 @@ class CodeGenerator(object):
         analysis_name: the name of the analysis
         executable_name: the name of the executable
         output_folder: the folder to write the code to
+        threads: the number of threads used by the executable
+        quantity_types: mapping of scopes to the C++ types of their output quantities, used for quantities without a declared type.
+            If the types of all outputs of a scope are known, a typed Snapshot is generated for the scope.
+        quantity_ranges: mapping of quantity names to their calibrated value range. Integer outputs of typed
+            Snapshots are written with the narrowest type covering their range. If None, no ranges are used and
+            the executable contains no range calibration.
 
     Returns:
         None
@@ -185,6 +609,8 @@ class CodeGenerator(object):
         executable_name: str,
         output_folder: str,
         threads: int = 1,
+        quantity_types: Optional[Dict[str, Dict[str, str]]] = None,
+        quantity_ranges: Optional[Dict[str, List[int]]] = None,
     ):
         self.main_template = self.load_template(main_template_path)
         self.subset_template = self.load_template(sub_template_path)
@@ -209,6 +635,35 @@ class CodeGenerator(object):
         self.main_counter: Dict[str, int] = {}
         self.number_of_defines = 0
         self.number_of_outputs = 0
+        self.input_branches: Set[str] = set()
+        self.quantity_types: Dict[str, Dict[str, str]] = (
+            quantity_types if quantity_types is not None else {}
+        )
+        self.typed_snapshots: List[str] = []
+        self.quantity_ranges: Optional[Dict[str, List[int]]] = quantity_ranges
+        self.narrowed_scopes: List[str] = []
+        self.narrowed_columns = 0
+        self.narrowed_bytes = 0
+        # additional output in Arrow format, one of none, ipc or parquet
+        self.arrow_output = "none"
+        self.arrow_scopes: List[str] = []
+        # write the output of single-threaded executables in a background thread
+        self.async_writer = False
+        self.async_scopes: List[str] = []
+        # number of unity build sources the subsets are combined into, 0 to compile each subset separately
+        self.unity_build = 0
+        # set once the build options of generate.py are applied, see set_build_options
+        self.build_options_set = False
+        self.subsets: List[CodeSubset] = []
+        # the unity build sources, with their estimated cost and if they were rewritten
+        self.unity_sources: List[Tuple[str, int, bool]] = []
+        # mapping of the data samples of the sample database to their primary dataset, empty for simulation
+        self.primary_datasets: Dict[str, str] = {}
+        # output columns of each scope and their types, None if not all types are known
+        self.snapshot_columns: Dict[str, Tuple[List[str], Optional[List[str]]]] = {}
+        self.varied_shifts: Dict[str, Dict[str, str]] = self.configuration.varied_shifts
+        # the first dataframe of the global scope, this is the varied dataframe if the Vary backend is used
+        self.input_dataframe = "df0_varied" if len(self.varied_shifts) > 0 else "df0"
         for scope in self.scopes:
             self.main_counter[scope] = 0
             self.subset_calls[scope] = []
@@ -227,6 +682,34 @@ class CodeGenerator(object):
             self.setup_is_clean = "false"
         log.info("Code generator initialized")
 
+    def set_build_options(self, args: Any) -> None:
+        """
+        Apply the build options passed to generate.py (debug mode, Arrow output, asynchronous writer and unity build)
+        to the generator. Has to be called by the generate.py of every analysis before the code is generated, so that
+        no option is silently ignored.
+
+        Args:
+            args: the parsed arguments of generate.py
+
+        Returns:
+            None
+        """
+        self.debug = args.debug == "true"
+        self.arrow_output = args.arrow_output
+        self.async_writer = args.async_writer == "true"
+        self.unity_build = args.unity_build
+        self.build_options_set = True
+
+    def check_build_options(self) -> None:
+        """
+        Check that the build options of generate.py were applied to the generator.
+        """
+        if not self.build_options_set:
+            log.error(
+                "The build options were not applied, call generator.set_build_options(args) in the generate.py of the analysis"
+            )
+            raise Exception("Build options of generate.py not applied")
+
     def generate_code(self) -> None:
         """
         Generate the code from the configuration and create the subsets. Run through the whole configuration and create a subset for each producer within the configuration.
@@ -239,6 +722,7 @@ class CodeGenerator(object):
         Returns:
             None
         """
+        self.check_build_options()
         # start with the global scope
 
         for subfolder in ["src", "include"]:
@@ -263,11 +747,64 @@ class CodeGenerator(object):
         for scope in self.scopes:
             self.generate_subsets(scope)
 
+        self.write_unity_sources()
         calls, includes = self.generate_main_code()
         run_commands = self.generate_run_commands()
 
         self.write_code(calls, includes, run_commands)
 
+    def write_unity_sources(self) -> None:
+        """
+        Combine the functions of all subsets into self.unity_build sources, which are compiled instead
+        of one source per subset. Every source includes the headers of the subset template once, which
+        saves most of the parsing and template instantiation of the shared headers. The subsets are
+        distributed onto the sources by their estimated cost, so that the sources take a similar time
+        to compile in a parallel build. Sources with unchanged content are not rewritten and are not
+        recompiled. Without unity build, the sources of a previous unity build are removed.
+
+        Args:
+            None
+
+        Returns:
+            None
+        """
+        folder = os.path.join(
+            self.output_folder,
+            self.executable_name + "_generated_code",
+            "src",
+            UNITY_FOLDER,
+        )
+        if self.unity_build == 0:
+            if os.path.isdir(folder):
+                shutil.rmtree(folder)
+            return
+        if not os.path.exists(folder):
+            os.makedirs(folder)
+        subsets = {subset.name: subset for subset in self.subsets}
+        groups = balance_groups(
+            {name: subset.cost for name, subset in subsets.items()}, self.unity_build
+        )
+        preamble = self.subset_template[
+            : self.subset_template.index(SUBSET_FUNCTION_MARKER)
+        ]
+        filenames = []
+        for i, group in enumerate(groups):
+            filename = os.path.join(folder, "unity_{}.cxx".format(i))
+            functions = [subsets[name].function() for name in group]
+            written = write_if_changed(filename, preamble + "\n".join(functions))
+            cost = sum(subsets[name].cost for name in group)
+            self.unity_sources.append((filename, cost, written))
+            filenames.append(filename)
+            log.debug(
+                "Unity build source {} with {} subsets, estimated cost {}, {}".format(
+                    filename, len(group), cost, "written" if written else "unchanged"
+                )
+            )
+        # remove sources left over from a previous build with more sources
+        for filename in os.listdir(folder):
+            if os.path.join(folder, filename) not in filenames:
+                os.remove(os.path.join(folder, filename))
+
     def load_template(self, template_path: str) -> str:
         """
         Load the template from the given path
@@ -294,13 +831,14 @@ class CodeGenerator(object):
         """
         if self.threads > 1:
             log.info(f"Using {self.threads} threads for the executable")
-            threadcall = "ROOT::EnableImplicitMT({});".format(self.threads)
+            threadcall = self.set_thread_count()
         else:
             threadcall = ""
         with open(self.executable, "w") as f:
             f.write(
                 self.main_template.replace("    // {CODE_GENERATION}", calls)
                 .replace("// {INCLUDES}", includes)
+                .replace("    // {TYPE_PROBE}", self.set_type_probe())
                 .replace("    // {RUN_COMMANDS}", run_commands)
                 .replace("// {MULTITHREADING}", threadcall)
                 .replace("// {DEBUGLEVEL}", self.set_debug_flag())
@@ -311,17 +849,67 @@ class CodeGenerator(object):
                 .replace("{ANALYSISTAG}", '"Analysis={}"'.format(self.analysis_name))
                 .replace("{PROGRESS_CALLBACK}", self.set_process_tracking())
                 .replace("{OUTPUT_QUANTITIES}", self.set_output_quantities())
+                .replace("{PRIMARY_DATASETS}", self.set_primary_datasets())
                 .replace("{SYSTEMATIC_VARIATIONS}", self.set_shifts())
                 .replace("{COMMITHASH}", '"{}"'.format(self.commit_hash))
                 .replace("{SETUP_IS_CLEAN}", self.setup_is_clean)
             )
         log.info("Code written to {}".format(self.executable))
+        self.write_input_branches()
         log.info("------------------------------------")
         log.info("Code Generation Report")
         log.info("------------------------------------")
         log.info("  Output path: {}".format(self.executable))
         log.info("  Total Number of Defines: {} ".format(self.number_of_defines))
         log.info("  Total Number of Outputs: {} ".format(self.number_of_outputs))
+        log.info(
+            "  Scopes with typed Snapshot: {} / {}".format(
+                len(self.typed_snapshots), len(self._outputfiles_generated.keys())
+            )
+        )
+        if self.quantity_ranges:
+            log.info(
+                "  Scopes with narrowed outputs: {} / {}, {} columns narrowed, saving {} bytes per event and element".format(
+                    len(self.narrowed_scopes),
+                    len(self._outputfiles_generated.keys()),
+                    self.narrowed_columns,
+                    self.narrowed_bytes,
+                )
+            )
+        pruned_columns, pruned_bytes, pruned_calls = self.get_pruned_columns()
+        if pruned_columns > 0 or pruned_calls > 0:
+            log.info(
+                "  Outputs removed by the usage manifest: {} columns, saving {} bytes per event and element and {} producer calls per event".format(
+                    pruned_columns, pruned_bytes, pruned_calls
+                )
+            )
+        if len(self.unity_sources) > 0:
+            costs = [cost for _, cost, _ in self.unity_sources]
+            log.info(
+                "  Unity build: {} subsets in {} sources, estimated cost per source {} - {} (balance {:.2f}), {} sources rewritten, {} unchanged".format(
+                    len(self.subsets),
+                    len(self.unity_sources),
+                    min(costs),
+                    max(costs),
+                    max(costs) / (sum(costs) / len(costs)),
+                    len([source for source in self.unity_sources if source[2]]),
+                    len([source for source in self.unity_sources if not source[2]]),
+                )
+            )
+        if self.async_writer:
+            log.info(
+                "  Scopes with background writer: {} / {}".format(
+                    len(self.async_scopes), len(self._outputfiles_generated.keys())
+                )
+            )
+        if self.arrow_output != "none":
+            log.info(
+                "  Scopes with {} output: {} / {}".format(
+                    self.arrow_output,
+                    len(self.arrow_scopes),
+                    len(self._outputfiles_generated.keys()),
+                )
+            )
         log.info(
             "  Total Number of Output files: {} ".format(
                 len(self._outputfiles_generated.keys())
@@ -329,6 +917,60 @@ class CodeGenerator(object):
         )
         log.info("------------------------------------")
 
+    def add_input_branches(
+        self, producer: Union[Producer, ProducerGroup], scope: str
+    ) -> None:
+        """
+        Add the NanoAOD branches read by a producer, including the shifted versions of them, to the list of input branches
+
+        Args:
+            producer: the producer
+            scope: the scope of the producer
+
+        Returns:
+            None
+        """
+        for quantity in producer.get_inputs(scope):
+            if isinstance(quantity, NanoAODQuantity):
+                self.input_branches.add(quantity.name)
+                self.input_branches.update(quantity.shifted_naming.values())
+
+    def write_input_branches(self) -> None:
+        """
+        Write the list of NanoAOD branches declared as inputs by the producers of the executable. The file is placed next
+        to the executable and can be used to drop unused branches from the input files (see profiling/recluster_nanoaod.py).
+        Branches that are only accessed via their name in a configuration parameter (e.g. trigger paths or MET filters)
+        are not part of the list.
+
+        Args:
+            None
+
+        Returns:
+            None
+        """
+        branchfile = os.path.join(
+            os.path.dirname(self.executable),
+            self.executable_name + "_input_branches.txt",
+        )
+        with open(branchfile, "w") as f:
+            f.write("".join(f"{branch}\n" for branch in sorted(self.input_branches)))
+        log.info(
+            "{} input branches written to {}".format(
+                len(self.input_branches), branchfile
+            )
+        )
+
+    def get_pruned_columns(self) -> Tuple[int, int, int]:
+        """
+        Get the output columns and producer calls removed by the usage manifest
+
+        Returns:
+            tuple of the number of removed columns, their estimated size in bytes per event and element, and the
+            number of producer calls saved per event
+        """
+        columns, nbytes = count_pruned_columns(self.configuration, self.quantity_types)
+        return columns, nbytes, self.configuration.pruning_calls_saved
+
     def generate_main_code(self) -> Tuple[str, str]:
         """
         Generate the call commands for all the subsets. Additionally, generate all include statements for the main executable.
@@ -337,11 +979,17 @@ class CodeGenerator(object):
         Returns:
             Tuple, the generated calls and the generated includes
         """
-        main_calls = ""
+        main_calls = self.set_variations()
         for scope in self.scopes:
             main_calls += "    // {}\n".format(scope)
             main_calls += "".join(self.subset_calls[scope])
         main_includes = "".join(self.subset_includes)
+        if len(self.varied_shifts) > 0:
+            main_includes += '#include "include/utility/Variations.hxx"\n'
+        if self.arrow_output != "none":
+            main_includes += '#include "include/utility/ArrowSink.hxx"\n'
+        if self.use_async_writer():
+            main_includes += '#include "include/utility/AsyncSnapshot.hxx"\n'
         return main_calls, main_includes
 
     def get_cmake_path(self) -> str:
@@ -356,6 +1004,47 @@ class CodeGenerator(object):
             self.executable_name + "_generated_code", self.executable_name + ".cxx"
         )
 
+    def is_global_scope(self, scope: str) -> bool:
+        """
+        Check if the given scope is a global scope. Global scopes are not written to an output file on their own,
+        their outputs are added to the outputs of all other scopes.
+        Args:
+            scope: the scope to check
+        Returns:
+            bool - True if the scope is a global scope
+        """
+        return scope == self.global_scope
+
+    def get_global_scope_of(self, scope: str) -> str:
+        """
+        Get the global scope, the given scope is branched from
+        Args:
+            scope: the scope
+        Returns:
+            str - the name of the global scope
+        """
+        return self.global_scope
+
+    def get_real_scope(self, scope: str) -> str:
+        """
+        Get the scope name as used in the configuration, which is used to resolve the names of quantities
+        Args:
+            scope: the scope
+        Returns:
+            str - the scope name within the configuration
+        """
+        return scope
+
+    def get_shifts_of(self, scope: str) -> Dict[str, Any]:
+        """
+        Get the shifts configured for the given scope
+        Args:
+            scope: the scope
+        Returns:
+            the shifts of the scope
+        """
+        return self.configuration.shifts[scope]
+
     def generate_subsets(self, scope: str) -> None:
         """
         Generate the subsets for the given scope
@@ -388,7 +1077,9 @@ class CodeGenerator(object):
                 configuration_parameters=self.configuration.config_parameters[scope],
             )
             subset.create()
-            subset.write()
+            subset.write(source=self.unity_build == 0)
+            self.subsets.append(subset)
+            self.add_input_branches(producer, scope)
             self.number_of_defines += subset.count
             log.debug(
                 "Adding {} defines for {} in scope {}".format(
@@ -400,7 +1091,10 @@ class CodeGenerator(object):
             # 2. first call of all other scopes: we have to use the last global df as the input df
             if scope == self.global_scope and is_first:
                 self.subset_calls[scope].append(
-                    subset.call(inputscope="df0", outputscope=f"df{counter+1}_{scope}")
+                    subset.call(
+                        inputscope=self.input_dataframe,
+                        outputscope=f"df{counter+1}_{scope}",
+                    )
                 )
             elif is_first:
                 self.subset_calls[scope].append(
@@ -434,11 +1128,20 @@ class CodeGenerator(object):
         """
         log.debug("Generating run commands")
         runcommands = ""
+        if len(self.varied_shifts) > 0:
+            runcommands += "    utility::variations::EnableInSnapshot(dfconfig);\n"
+        # value ranges of the integer outputs, recorded if the executable runs in calibration mode
+        if self.quantity_ranges is not None:
+            runcommands += "    utility::narrowing::Calibration calibration;\n"
         for scope in self.scopes:
             outputset: List[str] = []
             for output in sorted(self.outputs[scope]):
-                self.output_commands[scope].extend(output.get_leaves_of_scope(scope))
-            if len(self.output_commands[scope]) > 0 and scope != self.global_scope:
+                self.output_commands[scope].extend(
+                    output.get_leaves_of_scope(self.get_real_scope(scope))
+                )
+            if len(self.output_commands[scope]) > 0 and not self.is_global_scope(
+                scope
+            ):
                 # if no output is produced by the scope, we do not create a corresponding output file
                 self._outputfiles_generated[scope] = "outputpath_{scope}".format(
                     scope=scope
@@ -447,12 +1150,14 @@ class CodeGenerator(object):
                 outputset = list(
                     set(
                         self.output_commands[scope]
-                        + self.output_commands[self.global_scope]
+                        + self.output_commands[self.get_global_scope_of(scope)]
                     )
                 )
                 # sort the output list to get alphabetical order of the output names
                 outputset.sort()
                 outputstring = '", "'.join(outputset)
+                outputtypes = self.get_output_types(scope, outputset)
+                self.snapshot_columns[scope] = (outputset, outputtypes)
 
                 self.number_of_outputs += len(self.output_commands[scope])
                 runcommands += "    auto {scope}_cutReport = df{counter}_{scope}.Report();\n".format(
@@ -461,22 +1166,94 @@ class CodeGenerator(object):
                 runcommands += '    std::string {outputname} = std::regex_replace(std::string(output_path), std::regex("\\\\.root"), "_{scope}.root");\n'.format(
                     scope=scope, outputname=self._outputfiles_generated[scope]
                 )
-                runcommands += '    auto {scope}_result = df{counter}_{scope}.Snapshot("ntuple", {outputname}, {{"{outputstring}"}}, dfconfig);\n'.format(
-                    scope=scope,
-                    counter=self.main_counter[scope],
-                    outputname=self._outputfiles_generated[scope],
-                    outputstring=outputstring,
-                )
+                calibrated = self.get_calibrated_columns(scope, outputset)
+                if len(calibrated) > 0:
+                    runcommands += "    calibration.Book(df{counter}_{scope}, {{\"{columns}\"}}, {{\"{quantities}\"}});\n".format(
+                        scope=scope,
+                        counter=self.main_counter[scope],
+                        columns='", "'.join(column for column, _ in calibrated),
+                        quantities='", "'.join(name for _, name in calibrated),
+                    )
+                if outputtypes is not None:
+                    # with the types of all columns known, no Snapshot has to be jitted at runtime
+                    self.typed_snapshots.append(scope)
+                    snapshot = self.typed_snapshot_call(
+                        scope,
+                        "df{}_{}".format(self.main_counter[scope], scope),
+                        outputstring,
+                        outputtypes,
+                    )
+                    narrowed = self.get_narrowed_types(scope, outputset, outputtypes)
+                    if len(narrowed) > 0:
+                        runcommands += self.set_narrowing(
+                            scope, outputset, outputtypes, narrowed
+                        )
+                        narrowedtypes = [
+                            narrowed.get(column, ctype)
+                            for column, ctype in zip(outputset, outputtypes)
+                        ]
+                        snapshot = "narrow_outputs ? {} : {}".format(
+                            self.typed_snapshot_call(
+                                scope,
+                                "df{}_{}_narrowed".format(
+                                    self.main_counter[scope], scope
+                                ),
+                                outputstring,
+                                narrowedtypes,
+                            ),
+                            snapshot,
+                        )
+                    if self.use_async_writer():
+                        self.async_scopes.append(scope)
+                    runcommands += "    auto {scope}_result = {snapshot};\n".format(
+                        scope=scope, snapshot=snapshot
+                    )
+                else:
+                    runcommands += '    auto {scope}_result = df{counter}_{scope}.Snapshot("ntuple", {outputname}, {{"{outputstring}"}}, dfconfig);\n'.format(
+                        scope=scope,
+                        counter=self.main_counter[scope],
+                        outputname=self._outputfiles_generated[scope],
+                        outputstring=outputstring,
+                    )
+                if self.arrow_output != "none":
+                    runcommands += self.set_arrow_output(scope, outputset, outputtypes)
         # add code for tracking the progress
         runcommands += self.set_process_tracking()
         # add code for the time taken for the dataframe setup
         runcommands += self.set_setup_printout()
         # add trigger of dataframe execution, for nonempty scopes
+        event_loop_run = False
         for scope in self.scopes:
-            if len(self.output_commands[scope]) > 0 and scope != self.global_scope:
-                runcommands += f"    {scope}_result.GetValue();\n"
+            if len(self.output_commands[scope]) > 0 and not self.is_global_scope(
+                scope
+            ):
+                if len(self.narrowed_scopes) > 0 and not event_loop_run:
+                    # the event loop is run by the first GetValue, if a narrowed output overflows,
+                    # the executable is restarted with the original output types
+                    runcommands += "    try {\n"
+                    runcommands += f"        {scope}_result.GetValue();\n"
+                    runcommands += "    } catch (const utility::narrowing::Overflow &overflow) {\n"
+                    runcommands += "        return utility::narrowing::RerunWide(argv, overflow);\n"
+                    runcommands += "    }\n"
+                else:
+                    runcommands += f"    {scope}_result.GetValue();\n"
+                event_loop_run = True
                 runcommands += f'    Logger::get("main")->info("{scope}:");\n'
                 runcommands += f"    {scope}_cutReport->Print();\n"
+                runcommands += f"    sampling.PrintReport(*{scope}_cutReport);\n"
+                if len(self.varied_shifts) > 0:
+                    runcommands += '    utility::variations::Finalize({outputname}, "ntuple", {{"{shifts}"}});\n'.format(
+                        outputname=self._outputfiles_generated[scope],
+                        shifts='", "'.join(
+                            shift[2:] for shift in sorted(self.varied_shifts.keys())
+                        ),
+                    )
+                # sorted (run, lumi, event) index for the lookup of single events
+                runcommands += '    utility::eventindex::Write({outputname}, "ntuple");\n'.format(
+                    outputname=self._outputfiles_generated[scope]
+                )
+        if self.quantity_ranges is not None:
+            runcommands += "    calibration.Write();\n"
         log.info(
             "Output files generated for scopes: {}".format(
                 self._outputfiles_generated.keys()
@@ -485,6 +1262,418 @@ class CodeGenerator(object):
 
         return runcommands
 
+    def typed_snapshot_call(
+        self, scope: str, dataframe: str, outputstring: str, outputtypes: List[str]
+    ) -> str:
+        """
+        Generate the typed Snapshot of a scope. For single-threaded executables, the background writer is used if
+        enabled.
+
+        Args:
+            scope: the scope
+            dataframe: the dataframe the Snapshot is booked on
+            outputstring: the output columns, separated by '", "'
+            outputtypes: the types of the output columns
+
+        Returns:
+            str - the Snapshot call
+        """
+        if self.use_async_writer():
+            # the filling and compression of the output tree is done by a background thread
+            return '{df}.Book<{outputtypes}>(utility::asyncsnapshot::AsyncSnapshot<{outputtypes}>("ntuple", {outputname}, {{"{outputstring}"}}, dfconfig), {{"{outputstring}"}})'.format(
+                df=dataframe,
+                outputname=self._outputfiles_generated[scope],
+                outputstring=outputstring,
+                outputtypes=", ".join(outputtypes),
+            )
+        return '{df}.Snapshot<{outputtypes}>("ntuple", {outputname}, {{"{outputstring}"}}, dfconfig)'.format(
+            df=dataframe,
+            outputname=self._outputfiles_generated[scope],
+            outputstring=outputstring,
+            outputtypes=", ".join(outputtypes),
+        )
+
+    def get_calibrated_columns(
+        self, scope: str, outputset: List[str]
+    ) -> List[Tuple[str, str]]:
+        """
+        Get the output columns of a scope, whose value range is recorded in calibration mode. These are all
+        columns with a known integer type, that is wider than one byte, except for the event identifiers.
+
+        Args:
+            scope: the scope
+            outputset: the sorted list of output columns of the scope
+
+        Returns:
+            list of the columns and the nominal names of their quantities
+        """
+        if self.quantity_ranges is None or len(self.varied_shifts) > 0:
+            return []
+        leaves = self.get_leaf_quantities(scope)
+        calibrated: List[Tuple[str, str]] = []
+        for column in outputset:
+            name, ctype = leaves.get(column, (column, None))
+            if ctype is None or name in NARROWING_EXCLUDED:
+                continue
+            element = split_vector_type(ctype)[1]
+            if INTEGER_TYPE_SIZES.get(element, 1) > 1:
+                calibrated.append((column, name))
+        return calibrated
+
+    def get_narrowed_types(
+        self, scope: str, outputset: List[str], outputtypes: List[str]
+    ) -> Dict[str, str]:
+        """
+        Get the narrowed types of the output columns of a scope, based on the calibrated value ranges of their
+        quantities. Shifted columns use the range of the nominal quantity. No narrowing is done if shifts are
+        expressed as Vary, since the Snapshot writes the varied columns itself.
+
+        Args:
+            scope: the scope
+            outputset: the sorted list of output columns of the scope
+            outputtypes: the types of the output columns
+
+        Returns:
+            dict mapping the narrowed columns to their narrowed type
+        """
+        if not self.quantity_ranges or len(self.varied_shifts) > 0:
+            return {}
+        leaves = self.get_leaf_quantities(scope)
+        narrowed: Dict[str, str] = {}
+        for column, ctype in zip(outputset, outputtypes):
+            name = leaves[column][0]
+            if name not in self.quantity_ranges or name in NARROWING_EXCLUDED:
+                continue
+            narrowedtype = narrow_type(ctype, self.quantity_ranges[name])
+            if narrowedtype is not None:
+                narrowed[column] = narrowedtype
+        return narrowed
+
+    def set_narrowing(
+        self,
+        scope: str,
+        outputset: List[str],
+        outputtypes: List[str],
+        narrowed: Dict[str, str],
+    ) -> str:
+        """
+        Generate the dataframe writing the narrowed outputs of a scope. Each narrowed column is redefined with a
+        checked conversion to its narrowed type. Whether the narrowed or the original dataframe is written is
+        decided at runtime, see utility::narrowing::Enabled.
+
+        Args:
+            scope: the scope
+            outputset: the sorted list of output columns of the scope
+            outputtypes: the types of the output columns
+            narrowed: dict mapping the narrowed columns to their narrowed type
+
+        Returns:
+            str - the generated code
+        """
+        code = ""
+        if len(self.narrowed_scopes) == 0:
+            code += "    const bool narrow_outputs = utility::narrowing::Enabled();\n"
+        self.narrowed_scopes.append(scope)
+        dataframe = "df{}_{}".format(self.main_counter[scope], scope)
+        types = dict(zip(outputset, outputtypes))
+        code += "    ROOT::RDF::RNode {df}_narrowed = {df};\n".format(df=dataframe)
+        for column, narrowedtype in sorted(narrowed.items()):
+            code += '    {df}_narrowed = {df}_narrowed.Redefine("{column}", utility::narrowing::Checked<{narrowed}, {original}>{{"{column}"}}, {{"{column}"}});\n'.format(
+                df=dataframe,
+                column=column,
+                narrowed=narrowedtype,
+                original=types[column],
+            )
+            original = INTEGER_TYPE_SIZES[split_vector_type(types[column])[1]]
+            self.narrowed_bytes += original - INTEGER_TYPE_SIZES[
+                split_vector_type(narrowedtype)[1]
+            ]
+        self.narrowed_columns += len(narrowed)
+        log.debug("Scope {}: narrowed outputs {}".format(scope, narrowed))
+        return code
+
+    def use_async_writer(self) -> bool:
+        """
+        Check if the output is written by a background thread. This is only done for single-threaded executables,
+        since with implicit multithreading, the Snapshot already compresses the output in the worker threads. The
+        Vary backend requires the Snapshot to write the varied columns.
+
+        Args:
+            None
+        Returns:
+            bool - True if the background writer is used
+        """
+        return (
+            self.async_writer and self.threads == 1 and len(self.varied_shifts) == 0
+        )
+
+    def set_arrow_output(
+        self, scope: str, outputset: List[str], outputtypes: Optional[List[str]]
+    ) -> str:
+        """
+        Generate the Arrow output sink of a scope, writing the same columns as the Snapshot to an Arrow IPC or Parquet
+        file in the same event loop. The sink requires the types of all output columns, scopes with unknown or
+        unsupported types are only written as ROOT file.
+
+        Args:
+            scope: the scope
+            outputset: the sorted list of output columns of the scope
+            outputtypes: the types of the output columns, None if not all types are known
+
+        Returns:
+            str - the code booking the sink
+        """
+        if outputtypes is None:
+            log.warning(
+                "Scope {}: not all output types are known, no {} output is written".format(
+                    scope, self.arrow_output
+                )
+            )
+            return ""
+        unsupported = sorted(
+            set(
+                column
+                for column, ctype in zip(outputset, outputtypes)
+                if not arrow_supported(ctype)
+            )
+        )
+        if len(unsupported) > 0:
+            log.warning(
+                "Scope {}: outputs {} have types not supported by the {} output, no {} output is written".format(
+                    scope, unsupported, self.arrow_output, self.arrow_output
+                )
+            )
+            return ""
+        self.arrow_scopes.append(scope)
+        arrowformat, extension = ARROW_FORMATS[self.arrow_output]
+        metadata = [
+            '{{"analysis", "{}"}}'.format(self.analysis_name),
+            '{{"era", "{}"}}'.format(self.configuration.era),
+            '{{"sample", "{}"}}'.format(self.configuration.sample),
+            '{{"commit", "{}"}}'.format(self.commit_hash),
+            '{{"setup_clean", "{}"}}'.format(self.setup_is_clean),
+            '{"genEventSumw", std::to_string(sumofgenweight)}',
+        ]
+        types = ", ".join(outputtypes)
+        columns = '", "'.join(outputset)
+        code = '    std::string outputpath_{scope}_arrow = std::regex_replace(std::string(output_path), std::regex("\\\\.root"), "_{scope}.{extension}");\n'.format(
+            scope=scope, extension=extension
+        )
+        code += "    auto {scope}_arrow = df{counter}_{scope}.Book<{types}>(utility::arrowsink::ArrowSink<{types}>(outputpath_{scope}_arrow, {{\"{columns}\"}}, utility::arrowsink::Format::{arrowformat}, {{{metadata}}}, df{counter}_{scope}.GetNSlots()), {{\"{columns}\"}});\n".format(
+            scope=scope,
+            counter=self.main_counter[scope],
+            types=types,
+            columns=columns,
+            arrowformat=arrowformat,
+            metadata=", ".join(metadata),
+        )
+        return code
+
+    def set_variations(self) -> str:
+        """
+        Generate the Vary calls for the shifts expressed as variations of their source columns. Each shift is a
+        separate variation, varying all columns replaced by the shift together. The variations are applied to the input
+        dataframe, before any producer of the global scope.
+
+        Returns:
+            str - the code to be added to the template
+        """
+        if len(self.varied_shifts) == 0:
+            return ""
+        variations = "    // systematic variations\n"
+        variations += "    ROOT::RDF::RNode {} = df0;\n".format(self.input_dataframe)
+        for shift, changes in sorted(self.varied_shifts.items()):
+            name = shift[2:]
+            columns = sorted(changes.keys())
+            if len(columns) == 1:
+                variations += '    {df} = {df}.Vary("{column}", "ROOT::RVec<std::decay_t<decltype({column})>>{{{varied}}}", {{"{name}"}}, "{name}");\n'.format(
+                    df=self.input_dataframe,
+                    column=columns[0],
+                    varied=changes[columns[0]],
+                    name=name,
+                )
+            else:
+                # all columns of a shift must have the same type
+                variations += '    {df} = {df}.Vary({{"{columns}"}}, "ROOT::RVec<ROOT::RVec<std::decay_t<decltype({first})>>>{{{varied}}}", {{"{name}"}}, "{name}");\n'.format(
+                    df=self.input_dataframe,
+                    columns='", "'.join(columns),
+                    first=columns[0],
+                    varied=", ".join(
+                        "{{{}}}".format(changes[column]) for column in columns
+                    ),
+                    name=name,
+                )
+        log.info(
+            "  {} shifts expressed as Vary of {} source columns".format(
+                len(self.varied_shifts),
+                len(set(c for changes in self.varied_shifts.values() for c in changes)),
+            )
+        )
+        return variations
+
+    def get_output_quantities(self, scope: str) -> Dict[str, Quantity]:
+        """
+        Get the output quantities of a scope, including the outputs of the corresponding global scope.
+        Quantity groups are resolved into their members.
+
+        Args:
+            scope: the scope
+
+        Returns:
+            dict mapping the nominal names of the quantities to the quantities
+        """
+        quantities: Dict[str, Quantity] = {}
+        for outputscope in [self.get_global_scope_of(scope), scope]:
+            for output in self.outputs[outputscope]:
+                if isinstance(output, QuantityGroup):
+                    for quantity in output.quantities:
+                        quantities[quantity.name] = quantity
+                else:
+                    quantities[output.name] = output
+        return quantities
+
+    def get_leaf_quantities(
+        self, scope: str
+    ) -> Dict[str, Tuple[str, Optional[str]]]:
+        """
+        Map the output columns of a scope, including the shifted ones, to the nominal name and the C++ type of
+        their quantity. A declared type of a quantity takes precedence over the type from the type cache.
+
+        Args:
+            scope: the scope
+
+        Returns:
+            dict mapping the output columns to the name and type of their quantity, the type is None if unknown
+        """
+        real_scope = self.get_real_scope(scope)
+        cached_types = self.quantity_types.get(real_scope, {})
+        leaves: Dict[str, Tuple[str, Optional[str]]] = {}
+        for name, quantity in self.get_output_quantities(scope).items():
+            ctype = quantity.ctype or cached_types.get(name)
+            if quantity.ctype and cached_types.get(name, quantity.ctype) != quantity.ctype:
+                log.warning(
+                    "Scope {}: declared type {} of {} differs from the cached type {}".format(
+                        real_scope, quantity.ctype, name, cached_types[name]
+                    )
+                )
+            for outputscope in [real_scope, self.global_scope]:
+                for leaf in quantity.get_leaves_of_scope(outputscope):
+                    leaves[leaf] = (name, ctype)
+        return leaves
+
+    def get_output_types(
+        self, scope: str, outputset: List[str]
+    ) -> Optional[List[str]]:
+        """
+        Get the C++ types of the output columns of a scope. A declared type of a quantity takes precedence over
+        the type from the type cache. The shifted versions of a quantity have the type of the nominal quantity.
+
+        Args:
+            scope: the scope
+            outputset: the sorted list of output columns of the scope
+
+        Returns:
+            list of the types in the order of the output columns, or None if the type of at least one quantity is unknown
+        """
+        leaf_types = {
+            leaf: ctype for leaf, (_, ctype) in self.get_leaf_quantities(scope).items()
+        }
+        untyped = sorted(set(leaf for leaf in outputset if leaf_types.get(leaf) is None))
+        if len(untyped) > 0:
+            log.info(
+                "Scope {}: {} outputs without known type, falling back to a jitted Snapshot".format(
+                    scope, len(untyped)
+                )
+            )
+            log.debug("Untyped outputs: {}".format(untyped))
+            return None
+        return [leaf_types[leaf] for leaf in outputset]  # type: ignore
+
+    def _last_df(self, scope: str) -> str:
+        """
+        Get the name of the last dataframe of a scope. If no producer was added to the scope,
+        the last dataframe of the global scope is returned.
+        """
+        if self.main_counter[scope] > 0:
+            return f"df{self.main_counter[scope]}_{scope}"
+        if scope == self.global_scope:
+            return self.input_dataframe
+        return self._last_df(self.get_parent_scope(scope))
+
+    def get_parent_scope(self, scope: str) -> str:
+        """
+        Get the scope a scope branches from, which is the global scope for all other scopes.
+        """
+        return self.get_global_scope_of(scope)
+
+    def set_type_probe(self) -> str:
+        """
+        Generate the type probe of the executable. If the environment variable CROWN_TYPE_PROBE is set,
+        the executable writes the C++ types of all output quantities per scope as json to the given path and
+        exits before the event loop. The resulting file can be used as type cache by the code generation of the
+        analysis, so that typed Snapshot calls are generated for quantities without a declared type.
+
+        Returns:
+            str - the code to be added to the template
+        """
+        probe = "    if (const char *type_probe = std::getenv(\"CROWN_TYPE_PROBE\")) {\n"
+        probe += "        nlohmann::json quantity_types;\n"
+        for scope in self.scopes:
+            if len(self.outputs[scope]) == 0:
+                continue
+            dataframe = self._last_df(scope)
+            for name in sorted(self.get_output_quantities(scope).keys()):
+                probe += '        quantity_types["{scope}"]["{name}"] = {df}.GetColumnType("{name}");\n'.format(
+                    scope=self.get_real_scope(scope), name=name, df=dataframe
+                )
+        probe += "        std::ofstream(type_probe) << quantity_types.dump(4) << std::endl;\n"
+        probe += '        Logger::get("main")->info("Quantity types written to {}", type_probe);\n'
+        probe += "        return 0;\n"
+        probe += "    }\n"
+        return probe
+
+    def estimate_column_memory(self) -> int:
+        """
+        Estimate the memory of the cached values of all columns of the graph for a single slot of the event loop.
+        The size of output columns with a known type is derived from the type, all other columns are assumed to
+        have a default size.
+
+        Returns:
+            int - the estimated memory in bytes
+        """
+        nbytes = 0
+        ncolumns = 0
+        for outputset, outputtypes in self.snapshot_columns.values():
+            ncolumns += len(outputset)
+            for ctype in outputtypes or [None] * len(outputset):
+                nbytes += COLUMN_SIZES.get(ctype, COLUMN_SIZE_DEFAULT)  # type: ignore
+        nbytes += max(self.number_of_defines - ncolumns, 0) * COLUMN_SIZE_DEFAULT
+        return nbytes
+
+    def set_thread_count(self) -> str:
+        """
+        Generate the call to enable multithreading. The configured number of threads is the maximum, if a memory budget
+        is given at runtime via the environment variable CROWN_MEMORY_BUDGET, the number of threads is reduced to fit
+        into the budget, see utility::memory::ThreadsForBudget.
+
+        Returns:
+            str - the code to be added to the template
+        """
+        output_branches = sum(
+            len(outputset) for outputset, _ in self.snapshot_columns.values()
+        )
+        threadcall = "// use the largest number of threads fitting into the memory budget\n"
+        threadcall += "    const unsigned int nthreads = utility::memory::ThreadsForBudget(\n"
+        threadcall += '        {threads}, input_files, "Events", {{"{inputs}"}}, {outputs}, {columns});\n'.format(
+            threads=self.threads,
+            inputs='", "'.join(sorted(self.input_branches)),
+            outputs=output_branches,
+            columns=self.estimate_column_memory(),
+        )
+        threadcall += "    if (nthreads > 1)\n"
+        threadcall += "        ROOT::EnableImplicitMT(nthreads);"
+        return threadcall
+
     def set_debug_flag(self) -> str:
         """
         Set the debug flag in the template if the debug variable is set to true
@@ -509,7 +1698,7 @@ class CodeGenerator(object):
             shifts += '{{ {outputname}, {{"'.format(
                 outputname=self._outputfiles_generated[scope]
             )
-            shiftlist = list(self.configuration.shifts[scope])
+            shiftlist = list(self.get_shifts_of(scope))
             shiftlist.sort()
             shifts += '", "'.join(shiftlist)
             shifts += '"} },'
@@ -529,7 +1718,7 @@ class CodeGenerator(object):
             outputset = list(
                 set(
                     self.output_commands[scope]
-                    + self.output_commands[self.global_scope]
+                    + self.output_commands[self.get_global_scope_of(scope)]
                 )
             )
             # now split by __ and get a set of all the shifts
@@ -543,6 +1732,23 @@ class CodeGenerator(object):
         output_quantities = output_quantities[:-1] + "}"
         return output_quantities
 
+    def set_primary_datasets(self) -> str:
+        """
+        Set the mapping of the data samples to their primary dataset in the template, used to
+        determine the primary dataset of the input files at runtime
+
+        Returns:
+            str: the mapping as initializer of a std::map
+        """
+        return (
+            "{"
+            + ", ".join(
+                '{{"{}", "{}"}}'.format(nick, dataset)
+                for nick, dataset in sorted(self.primary_datasets.items())
+            )
+            + "}"
+        )
+
     def set_thead_flag(self, threads: int) -> None:
         """
         Set the multithreading flag in the template if the number of threads is greater than 1.
@@ -585,7 +1791,7 @@ class CodeGenerator(object):
             scope=scope
         )
         tracking += (
-            "\n        std::lock_guard<std::mutex> lg({scope}_bar_mutex);\n".format(
+            "\n        static const LockProfiler::Site progress_site(\"progress_bar\");\n        LockProfiler::Guard<std::mutex> lg({scope}_bar_mutex, progress_site);\n".format(
                 scope=scope
             )
         )
@@ -598,3 +1804,254 @@ class CodeGenerator(object):
         )
         tracking += "    });\n"
         return tracking
+
+
+class MultiConfigCodeGenerator(CodeGenerator):
+    """
+    Class used to generate a single executable from several configurations, that are run over the same input files.
+    All configurations share the same input dataframe, so the input files are only read once. The producers at the
+    beginning of the global scope, that are identical in all configurations, are only generated once and are shared
+    by all configurations. Starting from the first producer, that differs between the configurations, each configuration
+    continues its global scope in a separate branch. All other scopes are generated separately for each configuration
+    and are written to separate output files. The name of a scope within the executable is given by the tag of the
+    configuration followed by the scope name, e.g. ``vhmm_config_m2m``.
+
+    Args:
+        main_template_path: the path to the cxx template for the executable
+        sub_template_path: the path to the cxx template for the code subsets
+        configurations: dictionary of the configurations to generate code from, the keys are used as tags
+        analysis_name: the name of the analysis
+        executable_name: the name of the executable
+        output_folder: the folder to write the code to
+
+    Returns:
+        None
+    """
+
+    def __init__(
+        self,
+        main_template_path: str,
+        sub_template_path: str,
+        configurations: Dict[str, Configuration],
+        analysis_name: str,
+        executable_name: str,
+        output_folder: str,
+        threads: int = 1,
+        quantity_types: Optional[Dict[str, Dict[str, str]]] = None,
+        quantity_ranges: Optional[Dict[str, List[int]]] = None,
+    ):
+        if len(configurations) == 0:
+            raise Exception("No configuration provided for the code generation")
+        first_configuration = list(configurations.values())[0]
+        for tag, configuration in configurations.items():
+            if (
+                configuration.era != first_configuration.era
+                or configuration.sample != first_configuration.sample
+            ):
+                log.error(
+                    "Configuration {} uses era {} and sample {}, but {} and {} are required".format(
+                        tag,
+                        configuration.era,
+                        configuration.sample,
+                        first_configuration.era,
+                        first_configuration.sample,
+                    )
+                )
+                raise Exception(
+                    "All configurations must be set up for the same era and sample"
+                )
+            if configuration.varied_shifts != first_configuration.varied_shifts:
+                log.error(
+                    "Configuration {} uses different shifts expressed as Vary than the first configuration".format(
+                        tag
+                    )
+                )
+                raise Exception(
+                    "All configurations must use the same shifts expressed as Vary, since they share the input dataframe"
+                )
+        super().__init__(
+            main_template_path=main_template_path,
+            sub_template_path=sub_template_path,
+            configuration=first_configuration,
+            analysis_name=analysis_name,
+            executable_name=executable_name,
+            output_folder=output_folder,
+            threads=threads,
+            quantity_types=quantity_types,
+            quantity_ranges=quantity_ranges,
+        )
+        self.configurations = configurations
+        self.shared_producers: List[str] = []
+        # mapping of the scopes of the executable to the tag and the scope within the configuration
+        self.scope_map: Dict[str, Tuple[str, str]] = {}
+        self.scopes = [self.global_scope]
+        self.outputs = {self.global_scope: set()}
+        for tag, configuration in self.configurations.items():
+            for scope in configuration.scopes:
+                label = "{}_{}".format(tag, scope)
+                self.scope_map[label] = (tag, scope)
+                self.scopes.append(label)
+                self.outputs[label] = configuration.outputs[scope]
+        for scope in self.scopes:
+            self.main_counter[scope] = 0
+            self.subset_calls[scope] = []
+            self.output_commands[scope] = []
+
+    def is_global_scope(self, scope: str) -> bool:
+        if scope == self.global_scope:
+            return True
+        return self.get_real_scope(scope) == self.global_scope
+
+    def get_pruned_columns(self) -> Tuple[int, int, int]:
+        columns, nbytes, calls = 0, 0, 0
+        for configuration in self.configurations.values():
+            pruned = count_pruned_columns(configuration, self.quantity_types)
+            columns += pruned[0]
+            nbytes += pruned[1]
+            calls += configuration.pruning_calls_saved
+        return columns, nbytes, calls
+
+    def get_global_scope_of(self, scope: str) -> str:
+        if scope == self.global_scope:
+            return self.global_scope
+        return "{}_{}".format(self.scope_map[scope][0], self.global_scope)
+
+    def get_real_scope(self, scope: str) -> str:
+        if scope == self.global_scope:
+            return self.global_scope
+        return self.scope_map[scope][1]
+
+    def get_shifts_of(self, scope: str) -> Dict[str, Any]:
+        tag, real_scope = self.scope_map[scope]
+        return self.configurations[tag].shifts[real_scope]
+
+    def generate_code(self) -> None:
+        """
+        Generate the code from all configurations. First, the shared part of the global scope is determined and generated,
+        afterwards the remaining producers of all configurations are generated.
+
+        Args:
+            None
+
+        Returns:
+            None
+        """
+        self.check_build_options()
+        for subfolder in ["src", "include"]:
+            for scope in self.scopes:
+                if not os.path.exists(
+                    os.path.join(
+                        self.output_folder,
+                        self.executable_name + "_generated_code",
+                        subfolder,
+                        scope,
+                    )
+                ):
+                    os.makedirs(
+                        os.path.join(
+                            self.output_folder,
+                            self.executable_name + "_generated_code",
+                            subfolder,
+                            scope,
+                        )
+                    )
+        self.generate_global_subsets()
+        for scope in self.scopes:
+            if not self.is_global_scope(scope):
+                self.generate_subsets(scope)
+
+        self.write_unity_sources()
+        calls, includes = self.generate_main_code()
+        run_commands = self.generate_run_commands()
+
+        self.write_code(calls, includes, run_commands)
+        log.info(
+            "  Shared global producers: {} ({})".format(
+                len(self.shared_producers), ", ".join(self.shared_producers)
+            )
+        )
+        log.info("------------------------------------")
+
+    def _create_subset(self, tag: str, scope: str, producer) -> CodeSubset:
+        subset = CodeSubset(
+            file_name=producer.name,
+            template=self.subset_template,
+            producer=producer,
+            scope=scope,
+            folder=os.path.join(
+                self.output_folder, self.executable_name + "_generated_code"
+            ),
+            configuration_parameters=self.configurations[tag].config_parameters[
+                scope
+            ],
+            tag=tag,
+        )
+        subset.create()
+        self.add_input_branches(producer, scope)
+        return subset
+
+    def _add_subset_call(self, scope: str, subset: CodeSubset, inputdf: str) -> None:
+        subset.write(source=self.unity_build == 0)
+        self.subsets.append(subset)
+        self.number_of_defines += subset.count
+        self.subset_calls[scope].append(
+            subset.call(
+                inputscope=inputdf,
+                outputscope=f"df{self.main_counter[scope]+1}_{scope}",
+            )
+        )
+        self.subset_includes.append(subset.include())
+        self.main_counter[scope] += 1
+
+    def get_parent_scope(self, scope: str) -> str:
+        # the global scope of each configuration branches from the shared global scope
+        if self.is_global_scope(scope):
+            return self.global_scope
+        return self.get_global_scope_of(scope)
+
+    def generate_global_subsets(self) -> None:
+        """
+        Generate the subsets of the global scopes of all configurations. As long as the producers of all configurations
+        are identical, a single shared subset is generated, afterwards a separate branch is generated for each configuration.
+
+        Args:
+            None
+
+        Returns:
+            None
+        """
+        subsets: Dict[str, List[CodeSubset]] = {}
+        for tag, configuration in self.configurations.items():
+            subsets[tag] = [
+                self._create_subset(tag, self.global_scope, producer)
+                for producer in configuration.producers[self.global_scope]
+            ]
+        first_tag = list(self.configurations.keys())[0]
+        n_shared = shared_prefix(
+            subsets, lambda subset: (subset.producer.name, subset.commands)
+        )
+        log.debug("{} global producers are shared".format(n_shared))
+        for subset in subsets[first_tag][:n_shared]:
+            subset.tag = ""
+            self.shared_producers.append(subset.producer.name)
+            self._add_subset_call(
+                self.global_scope, subset, self._last_df(self.global_scope)
+            )
+        for tag in subsets:
+            scope = "{}_{}".format(tag, self.global_scope)
+            for subset in subsets[tag][n_shared:]:
+                self._add_subset_call(scope, subset, self._last_df(scope))
+
+    def generate_subsets(self, scope: str) -> None:
+        """
+        Generate the subsets for the given scope of the executable
+        Args:
+            scope: the scope to generate the subsets for
+        Returns:
+            None
+        """
+        tag, real_scope = self.scope_map[scope]
+        log.debug("Generating subsets for {} in scope {}".format(tag, real_scope))
+        for producer in self.configurations[tag].producers[real_scope]:
+            subset = self._create_subset(tag, real_scope, producer)
+            self._add_subset_call(scope, subset, self._last_df(scope))
@@ -13,7 +13,11 @@ from code_generation.exceptions import (
     InvalidShiftError,
 )
 from code_generation.modifiers import EraModifier, SampleModifier
-from code_generation.optimizer import ProducerOrdering
+from code_generation.optimizer import (
+    OutputPruning,
+    PreselectionPushdown,
+    ProducerOrdering,
+)
 from code_generation.producer import (
     ProducerGroup,
     CollectProducersOutput,
@@ -24,6 +28,7 @@ from code_generation.quantity import (
     NanoAODQuantity,
     QuantitiesInput,
     QuantitiesStore,
+    Quantity,
     QuantityGroup,
 )
 from code_generation.rules import ProducerRule, RemoveProducer
@@ -51,8 +56,22 @@ class Configuration(object):
     Configuration class for for the CROWN configuration. This class
     holds all parts of the configuration, from the sample, era, scope,
     and systematics, to the output. All modifications to the configuration should be done through this class.
+
+    The systematics backend is set per configuration. With the default ``duplicate`` backend, every shift is
+    implemented by duplicating all affected producers with shifted inputs and outputs. With the ``vary`` backend,
+    shifts of the global scope, that only replace NanoAOD input columns by other NanoAOD input columns
+    (SystematicShiftByQuantity), are instead expressed as RDataFrame ``Vary`` of the source columns, so all producers
+    only run once. All other shifts use the duplicate backend.
+
+    If a usage manifest is set via the class attribute ``usage_manifest``, the outputs not read by the downstream
+    jobs and the producers only needed for them are removed during the optimization (see OutputPruning).
     """
 
+    # push the leading filters of all scopes into the global scope
+    preselection_pushdown: bool = True
+    # branch name patterns read by the downstream jobs for each scope, used to remove unused outputs
+    usage_manifest: Dict[str, List[str]] = {}
+
     def __init__(
         self,
         era: str,
@@ -62,6 +81,7 @@ class Configuration(object):
         available_sample_types: Union[str, List[str]],
         available_eras: Union[str, List[str]],
         available_scopes: Union[str, List[str]],
+        systematics_backend: str = "duplicate",
     ):
         """
 
@@ -77,6 +97,7 @@ class Configuration(object):
             available_sample_types: The available sample types.
             available_eras: The available eras.
             available_scopes: The available scopes.
+            systematics_backend: The backend used for the systematic shifts, either ``duplicate`` or ``vary``.
 
         """
         self.era = era
@@ -89,14 +110,28 @@ class Configuration(object):
         self.available_outputs: QuantitiesStore = {}
         self.available_shifts: Dict[str, Set[str]] = {}
         self.global_scope = "global"
+        if systematics_backend not in ["duplicate", "vary"]:
+            raise ValueError(
+                "Unknown systematics backend {}, use duplicate or vary".format(
+                    systematics_backend
+                )
+            )
+        self.systematics_backend = systematics_backend
 
         self.producers: TProducerStore = {}
         self.unpacked_producers: TProducerStore = {}
         self.scopes: List[str] = []
         self.outputs: QuantitiesStore = {}
         self.shifts: Dict[str, Dict[str, TConfiguration]] = {}
+        # shifts expressed as Vary of the source columns, mapping the quantities to their shifted columns
+        self.varied_shifts: Dict[str, Dict[str, str]] = {}
         self.rules: Set[ProducerRule] = set()
         self.config_parameters: Dict[str, TConfiguration] = {}
+        # outputs and producers removed, since they are not used according to the usage manifest
+        self.pruned_outputs: Dict[str, List[Quantity]] = {}
+        self.pruned_producers: Dict[str, List[str]] = {}
+        self.pruning_calls_saved: int = 0
+        self.pruning_total_calls: int = 0
 
         self.setup_defaults()
 
@@ -338,17 +373,34 @@ class Configuration(object):
                 scopes_to_shift = [
                     scope for scope in shift.get_scopes() if scope in self.scopes
                 ]
-                if self.global_scope in scopes_to_shift:
+                if (
+                    self.systematics_backend == "vary"
+                    and self._is_input_shift(shift)
+                    and self.global_scope in scopes_to_shift
+                ):
+                    # the shift is not applied to the quantities, so no producer is duplicated
+                    log.debug("Shift {} is expressed as Vary".format(shift.shiftname))
+                    self.varied_shifts[shift.shiftname] = {
+                        quantity.name: str(external)
+                        for quantity, external in shift.quantity_change.items()
+                    }
+                    for scope in self.scopes:
+                        self._add_available_shift(shift, scope)
+                        self.shifts[scope][shift.shiftname] = {}
+                elif self.global_scope in scopes_to_shift:
+                    # the global part of the shift is applied only once, the
+                    # shifted global quantities are propagated to all scopes
+                    shift.apply(self.global_scope)
                     for scope in self.scopes:
                         if scope in shift.get_scopes():
                             self._add_available_shift(shift, scope)
-                            shift.apply(scope)
+                            if scope != self.global_scope:
+                                shift.apply(scope)
                             self.shifts[scope][
                                 shift.shiftname
                             ] = shift.get_shift_config(scope)
                         else:
                             self._add_available_shift(shift, scope)
-                            shift.apply(self.global_scope)
                             self.shifts[scope][
                                 shift.shiftname
                             ] = shift.get_shift_config(self.global_scope)
@@ -360,6 +412,31 @@ class Configuration(object):
                             scope
                         )
 
+    def _is_input_shift(
+        self, shift: Union[SystematicShift, SystematicShiftByQuantity]
+    ) -> bool:
+        """
+        Check if a shift only replaces NanoAOD input columns by other input columns. Only these shifts can be
+        expressed as Vary of the input dataframe, since the varied columns have to exist before the first producer.
+        Replacements given as plain column names are assumed to be NanoAOD columns.
+
+        Args:
+            shift: The shift to be checked.
+
+        Returns:
+            bool: True if the shift can be expressed as Vary
+        """
+        if not isinstance(shift, SystematicShiftByQuantity):
+            return False
+        for quantity, external in shift.quantity_change.items():
+            if not isinstance(quantity, NanoAODQuantity):
+                return False
+            if isinstance(external, Quantity) and not isinstance(
+                external, NanoAODQuantity
+            ):
+                return False
+        return True
+
     def _is_valid_shift(
         self, shift: Union[SystematicShift, SystematicShiftByQuantity]
     ) -> bool:
@@ -521,7 +598,10 @@ class Configuration(object):
 
             1. Remove empty scopes
             2. Apply rules
-            3. Optimizing producer ordering (this does not change the configuration, but only the order of producers)
+            3. Remove the outputs not used according to the usage manifest, and the producers only needed for them
+               (see OutputPruning)
+            4. Push the leading filters of all scopes into the global scope (see PreselectionPushdown)
+            5. Optimizing producer ordering (this does not change the configuration, but only the order of producers)
 
         Args:
             None
@@ -531,6 +611,28 @@ class Configuration(object):
         """
         self._apply_rules()
         self._remove_empty_scopes()
+        if len(self.usage_manifest) > 0:
+            pruning = OutputPruning(
+                producers=self.producers,
+                outputs=self.outputs,
+                global_scope=self.global_scope,
+                config_parameters=self.config_parameters,
+                manifest=self.usage_manifest,
+            )
+            pruning.Prune()
+            self.pruned_outputs = pruning.removed_outputs
+            self.pruned_producers = pruning.removed_producers
+            self.pruning_calls_saved = pruning.calls_saved
+            self.pruning_total_calls = pruning.total_calls
+        if self.preselection_pushdown and len(self.varied_shifts) == 0:
+            preselection = PreselectionPushdown(
+                producers=self.producers,
+                global_scope=self.global_scope,
+                config_parameters=self.config_parameters,
+                shifts=self.shifts,
+            ).Pushdown()
+            if preselection is not None:
+                self.producers[self.global_scope].append(preselection)
         for scope in self.scopes:
             log.debug("Optimizing Producer Ordering in scope {}".format(scope))
             ordering = ProducerOrdering(
@@ -644,7 +746,11 @@ class Configuration(object):
                         log.debug(
                             "Validating shift {} in scope {}".format(shift, scope)
                         )
-                        if not any(
+                        # exact matches are looked up in the set, the substring
+                        # search is only needed for the remaining shifts
+                        if shift.lower() not in self.available_shifts[
+                            scope
+                        ] and not any(
                             [
                                 shift.lower() in available_shift
                                 for available_shift in self.available_shifts[scope]
@@ -710,6 +816,23 @@ class Configuration(object):
         log.info("  Total number of shifts: {}".format(total_shifts))
         for scope in running_scopes:
             log.info("       {}: {}".format(scope, len(self.shifts[scope])))
+        if self.systematics_backend == "vary":
+            log.info(
+                "  Shifts expressed as Vary: {}".format(len(self.varied_shifts.keys()))
+            )
+        if len(self.pruned_outputs) > 0:
+            log.info(
+                "  Removed by the usage manifest: {} outputs, {} producers, saving {} of {} producer calls per event".format(
+                    sum(len(outputs) for outputs in self.pruned_outputs.values()),
+                    sum(len(producers) for producers in self.pruned_producers.values()),
+                    self.pruning_calls_saved,
+                    self.pruning_total_calls,
+                )
+            )
+            for scope, outputs in self.pruned_outputs.items():
+                log.info(
+                    "       {}: {}".format(scope, [output.name for output in outputs])
+                )
         log.info("------------------------------------")
 
     def __str__(self) -> str:
@@ -1,12 +1,52 @@
 from __future__ import annotations  # needed for type annotations in > python 3.7
-from code_generation.quantity import NanoAODQuantity, Quantity
-from code_generation.producer import Filter, BaseFilter, Producer, ProducerGroup
-from typing import Set, Tuple, Union, List
+from code_generation.quantity import NanoAODQuantity, Quantity, QuantityGroup
+from code_generation.producer import (
+    Filter,
+    BaseFilter,
+    ExtendedVectorProducer,
+    Producer,
+    ProducerGroup,
+    VectorProducer,
+)
+from fnmatch import fnmatchcase
+from typing import Any, Dict, Set, Tuple, Union, List
 import logging
+import re
 
 log = logging.getLogger(__name__)
 
 
+def count_calls(
+    producer: Producer | ProducerGroup,
+    scope: str,
+    config_parameters: Dict[str, Dict[str, Any]],
+) -> int:
+    """
+    Helper function to count the calls of a producer in a scope, including the calls of all
+    subproducers and shifted versions.
+
+    Args:
+        producer: The producer to count
+        scope: The scope of the producer
+        config_parameters: The configuration parameters of all scopes
+
+    Returns:
+        The number of calls
+    """
+    if isinstance(producer, ProducerGroup):
+        return sum(
+            count_calls(subproducer, scope, config_parameters)
+            for subproducer in producer.producers[scope]
+        )
+    versions = 1
+    if isinstance(producer, VectorProducer):
+        versions = len(config_parameters[scope][producer.vec_configs[0]])
+    shifts = 0
+    if producer.output is not None and len(producer.output) > 0:
+        shifts = len(producer.output[0].get_shifts(scope))
+    return versions * (1 + shifts)
+
+
 class ProducerOrdering:
     """
     Class used to check if the producer ordering is correct,
@@ -15,6 +55,10 @@ class ProducerOrdering:
     or as far up as possible. A wrong configuration due to missing inputs will also be caught here.
 
     If the scope is not global, the outputs generated by producers in the global scope are also considered.
+
+    The producers creating each quantity are indexed once, and the ordering is determined by a
+    depth-first topological sort, so the optimization scales linearly with the number of producers
+    and quantities.
     """
 
     def __init__(
@@ -39,55 +83,52 @@ class ProducerOrdering:
         self.optimized: bool = False
         self.optimized_ordering: List[Producer | ProducerGroup] = []
         self.global_outputs = self.get_global_outputs()
+        self.producers_of = self.index_outputs()
 
-    def get_position(self, producer: Producer | ProducerGroup) -> int:
+    def get_global_outputs(self) -> Set[Quantity]:
         """
-        Helper Function to get the position of a producer in the ordering list
+        Function used to generate a set of all outputs generated by the global scope.
 
         Args:
-            producer: The producer to get the position of
-
-        Returns:
-            The position of the producer in the current ordering
-        """
-        for i, prod in enumerate(self.ordering):
-            if prod == producer:
-                return i
-        raise Exception("Producer not in ordering")
-
-    def get_producer(self, position: int) -> Producer | ProducerGroup:
-        """
-        Helper function to get the producer at a given position
-
-        Args:
-            position: The position of the producer
+            None
 
         Returns:
-            The producer at the given position
+            A set of all outputs generated by the global scope
         """
-        return self.ordering[position]
+        outputs: Set[Quantity] = set()
+        if self.scope == "global":
+            return outputs
+        for producer in self.global_producers:
+            if producer.get_outputs("global") is not None:
+                outputs.update(
+                    quantity
+                    for quantity in producer.get_outputs("global")
+                    if not isinstance(quantity, NanoAODQuantity)
+                )
+        return outputs
 
-    def get_global_outputs(self) -> List[Quantity]:
+    def index_outputs(self) -> Dict[Quantity, List[Producer | ProducerGroup]]:
         """
-        Function used to generate a list of all outputs generated by the global scope.
+        Function used to build an index of the producers creating each quantity in the scope.
 
         Args:
             None
 
         Returns:
-            A list of all outputs generated by the global scope
+            A dictionary mapping each quantity to the producers creating it
         """
-        outputs: List[Quantity] = []
-        for producer in self.global_producers:
-            if producer.get_outputs("global") is not None:
-                outputs.extend(
-                    [
-                        quantity
-                        for quantity in producer.get_outputs("global")
-                        if not isinstance(quantity, NanoAODQuantity)
-                    ]
-                )
-        return outputs
+        producers_of: Dict[Quantity, List[Producer | ProducerGroup]] = {}
+        for producer in self.ordering:
+            outputs = producer.get_outputs(self.scope)
+            if outputs is None:
+                continue
+            for quantity in outputs:
+                if isinstance(quantity, NanoAODQuantity):
+                    continue
+                producers_of.setdefault(quantity, [])
+                if producer not in producers_of[quantity]:
+                    producers_of[quantity].append(producer)
+        return producers_of
 
     def MoveFiltersUp(self) -> None:
         """
@@ -99,18 +140,58 @@ class ProducerOrdering:
         Returns:
             None
         """
-        new_ordering: List[Producer | ProducerGroup] = []
+        filters: List[Producer | ProducerGroup] = []
+        others: List[Producer | ProducerGroup] = []
         for producer in self.ordering:
             if isinstance(producer, Filter) or isinstance(producer, BaseFilter):
-                new_ordering.insert(0, producer)
+                filters.append(producer)
             else:
-                new_ordering.append(producer)
+                others.append(producer)
+        # filters are inserted at the top one after the other, so their order is reversed
+        new_ordering = filters[::-1] + others
         for i, prod in enumerate(self.ordering):
             log.debug(" --> {}. : {}".format(i, prod))
         for i, prod in enumerate(new_ordering):
             log.debug(" --> {}. : {}".format(i, prod))
         self.ordering = new_ordering
 
+    def dependencies(
+        self, producer: Producer | ProducerGroup
+    ) -> List[Producer | ProducerGroup]:
+        """
+        Function used to locate the producers responsible for creating the inputs of a producer.
+        Inputs created by the global scope and NanoAOD quantities do not need a producer.
+        If a needed input is not found, the function raise an Exception.
+
+        Args:
+            producer: The producer to check
+
+        Returns:
+            A list of producers, that have to be run before the given producer
+        """
+        dependencies: List[Producer | ProducerGroup] = []
+        for quantity in producer.get_inputs(self.scope):
+            if isinstance(quantity, NanoAODQuantity):
+                continue
+            if quantity in self.producers_of:
+                for dependency in self.producers_of[quantity]:
+                    # ProducerGroups consume the outputs of their own subproducers
+                    if dependency is not producer and dependency not in dependencies:
+                        dependencies.append(dependency)
+            elif quantity not in self.global_outputs:
+                producers_requiring_input = ""
+                for other in self.ordering:
+                    if quantity in other.get_inputs(self.scope):
+                        producers_requiring_input += "    " + str(other) + "\n"
+                log.error(
+                    "{} was not found in any producer output by is required by: \n{}".format(
+                        quantity, producers_requiring_input
+                    )
+                )
+                log.error("Please check if all needed producers are activated !")
+                raise Exception
+        return dependencies
+
     def Optimize(self) -> None:
         """
         The main function of this class. During the optimization,
@@ -118,21 +199,13 @@ class ProducerOrdering:
 
         1. Bring all filters to the beginning of the ordering.
 
-        2. Check if the ordering is already correct. The ordering is correct,
-           if, for all producers in the ordering, all inputs can be found in
-           the outputs of preceding producers. If the scope is not global,
-           all outputs from producers in the global scope are also considered.
-
-        3. If the ordering is correct, return.
-
-        4. If the ordering is not correct,
-
-            1. find all inputs, that have to be produced before the wrong producer
-            2. put one producer, which is responsible for creating the input, in front of the wrong producer
-            3. repeat from step 2
+        2. Go through the ordering and add each producer to the optimized ordering,
+           after all producers creating its inputs were added (depth-first). If the scope
+           is not global, all outputs from producers in the global scope are considered
+           to be available. Producers are only moved, if one of their outputs is needed
+           by a preceding producer, so filters end up as far up as possible.
 
-        The sorting algorithm should take at most ``2*(number of producers)`` steps.
-        If this limit is reached, the optimization is
+        If the producers depend on each other in a cycle, the optimization is
         considered to be failed and an Exception is raised.
         If a missing input cant be found in all outputs,
         the Optimize function will raise an Exception.
@@ -145,183 +218,471 @@ class ProducerOrdering:
         """
         # first bring filters to the top
         self.MoveFiltersUp()
-        # run optimization in a while loop
-        counter = 0
-        while not self.optimized:
-            if counter > 2 * self.size + 1:
-                log.error("Could not optimize ordering")
-                log.error("Please check, if all needed producers are activated")
-                raise Exception
-            wrongProducer, wrong_inputs = self.check_ordering()
-            if wrongProducer is not None:
-                producers_to_relocate = self.find_inputs(wrongProducer, wrong_inputs)
-                # if len(producers_to_relocate) == 0:
-                #     self.optimized = True
-                #     break
-                # else:
-                for producer_to_relocate in producers_to_relocate:
-                    counter += 1
-                    self.relocate_producer(
-                        producer_to_relocate,
-                        self.get_position(producer_to_relocate),
-                        self.get_position(wrongProducer),
-                    )
+        ordered: List[Producer | ProducerGroup] = []
+        done: Set[Producer | ProducerGroup] = set()
+        visiting: Set[Producer | ProducerGroup] = set()
+        for root in self.ordering:
+            if root in done:
+                continue
+            # iterative depth-first search, the dependency chains can be longer than the recursion limit
+            stack = [(root, iter(self.dependencies(root)))]
+            visiting.add(root)
+            while len(stack) > 0:
+                producer, dependencies = stack[-1]
+                for dependency in dependencies:
+                    if dependency in done:
+                        continue
+                    if dependency in visiting:
+                        log.error("Could not optimize ordering")
+                        log.error(
+                            "{} and {} depend on each other".format(
+                                producer, dependency
+                            )
+                        )
+                        raise Exception
+                    visiting.add(dependency)
+                    stack.append((dependency, iter(self.dependencies(dependency))))
+                    break
+                else:
+                    stack.pop()
+                    visiting.discard(producer)
+                    done.add(producer)
+                    ordered.append(producer)
+        moved = sum(
+            1
+            for position, producer in enumerate(ordered)
+            if self.ordering[position] is not producer
+        )
+        self.ordering = ordered
+        self.optimized = True
         self.optimized_ordering = self.ordering
         log.info(
-            "Optimization for scope {} done after {} steps: {}".format(
-                self.scope, counter, self.optimized_ordering
+            "Optimization for scope {} done, {} producers moved: {}".format(
+                self.scope, moved, self.optimized_ordering
             )
         )
 
-    def check_ordering(
+
+class PreselectionPushdown:
+    """
+    Class used to push the leading filters of all scopes into the global scope.
+    The pushed down filter rejects events, that no scope can accept, before they reach
+    the scopes, and adds an entry to the cutflow reports, showing how many events are
+    rejected by all scopes. Since the columns are evaluated lazily, the global producers
+    were already only evaluated for events reaching the scopes, so the filter is an
+    early rejection and bookkeeping aid, and not expected to save producer calls.
+
+    For each scope, the threshold filters (``basefunctions::FilterThreshold``) which only depend
+    on outputs of the global scope or NanoAOD quantities are collected. The OR of the AND of these
+    filters of each scope is added to the global scope as a single filter, which is then
+    placed by the ProducerOrdering directly after the producers of its inputs.
+
+    The derived filter is conservative, an event is only rejected if no scope can accept it:
+
+        - if a scope has no such filter, it accepts all events and no filter is pushed down
+        - filters on quantities with shifts, or with thresholds changed by a shift, are ignored
+        - if shifts are expressed as Vary, no filter is pushed down
+
+    The filters remain in their scopes, so the outputs are unchanged.
+    """
+
+    filtername = "Cross-scope preselection"
+    threshold_call = re.compile(
+        r'^basefunctions::FilterThreshold\(\{df\},\s*\{input\},\s*(?P<threshold>[^,]+),\s*"(?P<relation>[^"]+)",'
+    )
+
+    def __init__(
         self,
-    ) -> Tuple[Union[Producer, ProducerGroup, None], List[Quantity]]:
+        producers: Dict[str, List[Producer | ProducerGroup]],
+        global_scope: str,
+        config_parameters: Dict[str, Dict[str, Any]],
+        shifts: Dict[str, Dict[str, Dict[str, Any]]],
+    ):
+        """
+        Init function
+
+        Args:
+            producers: The producers of all scopes
+            global_scope: The name of the global scope
+            config_parameters: The configuration parameters of all scopes
+            shifts: The configuration changes of the shifts of all scopes
+        """
+        self.producers = producers
+        self.global_scope = global_scope
+        self.config_parameters = config_parameters
+        self.shifts = shifts
+        self.global_outputs: Set[Quantity] = set()
+        for producer in self.producers[self.global_scope]:
+            self.global_outputs.update(producer.get_outputs(self.global_scope))
+        self.expression: Union[str, None] = None
+        self.inputs: List[Quantity] = []
+
+    def threshold_expression(
+        self, producer: Producer | ProducerGroup, scope: str
+    ) -> Union[str, None]:
+        """
+        Function used to convert a threshold filter of a scope into a boolean expression,
+        that can be evaluated in the global scope.
+
+        Args:
+            producer: The producer to convert
+            scope: The scope of the producer
+
+        Returns:
+            The expression, or None if the producer is not a threshold filter on a global quantity
+        """
+        if not isinstance(producer, Producer) or producer.output is not None:
+            return None
+        match = self.threshold_call.match(producer.call)
+        if match is None or len(producer.input[scope]) != 1:
+            return None
+        quantity = producer.input[scope][0]
+        if not isinstance(quantity, NanoAODQuantity) and (
+            quantity not in self.global_outputs
+        ):
+            return None
+        if (
+            len(quantity.get_shifts(scope)) > 0
+            or len(quantity.get_shifts(self.global_scope)) > 0
+        ):
+            log.debug(
+                "{} is not pushed down, {} has shifts".format(producer, quantity.name)
+            )
+            return None
+        threshold = match.group("threshold")
+        parameters = re.findall(r"\{(\w+)\}", threshold)
+        for shift in self.shifts[scope].values():
+            if any(parameter in shift for parameter in parameters):
+                log.debug(
+                    "{} is not pushed down, the threshold is shifted".format(producer)
+                )
+                return None
+        try:
+            threshold = threshold.format(**self.config_parameters[scope])
+        except KeyError:
+            return None
+        self.inputs.append(quantity)
+        return "{} {} {}".format(
+            quantity.get_leaf("nominal", self.global_scope),
+            match.group("relation"),
+            threshold,
+        )
+
+    def Pushdown(self) -> Union[BaseFilter, None]:
         """
-        Function used to check the ordering.
-        If at least of one the inputs of a producer cannot be found in
-        the list of all preceding outputs, the ordering is not correct.
-        If the whole odering is correct, the optimized flag is set to
-        true and the ordering is considered to be correct.
+        The main function of this class. The leading filters of all scopes are collected
+        and combined into a single filter for the global scope.
 
         Args:
             None
 
         Returns:
-            A tuple of the wrong producer and a list of the inputs
-            that are not found in the outputs
-        """
-        outputs = []
-        if self.scope != "global":
-            outputs = self.global_outputs
-        for producer_to_check in self.ordering:
-            temp_outputs = producer_to_check.get_outputs(self.scope)
-            if temp_outputs is not None:
-                outputs.extend(
-                    [
-                        quantity
-                        for quantity in temp_outputs
-                        if not isinstance(quantity, NanoAODQuantity)
-                    ]
+            The filter for the global scope, or None if no filter can be derived
+        """
+        scopes = [scope for scope in self.producers if scope != self.global_scope]
+        if len(scopes) == 0:
+            return None
+        terms: List[str] = []
+        for scope in scopes:
+            expressions: List[str] = []
+            for producer in self.producers[scope]:
+                expression = self.threshold_expression(producer, scope)
+                if expression is not None and expression not in expressions:
+                    expressions.append(expression)
+            if len(expressions) == 0:
+                log.info(
+                    "No preselection pushdown, scope {} has no leading filter on global quantities".format(
+                        scope
+                    )
                 )
-            inputs = [
-                quantity
-                for quantity in producer_to_check.get_inputs(self.scope)
-                if not isinstance(quantity, NanoAODQuantity)
-            ]
-            invalid_inputs = self.invalid_inputs(inputs, outputs)
-            if len(invalid_inputs) > 0:
-                return producer_to_check, invalid_inputs
-        self.optimized = True
-        return None, []
+                return None
+            term = "({})".format(" && ".join(expressions))
+            if term not in terms:
+                terms.append(term)
+        self.expression = " || ".join(terms)
+        self.inputs = list(dict.fromkeys(self.inputs))
+        log.info("Preselection pushed down into global scope: {}".format(self.expression))
+        return BaseFilter(
+            name="CrossScopePreselection",
+            call='basefunctions::FilterExpression({{df}}, "{}", "{}")'.format(
+                self.expression, self.filtername
+            ),
+            input=self.inputs,
+            scopes=[self.global_scope],
+        )
 
-    def invalid_inputs(
-        self, inputs: List[Quantity], outputs: List[Quantity]
-    ) -> List[Quantity]:
+
+class OutputPruning:
+    """
+    Class used to remove the outputs, that are not read by the downstream jobs, together with
+    all producers, that are only needed to create them.
+
+    The usage manifest contains a list of branch name patterns (``fnmatch`` syntax) for each scope.
+    An output quantity of a scope in the manifest is kept, if its name matches one of the patterns.
+    Shifted branches are matched via their nominal quantity, so a pattern or recorded branch
+    ``pt_1__MuonIDUp`` keeps ``pt_1`` with all of its shifts. Scopes not listed in the manifest are
+    not pruned. The outputs of the global scope are written to every scope, so they are only removed
+    if all scopes are listed in the manifest and none of them uses them.
+
+    Starting from the kept outputs, the producers creating them and, transitively, the producers
+    creating their inputs are kept, all other producers are removed. The pruning is conservative:
+
+        - filters are always kept, since they change the event selection
+        - producers without outputs, or redefining NanoAOD quantities, are always kept
+        - the event identifiers (run, lumi, event) are always kept, they are needed for the event index
+        - quantity groups are kept as a whole, if any of their members is used
+        - producer groups with their own call are kept or removed as a whole, other producer groups
+          are replaced by their remaining subproducers
+    """
+
+    always_kept = {"run", "lumi", "event"}
+
+    def __init__(
+        self,
+        producers: Dict[str, List[Producer | ProducerGroup]],
+        outputs: Dict[str, Set[Quantity]],
+        global_scope: str,
+        config_parameters: Dict[str, Dict[str, Any]],
+        manifest: Dict[str, List[str]],
+    ):
         """
-        Helper function used to check, if for a list of inputs, a match in a list of outputs can be found.
+        Init function
 
         Args:
-            inputs: The list of quantity inputs to check
-            outputs: The list of quantity outputs to check
+            producers: The producers of all scopes
+            outputs: The output quantities of all scopes
+            global_scope: The name of the global scope
+            config_parameters: The configuration parameters of all scopes
+            manifest: The branch name patterns read downstream, for each scope
+        """
+        self.producers = producers
+        self.outputs = outputs
+        self.global_scope = global_scope
+        self.config_parameters = config_parameters
+        # the shift suffix is removed, so the patterns match the nominal name of the quantities
+        self.patterns: Dict[str, Set[str]] = {
+            scope: set(pattern.split("__")[0] for pattern in patterns)
+            for scope, patterns in manifest.items()
+            if scope in self.producers and scope != global_scope
+        }
+        for scope in manifest:
+            if scope not in self.patterns:
+                log.warning(
+                    "Scope {} of the usage manifest is not part of the configuration".format(
+                        scope
+                    )
+                )
+        # the members of quantity groups are only added during the code generation, so their names are
+        # derived from the configuration of the extended vector producers
+        self.group_members: Dict[Quantity, List[str]] = {}
+        for scope in self.producers:
+            for producer in self.producers[scope]:
+                for leaf in self.leaves(producer, scope):
+                    if not isinstance(leaf, ExtendedVectorProducer):
+                        continue
+                    try:
+                        self.group_members[leaf.output_group] = [
+                            leaf.get_output_name(entry)
+                            for entry in config_parameters[scope][leaf.vec_config]
+                        ]
+                    except (KeyError, TypeError):
+                        continue
+        self.removed_outputs: Dict[str, List[Quantity]] = {}
+        self.removed_producers: Dict[str, List[str]] = {}
+        self.calls_saved = 0
+        self.total_calls = 0
+
+    def used(self, quantity: Quantity, scopes: List[str]) -> bool:
+        """
+        Function used to check if an output quantity is read downstream in any of the given scopes.
+
+        Args:
+            quantity: The output quantity
+            scopes: The scopes the quantity is written to
+
+        Returns:
+            True if the quantity has to be kept
+        """
+        if quantity.name in self.always_kept:
+            return True
+        if isinstance(quantity, QuantityGroup) and quantity not in self.group_members:
+            return True
+        return any(
+            fnmatchcase(name, pattern)
+            for name in self.names(quantity)
+            for scope in scopes
+            for pattern in self.patterns[scope]
+        )
+
+    def names(self, quantity: Quantity) -> List[str]:
+        """
+        Function used to get the names of the branches written for a quantity, these are the names of the
+        members for quantity groups.
+
+        Args:
+            quantity: The output quantity
 
         Returns:
-            wrong_inputs: A list of inputs, that are not in the outputs list
+            The nominal branch names
         """
-        wrong_inputs: List[Quantity] = []
-        for input in inputs:
-            if input not in outputs:
-                wrong_inputs.append(input)
-                log.debug("Input {} not in outputs".format(input))
-        return wrong_inputs
+        if isinstance(quantity, QuantityGroup):
+            return self.group_members.get(quantity, [])
+        return [quantity.name]
 
-    def find_inputs(
-        self, producer: Producer | ProducerGroup, inputs: List[Quantity]
+    def leaves(
+        self, producer: Producer | ProducerGroup, scope: str
     ) -> List[Producer | ProducerGroup]:
         """
-        Function used to locate the producers responsible for creating the given inputs.
-        The function return a list of producers, that have to be run before the tested producer.
-        If a needed input is not found, the function raise an Exception.
+        Function used to resolve a producer into the smallest units, that can be removed separately.
+
+        Args:
+            producer: The producer to resolve
+            scope: The scope of the producer
+
+        Returns:
+            The list of separately removable producers
+        """
+        if (
+            isinstance(producer, ProducerGroup)
+            and not isinstance(producer, Filter)
+            and producer.call is None
+        ):
+            leaves: List[Producer | ProducerGroup] = []
+            for subproducer in producer.producers[scope]:
+                leaves.extend(self.leaves(subproducer, scope))
+            return leaves
+        return [producer]
+
+    def required(self, producer: Producer | ProducerGroup, scope: str) -> bool:
+        """
+        Function used to check if a producer has to be kept, regardless of its outputs.
 
         Args:
             producer: The producer to check
-            inputs: The list of inputs to check
+            scope: The scope of the producer
 
         Returns:
-            producers_to_relocate: A list of producers, that have to be run before the given producer
-        """
-        producers_to_relocate: Set[Producer | ProducerGroup] = set()
-        log.debug("Trying to find inputs {}".format(inputs))
-        for input in inputs:
-            found = False
-            for producer in self.ordering:
-                if input in producer.get_outputs(self.scope):
-                    found = True
-                    log.debug(
-                        "found {} in outputs from producer {} ({}) --> Rank {}".format(
-                            input,
-                            producer,
-                            producer.get_outputs(self.scope),
-                            self.ordering.index(producer),
-                        )
-                    )
-                    producers_to_relocate.add(producer)
-            if self.scope != "global":
-                for producer in self.global_producers:
-                    if input in producer.get_outputs("global"):
-                        found = True
-                        log.debug("found {} in global scope ..".format(input))
-            if not found:
-                producers_requiring_input = ""
-                for producer in self.ordering:
-                    if input in producer.get_inputs(self.scope):
-                        producers_requiring_input += "    " + str(producer) + "\n"
-                log.error(
-                    "{} was not found in any producer output by is required by: \n{}".format(
-                        input, producers_requiring_input
-                    )
-                )
-                log.error("Please check if all needed producers are activated !")
-                raise Exception
-        return list(producers_to_relocate)
+            True if the producer is always kept
+        """
+        if isinstance(producer, Filter) or isinstance(producer, BaseFilter):
+            return True
+        outputs = producer.get_outputs(scope)
+        return len(outputs) == 0 or any(
+            isinstance(quantity, NanoAODQuantity) for quantity in outputs
+        )
 
-    def relocate_producer(
-        self,
-        producer: Producer | ProducerGroup,
-        old_position: int,
-        new_position: int,
-    ) -> None:
+    def prune_scope(self, scope: str, needed: Set[Quantity]) -> Set[Quantity]:
+        """
+        Function used to remove all producers of a scope, that do not contribute to the needed quantities.
+
+        Args:
+            scope: The scope to prune
+            needed: The quantities needed from this scope
+
+        Returns:
+            The inputs of all kept producers
         """
-        Function used to relocate a producer to a given position.
+        leaves = {
+            producer: self.leaves(producer, scope) for producer in self.producers[scope]
+        }
+        producers_of: Dict[Quantity, List[Producer | ProducerGroup]] = {}
+        queue: List[Producer | ProducerGroup] = []
+        for group in leaves.values():
+            for leaf in group:
+                if self.required(leaf, scope):
+                    queue.append(leaf)
+                for quantity in leaf.get_outputs(scope):
+                    producers_of.setdefault(quantity, []).append(leaf)
+        for quantity in needed:
+            queue.extend(producers_of.get(quantity, []))
+        kept: Set[Producer | ProducerGroup] = set()
+        inputs: Set[Quantity] = set()
+        while len(queue) > 0:
+            producer = queue.pop()
+            if producer in kept:
+                continue
+            kept.add(producer)
+            for quantity in producer.get_inputs(scope):
+                inputs.add(quantity)
+                queue.extend(producers_of.get(quantity, []))
+        pruned: List[Producer | ProducerGroup] = []
+        for producer, group in leaves.items():
+            self.total_calls += count_calls(producer, scope, self.config_parameters)
+            remaining = [leaf for leaf in group if leaf in kept]
+            removed = [leaf for leaf in group if leaf not in kept]
+            if len(removed) == 0:
+                pruned.append(producer)
+                continue
+            # partially needed producer groups are replaced by their remaining subproducers
+            pruned.extend(remaining)
+            for leaf in removed:
+                self.calls_saved += count_calls(leaf, scope, self.config_parameters)
+                self.removed_producers.setdefault(scope, []).append(leaf.name)
+        self.producers[scope] = pruned
+        return inputs
+
+    def Prune(self) -> None:
+        """
+        The main function of this class. The unused outputs are removed from all scopes listed
+        in the manifest, followed by the producers only needed for them. The producers of the
+        global scope are pruned last, keeping everything needed by the remaining producers and
+        outputs of all scopes.
 
         Args:
-            producer: The producer to relocate
-            old_position: The old position of the producer in the ordering
-            new_position: The new position of the producer in the ordering
+            None
+
+        Returns:
+            None
         """
-        log.debug(
-            "Relocating Producer {} from rank {} to rank {}".format(
-                producer, old_position, new_position
+        scopes = [scope for scope in self.producers if scope != self.global_scope]
+        for scope in self.patterns:
+            self.removed_outputs[scope] = sorted(
+                output for output in self.outputs[scope] if not self.used(output, [scope])
+            )
+            for pattern in sorted(self.patterns[scope]):
+                if not any(
+                    fnmatchcase(name, pattern)
+                    for outputscope in [scope, self.global_scope]
+                    for output in self.outputs[outputscope]
+                    for name in self.names(output)
+                ):
+                    log.warning(
+                        "Pattern {} of the usage manifest matches no output of scope {}".format(
+                            pattern, scope
+                        )
+                    )
+        if all(scope in self.patterns for scope in scopes):
+            self.removed_outputs[self.global_scope] = sorted(
+                output
+                for output in self.outputs[self.global_scope]
+                if not self.used(output, scopes)
+            )
+        for scope, removed in self.removed_outputs.items():
+            self.outputs[scope].difference_update(removed)
+        needed_global: Set[Quantity] = set(self.outputs[self.global_scope])
+        for scope in scopes:
+            needed_global.update(self.outputs[scope])
+            if scope in self.patterns:
+                needed_global.update(self.prune_scope(scope, set(self.outputs[scope])))
+            else:
+                for producer in self.producers[scope]:
+                    needed_global.update(producer.get_inputs(scope))
+                    self.total_calls += count_calls(
+                        producer, scope, self.config_parameters
+                    )
+        self.prune_scope(self.global_scope, needed_global)
+        for scope in [self.global_scope] + scopes:
+            if scope not in self.removed_outputs and scope not in self.removed_producers:
+                continue
+            log.info(
+                "Removed {} unused outputs and {} producers from scope {}".format(
+                    len(self.removed_outputs.get(scope, [])),
+                    len(self.removed_producers.get(scope, [])),
+                    scope,
+                )
+            )
+        log.info(
+            "Output pruning saves {} of {} producer calls per event".format(
+                self.calls_saved, self.total_calls
             )
         )
-        updated_ordering = list(range(self.size))
-        if old_position > new_position:
-            for position in updated_ordering:
-                if position <= old_position and position > new_position:
-                    updated_ordering[position] = position - 1
-                if position == new_position:
-                    updated_ordering[position] = old_position
-        if old_position < new_position:
-            for position in updated_ordering:
-                if position >= old_position and position < new_position:
-                    updated_ordering[position] = position + 1
-                if position == new_position:
-                    updated_ordering[position] = old_position
-        if old_position == new_position:
-            log.debug("How did we get here ??")
-        new_ordering = [self.ordering[i] for i in updated_ordering]
-        log.debug(
-            "New ordering - ",
-        )
-        for i, prod in enumerate(new_ordering):
-            log.debug(" --> {}. : {}".format(i, prod))
-        self.ordering = new_ordering
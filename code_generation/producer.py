@@ -1,7 +1,7 @@
 from __future__ import annotations  # needed for type annotations in > python 3.7
 
 import logging
-from typing import Any, Dict, List, Set, Union
+from typing import Any, Dict, List, Optional, Set, Union
 
 from code_generation.exceptions import (
     InvalidProducerConfigurationError,
@@ -136,24 +136,12 @@ class Producer:
             # log.warning("name: {}".format(self.name))
             # log.warning("shift: {}".format(shift))
             # log.warning("Scopes: {}".format(config[shift].keys()))
-            config[shift]["output"] = (
-                '"' + '","'.join([x.get_leaf(shift, scope) for x in self.output]) + '"'
-            )
-            config[shift]["output_vec"] = (
-                '{"'
-                + '","'.join([x.get_leaf(shift, scope) for x in self.output])
-                + '"}'
-            )
-        config[shift]["input"] = (
-            '"'
-            + '", "'.join([x.get_leaf(shift, scope) for x in self.input[scope]])
-            + '"'
-        )
-        config[shift]["input_vec"] = (
-            '{"'
-            + '","'.join([x.get_leaf(shift, scope) for x in self.input[scope]])
-            + '"}'
-        )
+            outputs = [x.get_leaf(shift, scope) for x in self.output]
+            config[shift]["output"] = '"' + '","'.join(outputs) + '"'
+            config[shift]["output_vec"] = '{"' + '","'.join(outputs) + '"}'
+        inputs = [x.get_leaf(shift, scope) for x in self.input[scope]]
+        config[shift]["input"] = '"' + '", "'.join(inputs) + '"'
+        config[shift]["input_vec"] = '{"' + '","'.join(inputs) + '"}'
         config[shift]["df"] = "{df}"
         config[shift]["vec_open"] = "{vec_open}"
         config[shift]["vec_close"] = "{vec_close}"
@@ -167,9 +155,22 @@ class Producer:
                 else:
                     log.debug("Found a boolean False ! - converting to C++ syntax")
                     config[shift][para] = "false"
+        # a list of strings or numbers is converted to a comma separated list of c++
+        # strings or numbers, to be used within {vec_open} and {vec_close}. The config
+        # itself is not modified, since VectorProducers use the lists of the config
+        parameters = dict(config[shift])
+        for para, value in parameters.items():
+            if not isinstance(value, list) or len(value) == 0:
+                continue
+            if all(isinstance(x, str) for x in value):
+                parameters[para] = ", ".join('"{}"'.format(x) for x in value)
+            elif all(
+                isinstance(x, (int, float)) and not isinstance(x, bool) for x in value
+            ):
+                parameters[para] = ", ".join(str(x) for x in value)
         try:
             return self.call.format(
-                **config[shift]
+                **parameters
             )  # use format (not format_map here) such that missing config entries cause an error
         except KeyError as e:
             log.error(
@@ -300,13 +301,15 @@ class ExtendedVectorProducer(Producer):
         output: str,
         scope: Union[List[str], str],
         vec_config: str,
+        ctype: Optional[str] = None,
     ):
-        # we create a Quantity Group, which is updated during the writecalls() step
+        # we create a Quantity Group, which is updated during the writecalls() step,
+        # ctype is the C++ type of all quantities of the group
         self.outputname = output
         self.vec_config = vec_config
         if not isinstance(scope, list):
             scope = [scope]
-        quantity_group = q.QuantityGroup(name)
+        quantity_group = q.QuantityGroup(name, ctype)
         # set the vec config key of the quantity group
         quantity_group.set_vec_config(vec_config)
         super().__init__(name, call, input, [quantity_group], scope)
@@ -339,8 +342,11 @@ class ExtendedVectorProducer(Producer):
             log.error("ExtendedVectorProducer expects a QuantityGroup as output!")
             raise Exception
         for i in range(n_versions):
-            self.output[0].add(config["nominal"][self.vec_config][i][self.outputname])
+            self.output[0].add(
+                self.get_output_name(config["nominal"][self.vec_config][i])
+            )
         basecall = self.call
+        baseinput = self.input[scope]
         calls: List[str] = []
         shifts = ["nominal"]
         shifts.extend(self.output[0].get_shifts(scope))
@@ -355,10 +361,61 @@ class ExtendedVectorProducer(Producer):
                     '{"' + self.output[0].quantities[i].get_leaf(shift, scope) + '"}'
                 )
                 self.call = basecall.format_map(SafeDict(helper_dict))
+                self.input[scope] = self.get_version_inputs(baseinput, i, n_versions)
                 calls.append(self.writecall(config, scope, shift))
         self.call = basecall
+        self.input[scope] = baseinput
         return calls
 
+    def get_output_name(self, entry: Dict[str, Any]) -> str:
+        """
+        Get the name of the output quantity of one entry of the vec config. The output is either the value of the
+        config key given as output, or, if the output contains a format field, e.g. "{flagname}_match", the output
+        formatted with the entry.
+
+        Args:
+            entry: the configuration of one version of the producer
+        Returns:
+            str - the name of the output quantity
+        """
+        if "{" in self.outputname:
+            return self.outputname.format(**entry)
+        return entry[self.outputname]
+
+    def get_version_inputs(
+        self, inputs: List[q.Quantity], i: int, n_versions: int
+    ) -> List[q.Quantity]:
+        """
+        Get the inputs of the i-th version of the producer. If the output group of another ExtendedVectorProducer
+        with the same vec config is used as input, the i-th version only uses the i-th quantity of the group.
+        This is used to split a producer into a shift-invariant stage, which is only run once in the nominal path,
+        and a cheap stage run for every shift, which consumes the shared output of the first stage.
+
+        Args:
+            inputs: the inputs of the producer
+            i: the index of the version
+            n_versions: the number of versions
+        Returns:
+            list - the inputs of the i-th version
+        """
+        version_inputs: List[q.Quantity] = []
+        for quantity in inputs:
+            if isinstance(quantity, q.QuantityGroup):
+                if (
+                    quantity.vec_config != self.vec_config
+                    or len(quantity.quantities) != n_versions
+                ):
+                    log.error(
+                        "{} uses the quantity group {} as input, which is not produced from the vec config {}".format(
+                            self, quantity, self.vec_config
+                        )
+                    )
+                    raise InvalidProducerConfigurationError(self.name)
+                version_inputs.append(quantity.quantities[i])
+            else:
+                version_inputs.append(quantity)
+        return version_inputs
+
 
 class BaseFilter(Producer):
     def __init__(
@@ -391,6 +448,8 @@ class BaseFilter(Producer):
         config["nominal"]["input"] = '"' + '", "'.join(inputs) + '"'
         config["nominal"]["input_vec"] = '{"' + '","'.join(inputs) + '"}'
         config["nominal"]["df"] = "{df}"
+        config["nominal"]["vec_open"] = "{vec_open}"
+        config["nominal"]["vec_close"] = "{vec_close}"
         try:
             return [
                 self.call.format(**config["nominal"])
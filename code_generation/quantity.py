@@ -1,14 +1,21 @@
 from __future__ import annotations  # needed for type annotations in > python 3.7
 
 import logging
-from typing import Dict, List, Set, Union
+from typing import Dict, List, Optional, Set, Union
 
 log = logging.getLogger(__name__)
 
 
 class Quantity:
-    def __init__(self, name: str):
+    """
+    A Quantity is a column of the dataframe, that is produced by a producer. Optionally, the C++ type
+    of the quantity can be declared, which is used to write typed Snapshot calls. If no type is declared,
+    the type is taken from the type cache of the analysis (see CodeGenerator.set_type_probe).
+    """
+
+    def __init__(self, name: str, ctype: Optional[str] = None):
         self.name = name
+        self.ctype = ctype
         self.shifts: Dict[str, Set[str]] = {}
         self.ignored_shifts: Dict[str, Set[str]] = {}
         self.children: Dict[str, List[Quantity]] = {}
@@ -60,7 +67,7 @@ class Quantity:
         Returns:
             str. Name of the leaf
         """
-        if shift in self.get_shifts(scope):
+        if shift in self.shift_set(scope):
             return self.name + shift
         return self.name
 
@@ -131,7 +138,7 @@ class Quantity:
         Returns:
             Quantity. a new Quantity object.
         """
-        copy = Quantity(name)
+        copy = Quantity(name, self.ctype)
         copy.shifts = self.shifts
         copy.children = self.children
         copy.ignored_shifts = self.ignored_shifts
@@ -156,28 +163,41 @@ class Quantity:
             self.children[scope] = []
         self.children[scope].append(child)
 
-    def get_shifts(self, scope: str) -> List[str]:
+    def shift_set(self, scope: str) -> Set[str]:
         """
-        Function returns a list of all shifts, which are defined for a given scope.
+        Function returns the set of all shifts, which are defined for a given scope.
+        The set is not copied, so it must not be modified. This is used for lookups,
+        which are done for every call and shift during the code generation.
 
         Args:
             scope (str): Scope for which shifts should be returned
         Returns:
-            list: List of all shifts, which are defined for a given scope.
+            set: Set of all shifts, which are defined for a given scope.
         """
-        if "global" in self.shifts.keys():
-            if scope != "global" and scope in self.shifts.keys():
+        if "global" in self.shifts:
+            if scope != "global" and scope in self.shifts:
                 log.error(
                     "Quantity {} has shifts in global and {}. Something must be broken!".format(
                         self.name, scope
                     )
                 )
                 raise Exception
-            return list(self.shifts["global"])
-        elif scope in self.shifts.keys():
-            return list(self.shifts[scope])
+            return self.shifts["global"]
+        elif scope in self.shifts:
+            return self.shifts[scope]
         else:
-            return []
+            return set()
+
+    def get_shifts(self, scope: str) -> List[str]:
+        """
+        Function returns a list of all shifts, which are defined for a given scope.
+
+        Args:
+            scope (str): Scope for which shifts should be returned
+        Returns:
+            list: List of all shifts, which are defined for a given scope.
+        """
+        return list(self.shift_set(scope))
 
 
 class QuantityGroup(Quantity):
@@ -185,8 +205,8 @@ class QuantityGroup(Quantity):
     A Quantity Group is a group of quantities, that all have the same settings, but different names.
     """
 
-    def __init__(self, name: str):
-        super().__init__(name)
+    def __init__(self, name: str, ctype: Optional[str] = None):
+        super().__init__(name, ctype)
         self.quantities: List[Quantity] = []
         self.vec_config: str = ""
 
@@ -218,7 +238,7 @@ class QuantityGroup(Quantity):
             None
         """
         if name not in [q.name for q in self.quantities]:
-            quantity = Quantity(name)
+            quantity = Quantity(name, self.ctype)
             quantity.shifts = self.shifts
             quantity.children = self.children
             quantity.ignored_shifts = self.ignored_shifts
@@ -251,8 +271,8 @@ class NanoAODQuantity(Quantity):
     are therefore shielded from using them directly as a output.
     """
 
-    def __init__(self, name: str):
-        super().__init__(name)
+    def __init__(self, name: str, ctype: Optional[str] = None):
+        super().__init__(name, ctype)
         self.shifted_naming: Dict[str, str] = {}
 
     def reserve_scope(self, scope: str) -> None:
@@ -44,6 +44,33 @@ parser.add_argument(
 )
 parser.add_argument("--threads", type=int, help="number of threads to be used")
 parser.add_argument("--debug", type=str, help="set debug mode for building")
+parser.add_argument(
+    "--systematics-backend",
+    type=str,
+    choices=["duplicate", "vary"],
+    default="duplicate",
+    help="Backend used for systematic shifts, vary expresses shifts of input columns as RDataFrame Vary",
+)
+parser.add_argument(
+    "--arrow-output",
+    type=str,
+    choices=["none", "ipc", "parquet"],
+    default="none",
+    help="Additionally write the outputs as Arrow IPC or Parquet files",
+)
+parser.add_argument(
+    "--async-writer",
+    type=str,
+    choices=["true", "false"],
+    default="false",
+    help="Write the outputs of single-threaded executables in a background thread",
+)
+parser.add_argument(
+    "--unity-build",
+    type=int,
+    default=0,
+    help="Combine the generated code subsets into this number of sources, balanced by their estimated compilation cost. 0 compiles each subset separately",
+)
 args = parser.parse_args()
 
 # find available analyses, every folder in analysis_configurations is an analysis
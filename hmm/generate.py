@@ -1,8 +1,16 @@
 from os import path, makedirs
-import importlib
+import glob
+import json
 import logging
 import logging.handlers
-from code_generation.code_generation import CodeGenerator
+from code_generation.code_generation import (
+    CodeGenerator,
+    MultiConfigCodeGenerator,
+    build_configurations,
+    load_primary_datasets,
+    load_usage_manifest,
+)
+from code_generation.configuration import Configuration
 
 
 def run(args):
@@ -45,18 +53,25 @@ def run(args):
     )
     handler.setFormatter(logging.Formatter(logging.BASIC_FORMAT))
     root.addHandler(handler)
-    ## load config
-    configname = args.config
-    config = importlib.import_module(
-        f"analysis_configurations.{analysis_name}.{configname}"
+    ## load the usage manifests of the downstream jobs, outputs not read by them are not written
+    manifest_files = sorted(
+        glob.glob(path.join(path.dirname(path.abspath(__file__)), "usage_manifest*.json"))
     )
-    ## Setting up executable
-    executable = f"{configname}_{sample_group}_{era}.cxx"
+    Configuration.usage_manifest = load_usage_manifest(manifest_files)
+    if len(manifest_files) > 0:
+        root.info(
+            f"Loaded the usage manifest of {len(Configuration.usage_manifest)} scopes from {manifest_files}"
+        )
+    ## load config
+    # several configurations can be given as a comma separated list, in this case
+    # a single executable running all of them over the same inputs is generated
+    confignames = args.config.split(",")
     root.info(f"Generating code for {sample_group}...")
-    root.info(f"Configuration used: {config}")
     root.info(f"Era: {era}")
     root.info(f"Shifts: {shifts}")
-    config = config.build_config(
+    configurations = build_configurations(
+        analysis_name,
+        confignames,
         era,
         sample_group,
         scopes,
@@ -64,19 +79,56 @@ def run(args):
         available_samples,
         available_eras,
         available_scopes,
+        systematics_backend=args.systematics_backend,
     )
+    ## load the type cache of the output quantities, written by the type probe of an executable
+    quantity_types = {}
+    types_file = path.join(path.dirname(path.abspath(__file__)), "quantity_types.json")
+    if path.exists(types_file):
+        with open(types_file, "r") as f:
+            quantity_types = json.load(f)
+        root.info(
+            f"Loaded quantity types of {len(quantity_types)} scopes from {types_file}"
+        )
+    ## load the value ranges of the integer outputs, written by an executable in calibration mode
+    # without the file, the executable contains no range calibration, an empty file enables the calibration
+    quantity_ranges = None
+    ranges_file = path.join(path.dirname(path.abspath(__file__)), "quantity_ranges.json")
+    if path.exists(ranges_file):
+        with open(ranges_file, "r") as f:
+            quantity_ranges = json.load(f)
+        root.info(f"Loaded {len(quantity_ranges)} quantity ranges from {ranges_file}")
+    ## Setting up executable
+    configname = "_".join(confignames)
     # create a CodeGenerator object
-    generator = CodeGenerator(
-        main_template_path=args.template,
-        sub_template_path=args.subset_template,
-        configuration=config,
-        executable_name=f"{configname}_{sample_group}_{era}",
-        analysis_name=f"{analysis_name}_{configname}",
-        output_folder=args.output,
-        threads=args.threads,
-    )
-    if args.debug == "true":
-        generator.debug = True
+    if len(configurations) == 1:
+        generator = CodeGenerator(
+            main_template_path=args.template,
+            sub_template_path=args.subset_template,
+            configuration=configurations[confignames[0]],
+            executable_name=f"{configname}_{sample_group}_{era}",
+            analysis_name=f"{analysis_name}_{configname}",
+            output_folder=args.output,
+            threads=args.threads,
+            quantity_types=quantity_types,
+            quantity_ranges=quantity_ranges,
+        )
+    else:
+        generator = MultiConfigCodeGenerator(
+            main_template_path=args.template,
+            sub_template_path=args.subset_template,
+            configurations=configurations,
+            executable_name=f"{configname}_{sample_group}_{era}",
+            analysis_name=f"{analysis_name}_{configname}",
+            output_folder=args.output,
+            threads=args.threads,
+            quantity_types=quantity_types,
+            quantity_ranges=quantity_ranges,
+        )
+    generator.set_build_options(args)
+    # the primary datasets of data, used to remove the overlap between them
+    if sample_group == "data":
+        generator.primary_datasets = load_primary_datasets(era)
     # generate the code
     generator.generate_code()
 
@@ -94,6 +94,14 @@ NumberOfBaseElectrons = Producer(
     output=[q.nelectrons],
     scopes=["e2m","m2m", "eemm","mmmm","nnmm","nnmm_dycontrol","nnmm_topcontrol"],
 )
+# same as NumberOfBaseElectrons, available in the global scope for the preselection
+NumberOfBaseElectronsGlobal = Producer(
+    name="NumberOfBaseElectronsGlobal",
+    call="quantities::NumberOfGoodObjects({df}, {output}, {input})",
+    input=[q.base_electrons_mask],
+    output=[q.nelectrons_base],
+    scopes=["global"],
+)
 Ele_Veto = Producer(
     name="Ele_Veto",
     call="physicsobject::Ele_Veto({df}, {output}, {input})",
@@ -26,6 +26,15 @@ JSONFilter = BaseFilter(
     scopes=["global"],
 )
 
+# removes the events of a primary dataset, which are also contained in a
+# primary dataset with higher priority, see trigger::PrimaryDatasetOverlapVeto
+PrimaryDatasetOverlapVeto = BaseFilter(
+    name="PrimaryDatasetOverlapVeto",
+    call='trigger::PrimaryDatasetOverlapVeto({df}, "PrimaryDatasetOverlapVeto", {vec_open}{pd_priority}{vec_close}, {vec_open}{pd_trigger_datasets}{vec_close}, {pd_triggers})',
+    input=[],
+    scopes=["global"],
+)
+
 PrefireWeight = Producer(
     name="PrefireWeight",
     call="basefunctions::rename<Float_t>({df}, {input}, {output})",
@@ -126,6 +135,14 @@ MetFilter = VectorProducer(
     vec_configs=["met_filters"],
 )
 
+MetFilters = Producer(
+    name="MetFilters",
+    call='metfilter::ApplyMetFilters({df}, "MetFilters", {met_filters})',
+    input=[],
+    output=None,
+    scopes=["global"],
+)
+
 Lumi = Producer(
     name="Lumi",
     call="basefunctions::rename<UInt_t>({df}, {input}, {output})",
@@ -157,6 +174,23 @@ VetottHMediumB = Producer(
     scopes=["global"],
 )
 
+# loose multiplicity requirements on the base leptons of the global scope, these
+# are pushed down into the global scope by the optimizer (PreselectionPushdown)
+PreselectionBaseMuons = Producer(
+    name="PreselectionBaseMuons",
+    call='basefunctions::FilterThreshold({df}, {input}, {min_base_muons}, ">=", "Minimum number of base muons")',
+    input=[q.nmuons_base],
+    output=None,
+    scopes=["e2m","m2m","eemm","mmmm","nnmm","nnmm_dycontrol","nnmm_topcontrol"],
+)
+PreselectionBaseElectrons = Producer(
+    name="PreselectionBaseElectrons",
+    call='basefunctions::FilterThreshold({df}, {input}, {min_base_electrons}, ">=", "Minimum number of base electrons")',
+    input=[q.nelectrons_base],
+    output=None,
+    scopes=["e2m","eemm","nnmm_topcontrol"],
+)
+
 FilterNMuons = Producer(
     name="FilterNMuons",
     call='basefunctions::FilterThreshold({df}, {input}, {vh_m2m_nmuons}, "==", "Number of muons 3")',
@@ -23,6 +23,9 @@ JetPtCorrection = Producer(
         nanoAOD.GenJet_eta,
         nanoAOD.GenJet_phi,
         nanoAOD.rho,
+        nanoAOD.run,
+        nanoAOD.luminosityBlock,
+        nanoAOD.event,
     ],
     output=[q.Jet_pt_corrected],
     scopes=["global"],
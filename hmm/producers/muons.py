@@ -81,6 +81,14 @@ BaseMuons = ProducerGroup(
         MuonIsoCut,
     ],
 )
+# number of base muons, an upper bound for the muon multiplicity of all channels
+NumberOfBaseMuons = Producer(
+    name="NumberOfBaseMuons",
+    call="quantities::NumberOfGoodObjects({df}, {output}, {input})",
+    input=[q.base_muons_mask],
+    output=[q.nmuons_base],
+    scopes=["global"],
+)
 
 ####################
 # Set of producers used for more specific selection of muons in channels
@@ -122,6 +130,21 @@ GoodMuons = ProducerGroup(
         GoodMuonIsoCut,
     ],
 )
+# compact copy of the good muons, to be used with the functions in physicsobject::compact
+GoodMuonsCollection = Producer(
+    name="GoodMuonsCollection",
+    call="physicsobject::GatherSelectedObjects({df}, {output}, {input})",
+    input=[
+        nanoAOD.Muon_pt,
+        nanoAOD.Muon_eta,
+        nanoAOD.Muon_phi,
+        nanoAOD.Muon_mass,
+        nanoAOD.Muon_charge,
+        q.good_muons_mask,
+    ],
+    output=[q.good_muons_collection],
+    scopes=["e2m","m2m", "eemm","mmmm","nnmm","nnmm_dycontrol","nnmm_topcontrol"],
+)
 #
 NumberOfGoodMuons = Producer(
     name="NumberOfGoodMuons",
@@ -145,11 +168,25 @@ VetoSecondMuon = Producer(
     scopes=["mm"],
 )
 
+VetoMuonsCollection = Producer(
+    name="VetoMuonsCollection",
+    call="physicsobject::GatherSelectedObjects({df}, {output}, {input})",
+    input=[
+        nanoAOD.Muon_pt,
+        nanoAOD.Muon_eta,
+        nanoAOD.Muon_phi,
+        nanoAOD.Muon_mass,
+        nanoAOD.Muon_charge,
+        q.veto_muons_mask_2,
+    ],
+    output=[q.veto_muons_collection],
+    scopes=["mm"],
+)
 ExtraMuonsVeto = Producer(
     name="ExtraMuonsVeto",
-    call="physicsobject::LeptonVetoFlag({df}, {output}, {input})",
+    call="physicsobject::compact::LeptonVetoFlag({df}, {output}, {input})",
     input={
-        "mm": [q.veto_muons_mask_2],
+        "mm": [q.veto_muons_collection],
     },
     output=[q.muon_veto_flag],
     scopes=["mm"],
@@ -184,9 +221,9 @@ DiMuonVetoMuons = ProducerGroup(
         DiMuonVetoIDCut,
     ],
 )
-DiMuonVeto = ProducerGroup(
-    name="DiMuonVeto",
-    call="physicsobject::CheckForDiLeptonPairs({df}, {output}, {input}, {dileptonveto_dR})",
+DiMuonVetoCollection = ProducerGroup(
+    name="DiMuonVetoCollection",
+    call="physicsobject::GatherSelectedObjects({df}, {output}, {input})",
     input=[
         nanoAOD.Muon_pt,
         nanoAOD.Muon_eta,
@@ -194,10 +231,18 @@ DiMuonVeto = ProducerGroup(
         nanoAOD.Muon_mass,
         nanoAOD.Muon_charge,
     ],
-    output=[q.dimuon_veto],
+    output=[],
     scopes=["global"],
     subproducers=[DiMuonVetoMuons],
 )
+DiMuonVeto = ProducerGroup(
+    name="DiMuonVeto",
+    call="physicsobject::compact::CheckForDiLeptonPairs({df}, {output}, {input}, {dileptonveto_dR})",
+    input=[],
+    output=[q.dimuon_veto],
+    scopes=["global"],
+    subproducers=[DiMuonVetoCollection],
+)
 
 
 ### Muon collection and their properties
@@ -1,59 +1,78 @@
 from ..quantities import output as q
 from ..quantities import nanoAOD as nanoAOD
-from code_generation.producer import ExtendedVectorProducer
+from code_generation.producer import Producer, ExtendedVectorProducer
 
 ####################
 # Set of producers used for trigger flags
 ####################
 
-GenerateSingleMuonTriggerFlags = ExtendedVectorProducer(
-    name="GenerateSingleMuonTriggerFlags",
-    call='trigger::GenerateTripleTriggerORFlag({df}, {output}, {input}, "{hlt_path}", {ptcut}, {ptcut}, {ptcut}, {etacut}, {etacut}, {etacut}, {trigger_particle_id}, {trigger_particle_id}, {trigger_particle_id}, {filterbit}, {filterbit}, {filterbit}, {max_deltaR_triggermatch} )',
+HLTBitset = Producer(
+    name="HLTBitset",
+    call="trigger::GenerateHLTBitset({df}, {output}, {hlt_paths})",
+    input=[],
+    output=[q.hlt_bits],
+    scopes=["global"],
+)
+
+# the trigger matching is split into a geometric match of every muon, which
+# does not depend on the muon pt and is therefore only run once in the nominal
+# path, and the pt and eta thresholds of the leading muons, which are checked
+# for every shift
+SingleMuonTriggerMatches = ExtendedVectorProducer(
+    name="SingleMuonTriggerMatches",
+    call="trigger::GeometricTriggerMatch({df}, {output}, {input}, {hlt_bit}, {trigger_particle_id}, {filterbit}, {max_deltaR_triggermatch})",
     input=[
-        q.muon_p4_1,
-        q.muon_p4_2,
-        q.muon_p4_3,
+        nanoAOD.Muon_eta,
+        nanoAOD.Muon_phi,
         nanoAOD.TriggerObject_bit,
         nanoAOD.TriggerObject_id,
-        nanoAOD.TriggerObject_pt,
         nanoAOD.TriggerObject_eta,
         nanoAOD.TriggerObject_phi,
+        q.hlt_bits,
+    ],
+    output="{flagname}_match",
+    scope=["e2m", "m2m", "eemm", "mmmm", "nnmm"],
+    vec_config="singlemuon_trigger",
+)
+GenerateSingleMuonTriggerFlags = ExtendedVectorProducer(
+    name="GenerateSingleMuonTriggerFlags",
+    call="trigger::GenerateTriggerORFlagFromMatch({df}, {output}, {input}, 3, {ptcut}, {etacut})",
+    input=[
+        q.good_muon_collection,
+        nanoAOD.Muon_pt,
+        nanoAOD.Muon_eta,
+        SingleMuonTriggerMatches.output_group,
     ],
     output="flagname",
     scope=["m2m"],
     vec_config="singlemuon_trigger",
+    ctype="bool",
 )
 GenerateSingleMuonTriggerFlagsForDiMuChannel = ExtendedVectorProducer(
     name="GenerateSingleMuonTriggerFlagsForDiMuChannel",
-    call='trigger::GenerateDoubleTriggerORFlag({df}, {output}, {input}, "{hlt_path}", {ptcut}, {ptcut}, {etacut}, {etacut}, {trigger_particle_id}, {trigger_particle_id}, {filterbit}, {filterbit}, {max_deltaR_triggermatch} )',
+    call="trigger::GenerateTriggerORFlagFromMatch({df}, {output}, {input}, 2, {ptcut}, {etacut})",
     input=[
-        q.muon_p4_1,
-        q.muon_p4_2,
-        nanoAOD.TriggerObject_bit,
-        nanoAOD.TriggerObject_id,
-        nanoAOD.TriggerObject_pt,
-        nanoAOD.TriggerObject_eta,
-        nanoAOD.TriggerObject_phi,
+        q.good_muon_collection,
+        nanoAOD.Muon_pt,
+        nanoAOD.Muon_eta,
+        SingleMuonTriggerMatches.output_group,
     ],
     output="flagname",
-    scope=["e2m","eemm","nnmm"],
+    scope=["e2m", "eemm", "nnmm"],
     vec_config="singlemuon_trigger",
+    ctype="bool",
 )
 GenerateSingleMuonTriggerFlagsForQuadMuChannel = ExtendedVectorProducer(
     name="GenerateSingleMuonTriggerFlagsForQuadMuChannel",
-    call='trigger::GenerateQuadTriggerORFlag({df}, {output}, {input}, "{hlt_path}", {ptcut}, {ptcut}, {ptcut}, {ptcut}, {etacut}, {etacut}, {etacut}, {etacut}, {trigger_particle_id}, {trigger_particle_id}, {trigger_particle_id}, {trigger_particle_id}, {filterbit}, {filterbit}, {filterbit}, {filterbit}, {max_deltaR_triggermatch} )',
+    call="trigger::GenerateTriggerORFlagFromMatch({df}, {output}, {input}, 4, {ptcut}, {etacut})",
     input=[
-        q.muon_p4_1,
-        q.muon_p4_2,
-        q.muon_p4_3,
-        q.muon_p4_4,
-        nanoAOD.TriggerObject_bit,
-        nanoAOD.TriggerObject_id,
-        nanoAOD.TriggerObject_pt,
-        nanoAOD.TriggerObject_eta,
-        nanoAOD.TriggerObject_phi,
+        q.good_muon_collection,
+        nanoAOD.Muon_pt,
+        nanoAOD.Muon_eta,
+        SingleMuonTriggerMatches.output_group,
     ],
     output="flagname",
     scope=["mmmm"],
     vec_config="singlemuon_trigger",
-)
\ No newline at end of file
+    ctype="bool",
+)
@@ -1,8 +1,8 @@
 from code_generation.quantity import NanoAODQuantity
 
-run = NanoAODQuantity("run")
+run = NanoAODQuantity("run", ctype="UInt_t")
 luminosityBlock = NanoAODQuantity("luminosityBlock")
-event = NanoAODQuantity("event")
+event = NanoAODQuantity("event", ctype="ULong64_t")
 LHE_Njets = NanoAODQuantity("LHE_Njets")
 prefireWeight = NanoAODQuantity("L1PreFiringWeight_Nom")
 
@@ -119,7 +119,7 @@ GenMET_pt = NanoAODQuantity("GenMET_pt")
 GenMET_phi = NanoAODQuantity("GenMET_phi")
 
 ## Embedding Quantities
-genWeight = NanoAODQuantity("genWeight")
+genWeight = NanoAODQuantity("genWeight", ctype="Float_t")
 TauEmbedding_initialMETEt = NanoAODQuantity("TauEmbedding_initialMETEt")
 TauEmbedding_initialMETphi = NanoAODQuantity("TauEmbedding_initialMETphi")
 TauEmbedding_initialPuppiMETEt = NanoAODQuantity("TauEmbedding_initialPuppiMETEt")
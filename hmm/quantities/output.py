@@ -1,13 +1,16 @@
 from code_generation.quantity import Quantity
 
-lumi = Quantity("lumi")
-puweight = Quantity("puweight")
+lumi = Quantity("lumi", ctype="UInt_t")
+puweight = Quantity("puweight", ctype="double")
 prefireweight = Quantity("prefiring_wgt")
+hlt_bits = Quantity("hlt_bits", ctype="ULong64_t")
 
 base_taus_mask = Quantity("base_taus_mask")
 good_taus_mask = Quantity("good_taus_mask")
 base_muons_mask = Quantity("base_muons_mask")
 good_muons_mask = Quantity("good_muons_mask")
+good_muons_collection = Quantity("good_muons_collection")
+veto_muons_collection = Quantity("veto_muons_collection")
 veto_muons_mask = Quantity("veto_muons_mask")
 veto_muons_mask_2 = Quantity("veto_muons_mask_2")
 muon_veto_flag = Quantity("extramuon_veto")
@@ -23,8 +26,8 @@ jet_overlap_veto_mask = Quantity("jet_overlap_veto_mask")
 good_jets_mask = Quantity("good_jets_mask")
 good_bjets_mask_loose = Quantity("good_bjets_mask_loose")
 good_bjets_mask_medium = Quantity("good_bjets_mask_medium")
-nbjets_loose = Quantity("nbjets_loose")
-nbjets_medium = Quantity("nbjets_medium")
+nbjets_loose = Quantity("nbjets_loose", ctype="int")
+nbjets_medium = Quantity("nbjets_medium", ctype="int")
 Tau_pt_ele_corrected = Quantity("Tau_pt_ele_corrected")
 Tau_pt_ele_mu_corrected = Quantity("Tau_pt_mu_corrected")
 Tau_pt_corrected = Quantity("Tau_pt_corrected")
@@ -37,8 +40,10 @@ truegenpair = Quantity("truegenpair")
 good_jet_collection = Quantity("good_jet_collection")
 good_bjet_collection = Quantity("good_bjet_collection")
 
-nelectrons = Quantity("nelectrons")
-nmuons = Quantity("nmuons")
+nelectrons = Quantity("nelectrons", ctype="int")
+nmuons = Quantity("nmuons", ctype="int")
+nelectrons_base = Quantity("nelectrons_base")
+nmuons_base = Quantity("nmuons_base")
 ntaus = Quantity("ntaus")
 muon_p4_1 = Quantity("muon_p4_1")
 p4_1_uncorrected = Quantity("p4_1_uncorrected")
@@ -88,7 +93,7 @@ pt_tt = Quantity("pt_tt")
 pt_ttjj = Quantity("pt_ttjj")
 mt_tot = Quantity("mt_tot")
 
-njets = Quantity("njets")
+njets = Quantity("njets", ctype="int")
 nbtag = Quantity("nbtag")
 jet_p4_1 = Quantity("jet_p4_1")
 jpt_1 = Quantity("jpt_1")
@@ -201,41 +206,41 @@ emb_SelectionNewMass = Quantity("emb_SelectionNewMass")
 
 
 # sample flags
-is_data = Quantity("is_data")
-is_embedding = Quantity("is_embedding")
-is_top = Quantity("is_top")
-is_dyjets = Quantity("is_dyjets")
-is_wjets = Quantity("is_wjets")
+is_data = Quantity("is_data", ctype="bool")
+is_embedding = Quantity("is_embedding", ctype="bool")
+is_top = Quantity("is_top", ctype="bool")
+is_dyjets = Quantity("is_dyjets", ctype="bool")
+is_wjets = Quantity("is_wjets", ctype="bool")
 is_ggh_htautau = Quantity("is_ggh_htautau")
 is_vbf_htautau = Quantity("is_vbf_htautau")
-is_diboson = Quantity("is_diboson")
-is_zjjew = Quantity("is_zjjew")
-is_triboson = Quantity("is_triboson")
+is_diboson = Quantity("is_diboson", ctype="bool")
+is_zjjew = Quantity("is_zjjew", ctype="bool")
+is_triboson = Quantity("is_triboson", ctype="bool")
 
 # Electron Weights
-id_wgt_ele_wp90nonIso_1 = Quantity("id_wgt_ele_wp90nonIso_1")
-id_wgt_ele_wp90nonIso_2 = Quantity("id_wgt_ele_wp90nonIso_2")
-id_wgt_ele_wp80nonIso_1 = Quantity("id_wgt_ele_wp80nonIso_1")
-id_wgt_ele_wp80nonIso_2 = Quantity("id_wgt_ele_wp80nonIso_2")
+id_wgt_ele_wp90nonIso_1 = Quantity("id_wgt_ele_wp90nonIso_1", ctype="double")
+id_wgt_ele_wp90nonIso_2 = Quantity("id_wgt_ele_wp90nonIso_2", ctype="double")
+id_wgt_ele_wp80nonIso_1 = Quantity("id_wgt_ele_wp80nonIso_1", ctype="double")
+id_wgt_ele_wp80nonIso_2 = Quantity("id_wgt_ele_wp80nonIso_2", ctype="double")
 # Muon weights
-id_wgt_mu_1 = Quantity("id_wgt_mu_1")
-id_wgt_mu_2 = Quantity("id_wgt_mu_2")
-id_wgt_mu_3 = Quantity("id_wgt_mu_3")
-id_wgt_mu_4 = Quantity("id_wgt_mu_4")
-iso_wgt_mu_1 = Quantity("iso_wgt_mu_1")
-iso_wgt_mu_2 = Quantity("iso_wgt_mu_2")
-iso_wgt_mu_3 = Quantity("iso_wgt_mu_3")
-iso_wgt_mu_4 = Quantity("iso_wgt_mu_4")
+id_wgt_mu_1 = Quantity("id_wgt_mu_1", ctype="double")
+id_wgt_mu_2 = Quantity("id_wgt_mu_2", ctype="double")
+id_wgt_mu_3 = Quantity("id_wgt_mu_3", ctype="double")
+id_wgt_mu_4 = Quantity("id_wgt_mu_4", ctype="double")
+iso_wgt_mu_1 = Quantity("iso_wgt_mu_1", ctype="double")
+iso_wgt_mu_2 = Quantity("iso_wgt_mu_2", ctype="double")
+iso_wgt_mu_3 = Quantity("iso_wgt_mu_3", ctype="double")
+iso_wgt_mu_4 = Quantity("iso_wgt_mu_4", ctype="double")
 
 # write by botao
-smallest_dimuon_mass = Quantity("smallest_dimuon_mass")
-smallest_dielectron_mass = Quantity("smallest_dielectron_mass")
+smallest_dimuon_mass = Quantity("smallest_dimuon_mass", ctype="float")
+smallest_dielectron_mass = Quantity("smallest_dielectron_mass", ctype="float")
 dimuon_p4_byPt = Quantity("dimuon_p4_byPt")
-Flag_dimuon_Zmass_veto = Quantity("Flag_dimuon_Zmass_veto")
-Flag_LeptonChargeSumVeto = Quantity("Flag_LeptonChargeSumVeto")
-Flag_Ele_Veto = Quantity("Flag_Ele_Veto")
-Flag_DiMuonFromHiggs = Quantity("Flag_DiMuonFromHiggs")
-is_vhmm = Quantity("is_vhmm")
+Flag_dimuon_Zmass_veto = Quantity("Flag_dimuon_Zmass_veto", ctype="int")
+Flag_LeptonChargeSumVeto = Quantity("Flag_LeptonChargeSumVeto", ctype="int")
+Flag_Ele_Veto = Quantity("Flag_Ele_Veto", ctype="int")
+Flag_DiMuonFromHiggs = Quantity("Flag_DiMuonFromHiggs", ctype="int")
+is_vhmm = Quantity("is_vhmm", ctype="bool")
 dimuon_HiggsCand_collection = Quantity("dimuon_HiggsCand_collection")
 #HiggsToMuMu_mask = Quantity("HiggsToMuMu_mask")
 #dimuon_p4_HiggsCand = Quantity("dimuon_p4_HiggsCand")
@@ -245,11 +250,11 @@ base_electron_collection = Quantity("base_electron_collection")
 dielectron_ZCand_collection = Quantity("dielectron_ZCand_collection")
 electron_p4_1 = Quantity("electron_p4_1")
 electron_p4_2 = Quantity("electron_p4_2")
-Flag_DiEleFromZ = Quantity("Flag_DiEleFromZ")
+Flag_DiEleFromZ = Quantity("Flag_DiEleFromZ", ctype="int")
 dielectron_p4_byPt = Quantity("dielectron_p4_byPt")
 # 4m
 quadmuon_HiggsZCand_collection = Quantity("quadmuon_HiggsZCand_collection")
-Flag_ZZVeto = Quantity("Flag_ZZVeto")
+Flag_ZZVeto = Quantity("Flag_ZZVeto", ctype="int")
 dimuon_p4_Higgs = Quantity("dimuon_p4_Higgs")
 dimuon_p4_Z = Quantity("dimuon_p4_Z")
 dilepton_p4_Z = Quantity("dilepton_p4_Z")
@@ -265,125 +270,125 @@ lepton_subleadingp4_Z = Quantity("lepton_subleadingp4_Z")
 extra_muon_index = Quantity("extra_muon_index")
 extra_lep_p4 = Quantity("extra_lep_p4")
 ### extra electron can get from base electron collection
-mt_W = Quantity("mt_W")
-lep_H_dR = Quantity("lep_H_dR")
-mumuH_dR = Quantity("mumuH_dR")
+mt_W = Quantity("mt_W", ctype="float")
+lep_H_dR = Quantity("lep_H_dR", ctype="double")
+mumuH_dR = Quantity("mumuH_dR", ctype="double")
 mu_p4_SSwithLep = Quantity("mu_p4_SSwithLep")
 mu_p4_OSwithLep = Quantity("mu_p4_OSwithLep")
-lep_muSS_dR = Quantity("lep_muSS_dR")
-lep_muOS_dR = Quantity("lep_muOS_dR")
-lep_H_deta = Quantity("lep_H_deta")
-lep_muSS_deta = Quantity("lep_muSS_deta")
-lep_muOS_deta = Quantity("lep_muOS_deta")
+lep_muSS_dR = Quantity("lep_muSS_dR", ctype="double")
+lep_muOS_dR = Quantity("lep_muOS_dR", ctype="double")
+lep_H_deta = Quantity("lep_H_deta", ctype="float")
+lep_muSS_deta = Quantity("lep_muSS_deta", ctype="float")
+lep_muOS_deta = Quantity("lep_muOS_deta", ctype="float")
 ###
-llZ_dR = Quantity("llZ_dR")
-Zlep_ID = Quantity("Zlep_ID")
-Z_H_deta = Quantity("Z_H_deta")
-Z_H_dphi = Quantity("Z_H_dphi")
-met_H_dphi = Quantity("met_H_dphi")
-mumuH_dphi = Quantity("mumuH_dphi")
+llZ_dR = Quantity("llZ_dR", ctype="double")
+Zlep_ID = Quantity("Zlep_ID", ctype="int")
+Z_H_deta = Quantity("Z_H_deta", ctype="float")
+Z_H_dphi = Quantity("Z_H_dphi", ctype="double")
+met_H_dphi = Quantity("met_H_dphi", ctype="double")
+mumuH_dphi = Quantity("mumuH_dphi", ctype="double")
 MHT_p4 = Quantity("MHT_p4")
-mt_muSSAndMHT = Quantity("mt_muSSAndMHT")
-mt_muOSAndMHT = Quantity("mt_muOSAndMHT")
-mt_lepWAndMHT = Quantity("mt_lepWAndMHT")
-lep_MHT_dphi = Quantity("lep_MHT_dphi")
+mt_muSSAndMHT = Quantity("mt_muSSAndMHT", ctype="float")
+mt_muOSAndMHT = Quantity("mt_muOSAndMHT", ctype="float")
+mt_lepWAndMHT = Quantity("mt_lepWAndMHT", ctype="float")
+lep_MHT_dphi = Quantity("lep_MHT_dphi", ctype="double")
 ### check for MHT
-mumuH_MHT_dphi = Quantity("mumuH_MHT_dphi")
-mu1_MHT_dphi = Quantity("mu1_MHT_dphi")
-mu2_MHT_dphi = Quantity("mu2_MHT_dphi")
-mu1_mu2_dphi = Quantity("mu1_mu2_dphi")
-lep_mu1_dphi = Quantity("lep_mu1_dphi")
-lep_mu2_dphi = Quantity("lep_mu2_dphi")
-lep_H_dphi = Quantity("lep_H_dphi")
+mumuH_MHT_dphi = Quantity("mumuH_MHT_dphi", ctype="double")
+mu1_MHT_dphi = Quantity("mu1_MHT_dphi", ctype="double")
+mu2_MHT_dphi = Quantity("mu2_MHT_dphi", ctype="double")
+mu1_mu2_dphi = Quantity("mu1_mu2_dphi", ctype="double")
+lep_mu1_dphi = Quantity("lep_mu1_dphi", ctype="double")
+lep_mu2_dphi = Quantity("lep_mu2_dphi", ctype="double")
+lep_H_dphi = Quantity("lep_H_dphi", ctype="double")
 jet_p4_3 = Quantity("jet_p4_3")
 jet_p4_4 = Quantity("jet_p4_4")
 MHTALL_p4 = Quantity("MHTALL_p4")
 lep_MHTALL_dphi = Quantity("lep_MHTALL_dphi")
-lep_muOS_cosThStar = Quantity("lep_muOS_cosThStar")
-lep_muSS_cosThStar = Quantity("lep_muSS_cosThStar")
-Z_H_cosThStar = Quantity("Z_H_cosThStar")
-Flag_MetCut = Quantity("Flag_MetCut")
-
-mu1_fromH_pt = Quantity("mu1_fromH_pt")
-mu1_fromH_eta = Quantity("mu1_fromH_eta")
-mu1_fromH_phi = Quantity("mu1_fromH_phi")
+lep_muOS_cosThStar = Quantity("lep_muOS_cosThStar", ctype="float")
+lep_muSS_cosThStar = Quantity("lep_muSS_cosThStar", ctype="float")
+Z_H_cosThStar = Quantity("Z_H_cosThStar", ctype="float")
+Flag_MetCut = Quantity("Flag_MetCut", ctype="int")
+
+mu1_fromH_pt = Quantity("mu1_fromH_pt", ctype="float")
+mu1_fromH_eta = Quantity("mu1_fromH_eta", ctype="float")
+mu1_fromH_phi = Quantity("mu1_fromH_phi", ctype="float")
 mu1_fromH_mass = Quantity("mu1_fromH_mass")
 
-mu2_fromH_pt = Quantity("mu2_fromH_pt")
-mu2_fromH_eta = Quantity("mu2_fromH_eta")
-mu2_fromH_phi = Quantity("mu2_fromH_phi")
+mu2_fromH_pt = Quantity("mu2_fromH_pt", ctype="float")
+mu2_fromH_eta = Quantity("mu2_fromH_eta", ctype="float")
+mu2_fromH_phi = Quantity("mu2_fromH_phi", ctype="float")
 mu2_fromH_mass = Quantity("mu2_fromH_mass")
 
-H_pt = Quantity("H_pt")
-H_eta = Quantity("H_eta")
-H_phi = Quantity("H_phi")
-H_mass = Quantity("H_mass")
+H_pt = Quantity("H_pt", ctype="float")
+H_eta = Quantity("H_eta", ctype="float")
+H_phi = Quantity("H_phi", ctype="float")
+H_mass = Quantity("H_mass", ctype="float")
 
-met_pt = Quantity("met_pt")
-met_phi = Quantity("met_phi")
-genmet_pt = Quantity("genmet_pt")
-genmet_phi = Quantity("genmet_phi")
+met_pt = Quantity("met_pt", ctype="float")
+met_phi = Quantity("met_phi", ctype="float")
+genmet_pt = Quantity("genmet_pt", ctype="float")
+genmet_phi = Quantity("genmet_phi", ctype="float")
 
-extra_lep_pt = Quantity("extra_lep_pt")
-extra_lep_eta = Quantity("extra_lep_eta")
-extra_lep_phi = Quantity("extra_lep_phi")
+extra_lep_pt = Quantity("extra_lep_pt", ctype="float")
+extra_lep_eta = Quantity("extra_lep_eta", ctype="float")
+extra_lep_phi = Quantity("extra_lep_phi", ctype="float")
 extra_lep_mass = Quantity("extra_lep_mass")
 
-muOS_pt = Quantity("muOS_pt")
-muOS_eta = Quantity("muOS_eta")
-muOS_phi = Quantity("muOS_phi")
+muOS_pt = Quantity("muOS_pt", ctype="float")
+muOS_eta = Quantity("muOS_eta", ctype="float")
+muOS_phi = Quantity("muOS_phi", ctype="float")
 muOS_mass = Quantity("muOS_mass")
 
-muSS_pt = Quantity("muSS_pt")
-muSS_eta = Quantity("muSS_eta")
-muSS_phi = Quantity("muSS_phi")
+muSS_pt = Quantity("muSS_pt", ctype="float")
+muSS_eta = Quantity("muSS_eta", ctype="float")
+muSS_phi = Quantity("muSS_phi", ctype="float")
 muSS_mass = Quantity("muSS_mass")
 
-lep1_fromZ_pt = Quantity("lep1_fromZ_pt")
-lep1_fromZ_eta = Quantity("lep1_fromZ_eta")
-lep1_fromZ_phi = Quantity("lep1_fromZ_phi")
+lep1_fromZ_pt = Quantity("lep1_fromZ_pt", ctype="float")
+lep1_fromZ_eta = Quantity("lep1_fromZ_eta", ctype="float")
+lep1_fromZ_phi = Quantity("lep1_fromZ_phi", ctype="float")
 lep1_fromZ_mass = Quantity("lep1_fromZ_mass")
 
-lep2_fromZ_pt = Quantity("lep2_fromZ_pt")
-lep2_fromZ_eta = Quantity("lep2_fromZ_eta")
-lep2_fromZ_phi = Quantity("lep2_fromZ_phi")
+lep2_fromZ_pt = Quantity("lep2_fromZ_pt", ctype="float")
+lep2_fromZ_eta = Quantity("lep2_fromZ_eta", ctype="float")
+lep2_fromZ_phi = Quantity("lep2_fromZ_phi", ctype="float")
 lep2_fromZ_mass = Quantity("lep2_fromZ_mass")
 
-Z_pt = Quantity("Z_pt")
-Z_eta = Quantity("Z_eta")
-Z_phi = Quantity("Z_phi")
-Z_mass = Quantity("Z_mass")
+Z_pt = Quantity("Z_pt", ctype="float")
+Z_eta = Quantity("Z_eta", ctype="float")
+Z_phi = Quantity("Z_phi", ctype="float")
+Z_mass = Quantity("Z_mass", ctype="float")
 
 genmet_p4 = Quantity("genmet_p4")
 dimuon_gen_collection = Quantity("dimuon_gen_collection")
 genmuon_leadingp4_H = Quantity("genmuon_leadingp4_H")
 genmuon_subleadingp4_H = Quantity("genmuon_subleadingp4_H")
 
-genmu1_fromH_pt = Quantity("genmu1_fromH_pt")
-genmu1_fromH_eta = Quantity("genmu1_fromH_eta")
-genmu1_fromH_phi = Quantity("genmu1_fromH_phi")
-genmu1_fromH_mass = Quantity("genmu1_fromH_mass")
+genmu1_fromH_pt = Quantity("genmu1_fromH_pt", ctype="float")
+genmu1_fromH_eta = Quantity("genmu1_fromH_eta", ctype="float")
+genmu1_fromH_phi = Quantity("genmu1_fromH_phi", ctype="float")
+genmu1_fromH_mass = Quantity("genmu1_fromH_mass", ctype="float")
 
-genmu2_fromH_pt = Quantity("genmu2_fromH_pt")
-genmu2_fromH_eta = Quantity("genmu2_fromH_eta")
-genmu2_fromH_phi = Quantity("genmu2_fromH_phi")
-genmu2_fromH_mass = Quantity("genmu2_fromH_mass")
+genmu2_fromH_pt = Quantity("genmu2_fromH_pt", ctype="float")
+genmu2_fromH_eta = Quantity("genmu2_fromH_eta", ctype="float")
+genmu2_fromH_phi = Quantity("genmu2_fromH_phi", ctype="float")
+genmu2_fromH_mass = Quantity("genmu2_fromH_mass", ctype="float")
 
-BosonDecayMode = Quantity("BosonDecayMode")
+BosonDecayMode = Quantity("BosonDecayMode", ctype="int")
 
 # nnmm control region
 dimuon_ZControl_collection = Quantity("dimuon_ZControl_collection")
-Flag_DiMuonFromCR = Quantity("Flag_DiMuonFromCR")
+Flag_DiMuonFromCR = Quantity("Flag_DiMuonFromCR", ctype="int")
 dimuon_p4_CR = Quantity("dimuon_p4_CR")
-dimuonCR_pt = Quantity("dimuonCR_pt")
-dimuonCR_eta = Quantity("dimuonCR_eta")
-dimuonCR_phi = Quantity("dimuonCR_phi")
-dimuonCR_mass = Quantity("dimuonCR_mass")
+dimuonCR_pt = Quantity("dimuonCR_pt", ctype="float")
+dimuonCR_eta = Quantity("dimuonCR_eta", ctype="float")
+dimuonCR_phi = Quantity("dimuonCR_phi", ctype="float")
+dimuonCR_mass = Quantity("dimuonCR_mass", ctype="float")
 
 elemu_TopControl_collection = Quantity("elemu_TopControl_collection")
-Flag_EleMuFromCR = Quantity("Flag_EleMuFromCR")
+Flag_EleMuFromCR = Quantity("Flag_EleMuFromCR", ctype="int")
 elemu_p4_CR = Quantity("elemu_p4_CR")
-elemuCR_pt = Quantity("elemuCR_pt")
-elemuCR_eta = Quantity("elemuCR_eta")
-elemuCR_phi = Quantity("elemuCR_phi")
-elemuCR_mass = Quantity("elemuCR_mass")
\ No newline at end of file
+elemuCR_pt = Quantity("elemuCR_pt", ctype="float")
+elemuCR_eta = Quantity("elemuCR_eta", ctype="float")
+elemuCR_phi = Quantity("elemuCR_phi", ctype="float")
+elemuCR_mass = Quantity("elemuCR_mass", ctype="float")
\ No newline at end of file
@@ -23,6 +23,114 @@ from code_generation.rules import RemoveProducer, AppendProducer
 from code_generation.systematics import SystematicShift
 
 
+# hlt paths packed into the trigger bitmask of the global scope, the bit of a
+# path is its position in the list of its era
+HLT_PATHS = {
+    "2022": ["HLT_IsoMu24", "HLT_IsoMu27"],
+    "2018": ["HLT_IsoMu24", "HLT_IsoMu27"],
+    "2017": ["HLT_IsoMu24", "HLT_IsoMu27"],
+    "2016": ["HLT_IsoMu22"],
+}
+
+# primary datasets of data ordered by their priority, with the hlt paths of each
+# dataset, used by the overlap veto between the primary datasets. Each path is
+# read as one input of the veto, so every entry has to match at most one path.
+PD_TRIGGERS = {
+    "2022": [
+        (
+            "Muon",
+            [
+                "HLT_IsoMu24",
+                "HLT_IsoMu27",
+                "HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8",
+            ],
+        ),
+        (
+            "MuonEG",
+            [
+                "HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ",
+                "HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ",
+            ],
+        ),
+        (
+            "EGamma",
+            ["HLT_Ele32_WPTight_Gsf", "HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL"],
+        ),
+    ],
+    "2018": [
+        ("SingleMuon", ["HLT_IsoMu24", "HLT_IsoMu27"]),
+        ("DoubleMuon", ["HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8"]),
+        (
+            "MuonEG",
+            [
+                "HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ",
+                "HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ",
+            ],
+        ),
+        (
+            "EGamma",
+            ["HLT_Ele32_WPTight_Gsf", "HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL"],
+        ),
+    ],
+    "2017": [
+        ("SingleMuon", ["HLT_IsoMu24", "HLT_IsoMu27"]),
+        ("DoubleMuon", ["HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass8"]),
+        (
+            "MuonEG",
+            [
+                "HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ",
+                "HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ",
+            ],
+        ),
+        ("SingleElectron", ["HLT_Ele35_WPTight_Gsf"]),
+        ("DoubleEG", ["HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL"]),
+    ],
+    "2016": [
+        (
+            "SingleMuon",
+            ["HLT_IsoMu22", "HLT_IsoTkMu22", "HLT_IsoMu24", "HLT_IsoTkMu24"],
+        ),
+        (
+            "DoubleMuon",
+            [
+                "HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL",
+                "HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ",
+                "HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL",
+                "HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ",
+            ],
+        ),
+        (
+            "MuonEG",
+            [
+                "HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL",
+                "HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ",
+                "HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL",
+                "HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ",
+            ],
+        ),
+        ("SingleElectron", ["HLT_Ele25_eta2p1_WPTight_Gsf", "HLT_Ele27_WPTight_Gsf"]),
+        ("DoubleEG", ["HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ"]),
+    ],
+}
+
+
+def add_hlt_bits(triggers: dict) -> dict:
+    """Set the "hlt_bit" of each trigger to the position of its "hlt_path" in
+    the trigger bitmask of the era, so that the bits can not go out of sync
+    with HLT_PATHS."""
+    for era, era_triggers in triggers.items():
+        for trigger in era_triggers:
+            if trigger["hlt_path"] not in HLT_PATHS[era]:
+                raise ValueError(
+                    "hlt path {} of trigger {} is not part of the trigger "
+                    "bitmask of era {}".format(
+                        trigger["hlt_path"], trigger["flagname"], era
+                    )
+                )
+            trigger["hlt_bit"] = HLT_PATHS[era].index(trigger["hlt_path"])
+    return triggers
+
+
 def build_config(
     era: str,
     sample: str,
@@ -31,6 +139,7 @@ def build_config(
     available_sample_types: List[str],
     available_eras: List[str],
     available_scopes: List[str],
+    systematics_backend: str = "duplicate",
 ):
 
     configuration = Configuration(
@@ -41,6 +150,7 @@ def build_config(
         available_sample_types,
         available_eras,
         available_scopes,
+        systematics_backend=systematics_backend,
     )
 
     configuration.add_config_parameters(
@@ -115,10 +225,52 @@ def build_config(
     )
 
     # vh add triggers (copying htautau mtau TODO)
+    # the hlt paths are packed into one bitmask in the global scope
+    configuration.add_config_parameters(
+        "global",
+        {
+            "hlt_paths": EraModifier(
+                {
+                    era: ", ".join('"{}"'.format(path) for path in paths)
+                    for era, paths in HLT_PATHS.items()
+                }
+            ),
+        },
+    )
+    # overlap removal between the primary datasets of data: an event is only kept
+    # in the first of these datasets whose triggers fired, see PD_TRIGGERS
+    configuration.add_config_parameters(
+        "global",
+        {
+            "pd_priority": EraModifier(
+                {
+                    era: ", ".join('"{}"'.format(pd) for pd, _ in datasets)
+                    for era, datasets in PD_TRIGGERS.items()
+                }
+            ),
+            "pd_trigger_datasets": EraModifier(
+                {
+                    era: ", ".join(
+                        '"{}"'.format(pd) for pd, paths in datasets for _ in paths
+                    )
+                    for era, datasets in PD_TRIGGERS.items()
+                }
+            ),
+            "pd_triggers": EraModifier(
+                {
+                    era: ", ".join(
+                        '"{}"'.format(path) for _, paths in datasets for path in paths
+                    )
+                    for era, datasets in PD_TRIGGERS.items()
+                }
+            ),
+        },
+    )
     configuration.add_config_parameters(
         ["e2m","m2m","eemm","mmmm","nnmm","nnmm_dycontrol","nnmm_topcontrol"],
         {
             "singlemuon_trigger": EraModifier(
+                add_hlt_bits(
                 {
                 # vh TODO update pT threshold in trigger matching
                     "2022": [
@@ -193,6 +345,7 @@ def build_config(
                         },
                     ],
                 }
+                )
             ),
         },
     )
@@ -406,6 +559,7 @@ def build_config(
         "m2m",
         {
             "vh_m2m_nmuons" : 3,
+            "min_base_muons" : 3,
             "min_dimuon_mass" : 12,
             "flag_DiMuonFromHiggs" : 1,
             "flag_Ele_Veto" : 1,
@@ -419,6 +573,8 @@ def build_config(
         {
             "vh_e2m_nmuons" : 2,
             "vh_e2m_nelectrons" : 1,
+            "min_base_muons" : 2,
+            "min_base_electrons" : 1,
             "min_dimuon_mass" : 12,
             "flag_DiMuonFromHiggs" : 1,
             "flag_LeptonChargeSumVeto" : 1,
@@ -429,6 +585,8 @@ def build_config(
         {
             "vh_2e2m_nmuons" : 2,
             "vh_2e2m_nelectrons" : 2,
+            "min_base_muons" : 2,
+            "min_base_electrons" : 2,
             "min_dimuon_mass" : 12,
             "min_dielectron_mass" : 12,
             "flag_DiMuonFromHiggs" : 1,
@@ -440,6 +598,7 @@ def build_config(
         "mmmm",
         {
             "vh_4m_nmuons" : 4,
+            "min_base_muons" : 4,
             "min_dimuon_mass" : 12,
             "flag_DiMuonFromHiggs" : 1,
             "flag_Ele_Veto" : 1,
@@ -450,6 +609,7 @@ def build_config(
         "nnmm",
         {
             "vh_nnmm_nmuons" : 2,
+            "min_base_muons" : 2,
             "min_met" : 50.0,
             "min_dimuon_mass" : 12,
             "flag_DiMuonFromHiggs" : 1,
@@ -462,6 +622,7 @@ def build_config(
         "nnmm_dycontrol", # DY control region m(mumu) from 70 to 110
         {
             "vh_nnmm_nmuons" : 2,
+            "min_base_muons" : 2,
             "min_met" : 50.0,
             "min_dimuon_mass" : 12,
             "flag_DiMuonFromCR" : 1,
@@ -475,6 +636,8 @@ def build_config(
         {
             "vh_nnmm_topcontrol_nmuons" : 1,
             "vh_nnmm_topcontrol_neles" : 1,
+            "min_base_muons" : 1,
+            "min_base_electrons" : 1,
             "min_met" : 50.0,
             "flag_EleMuFromTopCR" : 1,
             "flag_LeptonChargeSumVeto" : 2,
@@ -496,11 +659,14 @@ def build_config(
             event.SampleFlags,
             event.PUweights,
             event.Lumi,
-            event.MetFilter,
+            event.MetFilters,
+            triggers.HLTBitset,
             muons.BaseMuons, # vh
+            muons.NumberOfBaseMuons,
             # vh muon Rochester corr, FSR recovery, GeoFit? TODO
             # vh muon FSR recovery
             electrons.BaseElectrons,
+            electrons.NumberOfBaseElectronsGlobal,
             jets.JetEnergyCorrection, # vh include pt corr and mass corr
             jets.GoodJets, # vh overlap removal with ?base? muons done [need validation]
             jets.GoodBJetsLoose, # vh TODO update btag
@@ -525,6 +691,7 @@ def build_config(
     configuration.add_producers(
         "m2m",
         [
+            event.PreselectionBaseMuons,
             muons.GoodMuons, # vh tighter selections on muons
             muons.NumberOfGoodMuons,
             event.FilterNMuons, # vh ==3 muons
@@ -588,6 +755,7 @@ def build_config(
             muons.LVMu1,
             muons.LVMu2,
             muons.LVMu3,
+            triggers.SingleMuonTriggerMatches,
             triggers.GenerateSingleMuonTriggerFlags, # vh check trigger matching TODO
             # vh the trigger-matched muon should have pT > 29 (26) for 2017 (2016,18)
             
@@ -623,6 +791,8 @@ def build_config(
     configuration.add_producers(
         "e2m",
         [
+            event.PreselectionBaseMuons,
+            event.PreselectionBaseElectrons,
             muons.GoodMuons, # missing good muons selection in NOTE
             muons.NumberOfGoodMuons,
             event.FilterNMuons_e2m, # nmuons == 2
@@ -682,6 +852,7 @@ def build_config(
             #
             muons.LVMu1,
             muons.LVMu2,
+            triggers.SingleMuonTriggerMatches,
             triggers.GenerateSingleMuonTriggerFlagsForDiMuChannel,
             
             scalefactors.MuonIDIso_SF, # TODO 3 muon SF
@@ -716,6 +887,8 @@ def build_config(
     configuration.add_producers(
         "eemm",
         [
+            event.PreselectionBaseMuons,
+            event.PreselectionBaseElectrons,
             muons.GoodMuons, # missing good muons selection in NOTE
             muons.NumberOfGoodMuons,
             event.FilterNMuons_2e2m,
@@ -762,6 +935,7 @@ def build_config(
             #
             muons.LVMu1,
             muons.LVMu2,
+            triggers.SingleMuonTriggerMatches,
             triggers.GenerateSingleMuonTriggerFlagsForDiMuChannel,
             
             scalefactors.MuonIDIso_SF,
@@ -797,6 +971,7 @@ def build_config(
     configuration.add_producers(
         "mmmm",
         [
+            event.PreselectionBaseMuons,
             muons.GoodMuons,
             muons.NumberOfGoodMuons,
             event.FilterNMuons_4m, # vh == 4 muons
@@ -843,6 +1018,7 @@ def build_config(
             muons.LVMu2,
             muons.LVMu3,
             muons.LVMu4,
+            triggers.SingleMuonTriggerMatches,
             triggers.GenerateSingleMuonTriggerFlagsForQuadMuChannel,
             
             scalefactors.MuonIDIso_SF,
@@ -877,6 +1053,7 @@ def build_config(
     configuration.add_producers(
         "nnmm",
         [
+            event.PreselectionBaseMuons,
             muons.GoodMuons, # vh tighter selections on muons
             muons.NumberOfGoodMuons,
             event.FilterNMuons_nnmm, # vh nnmm ==2 muons
@@ -917,6 +1094,7 @@ def build_config(
             #scalefactors.MuonIDIso_SF, # TODO 3 muon SF
             muons.LVMu1,
             muons.LVMu2,
+            triggers.SingleMuonTriggerMatches,
             triggers.GenerateSingleMuonTriggerFlagsForDiMuChannel,
             # vh the trigger-matched muon should have pT > 29 (26) for 2017 (2016,18)
             scalefactors.MuonIDIso_SF,
@@ -952,6 +1130,7 @@ def build_config(
     configuration.add_producers(
         "nnmm_dycontrol",
         [
+            event.PreselectionBaseMuons,
             muons.GoodMuons, # vh tighter selections on muons
             muons.NumberOfGoodMuons,
             event.FilterNMuons_nnmm, # vh nnmm ==2 muons
@@ -988,6 +1167,8 @@ def build_config(
     configuration.add_producers(
         "nnmm_topcontrol",
         [
+            event.PreselectionBaseMuons,
+            event.PreselectionBaseElectrons,
             muons.GoodMuons, # vh tighter selections on muons
             muons.NumberOfGoodMuons,
             electrons.NumberOfBaseElectrons,
@@ -1435,7 +1616,11 @@ def build_config(
     configuration.add_modification_rule(
         "global",
         AppendProducer(
-            producers=[jets.RenameJetsData, event.JSONFilter,],
+            producers=[
+                jets.RenameJetsData,
+                event.JSONFilter,
+                event.PrimaryDatasetOverlapVeto,
+            ],
             samples=["data"],
             update_output=False,
         ),
@@ -5,6 +5,7 @@
 #include "ROOT/RDFHelpers.hxx"
 #include "ROOT/RDataFrame.hxx"
 #include "ROOT/RVec.hxx"
+#include "utility/IndexAccess.hxx"
 #include "utility/Logger.hxx"
 #include "utility/RooFunctorThreadsafe.hxx"
 #include "utility/utility.hxx"
@@ -31,6 +32,21 @@ inline ROOT::RDF::RNode FilterThreshold(ROOT::RDF::RNode df,
     return df.Filter( quantity + " " + relation + " " + std::to_string(threshold), filtername);
 }
 
+/// Function to filter events with a boolean expression, which is compiled
+/// at runtime. This is used for the preselection derived from the filters of
+/// all scopes during the code generation.
+///
+/// \param df The input dataframe
+/// \param expression The expression, events for which it is false are rejected
+/// \param filtername The name of the filter, used in the Dataframe report
+///
+/// \returns a filtered dataframe
+inline ROOT::RDF::RNode FilterExpression(ROOT::RDF::RNode df,
+                                         const std::string &expression,
+                                         const std::string &filtername) {
+    return df.Filter(expression, filtername);
+}
+
 /**
  * @brief Function to filter events based on their run and luminosity block
  * values
@@ -109,17 +125,8 @@ ROOT::RDF::RNode getvar(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(
         outputname,
         [position](const ROOT::RVec<int> &vec, const ROOT::RVec<T> &col) {
-            T out = default_value<T>();
-
-            try {
-                const int index = vec.at(position);
-                out = col.at(index, default_value<T>());
-            } catch (const std::out_of_range &e) {
-                Logger::get("getvar")->debug(
-                    "Index not found, retuning dummy value !");
-            }
-
-            return out;
+            const int index = utility::index::Position(vec, position);
+            return utility::index::Load(col, index, default_value<T>());
         },
         {vecname, column});
 }
@@ -139,7 +146,8 @@ ROOT::RDF::RNode getvar(ROOT::RDF::RNode df, const std::string &outputname,
                         const std::string &column) {
     return df.Define(outputname,
                      [](const int &pos, const ROOT::RVec<T> &col) {
-                         return col.at(pos, default_value<T>());
+                         return utility::index::Load(col, pos,
+                                                     default_value<T>());
                      },
                      {position, column});
 }
@@ -175,10 +183,8 @@ inline ROOT::RDF::RNode FilterFlagsAny(ROOT::RDF::RNode df,
     std::vector<std::string> FlagList;
     utility::appendParameterPackToVector(FlagList, flags...);
     const auto nFlags = sizeof...(Flags);
-    using namespace ROOT::VecOps;
     return df.Filter(
-        utility::PassAsVec<nFlags, bool>(
-            [](const ROOT::RVec<bool> &flags) { return Any(flags); }),
+        utility::PassAsArgs<nFlags, bool>(utility::combinators::AnyOf()),
         FlagList, filtername);
 }
 
@@ -198,11 +204,9 @@ inline ROOT::RDF::RNode CombineFlagsAny(ROOT::RDF::RNode df,
     std::vector<std::string> FlagList;
     utility::appendParameterPackToVector(FlagList, flags...);
     const auto nFlags = sizeof...(Flags);
-    using namespace ROOT::VecOps;
     return df.Define(
         outputflag,
-        utility::PassAsVec<nFlags, bool>(
-            [](const ROOT::RVec<bool> &flags) { return Any(flags); }),
+        utility::PassAsArgs<nFlags, bool>(utility::combinators::AnyOf()),
         FlagList);
 }
 
@@ -245,11 +249,11 @@ evaluateWorkspaceFunction(ROOT::RDF::RNode df, const std::string &outputname,
                           const Inputs &...inputs) {
     Logger::get("evaluateWorkspaceFunction")
         ->debug("Starting evaluation for {}", outputname);
-    auto getValue = [function](const ROOT::RVec<float> &values) {
+    auto getValue = [function](const auto &...values) {
         Logger::get("evaluateWorkspaceFunction")
             ->debug("Type: {} ", typeid(function).name());
-        std::vector<double> argvalues(values.begin(), values.end());
-        auto result = function->eval(argvalues.data());
+        const double argvalues[] = {static_cast<double>(values)...};
+        auto result = function->eval(argvalues);
         Logger::get("evaluateWorkspaceFunction")->debug("result {}", result);
         return result;
     };
@@ -258,7 +262,7 @@ evaluateWorkspaceFunction(ROOT::RDF::RNode df, const std::string &outputname,
     const auto nInputs = sizeof...(Inputs);
     Logger::get("evaluateWorkspaceFunction")->debug("nInputs: {} ", nInputs);
     auto df1 = df.Define(
-        outputname, utility::PassAsVec<nInputs, float>(getValue), InputList);
+        outputname, utility::PassAsArgs<nInputs, float>(getValue), InputList);
     // change back to ROOT::RDF as soon as fix is available
     return df1;
 }
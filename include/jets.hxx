@@ -37,7 +37,8 @@ JetPtCorrection(ROOT::RDF::RNode df, const std::string &corrected_jet_pt,
                 const std::string &jet_rawFactor, const std::string &jet_ID,
                 const std::string &gen_jet_pt, const std::string &gen_jet_eta,
                 const std::string &gen_jet_phi, const std::string &rho,
-                bool reapplyJES,
+                const std::string &run, const std::string &lumi,
+                const std::string &event, bool reapplyJES,
                 const std::vector<std::string> &jes_shift_sources,
                 const int &jes_shift, const std::string &jer_shift,
                 const std::string &jec_file, const std::string &jer_tag,
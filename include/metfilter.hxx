@@ -1,10 +1,52 @@
 #ifndef GUARDMETFILTER_H
 #define GUARDMETFILTER_H
 
+#include "utility/Bitmask.hxx"
+#include "utility/utility.hxx"
+#include <numeric>
+
 namespace metfilter {
 
 ROOT::RDF::RNode ApplyMetFilter(ROOT::RDF::RNode df,
                                 const std::string &flagname,
                                 const std::string &filtername);
+ROOT::RDF::RNode FilterFailedFlags(ROOT::RDF::RNode df,
+                                   const std::string &filtername,
+                                   const std::string &mask,
+                                   const std::vector<std::string> &flags);
+
+/// Function to apply a list of metfilters to the dataframe in a single
+/// filter. The flags are combined into a bitmask of the failed flags by a
+/// single node reading all flags, which is defined as column
+/// `<filtername>_failed`, and events with an empty mask are kept. Compared to
+/// one filter per flag, the dataframe report contains only a single entry for
+/// all flags, the rejections per flag are counted separately and can be
+/// printed with PrintReports() and written to the output file with
+/// WriteReports().
+///
+/// \param df the dataframe to add the quantity to
+/// \param filtername Name of the Filter to be shown in the dataframe report
+/// \param flags Parameter pack of the names of the Filterflags in NanoAOD, at
+/// most 64
+///
+/// \returns a dataframe with the filter applied
+template <class... Flags>
+inline ROOT::RDF::RNode ApplyMetFilters(ROOT::RDF::RNode df,
+                                        const std::string &filtername,
+                                        const Flags &...flags) {
+    constexpr auto nFlags = sizeof...(Flags);
+    static_assert(nFlags > 0 && nFlags <= 64,
+                  "between 1 and 64 met filters are supported");
+    std::vector<std::string> FlagList;
+    utility::appendParameterPackToVector(FlagList, flags...);
+    std::vector<std::size_t> bits(nFlags);
+    std::iota(bits.begin(), bits.end(), 0);
+    const std::string mask = filtername + "_failed";
+    return FilterFailedFlags(
+        utility::bitmask::Pack<nFlags>(df, mask, FlagList, bits, true),
+        filtername, mask, FlagList);
+}
+void PrintReports();
+void WriteReports();
 } // namespace metfilter
 #endif /* GUARDMETFILTER_H */
\ No newline at end of file
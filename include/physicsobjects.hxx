@@ -1,6 +1,8 @@
 #ifndef GUARD_PHYSICSOBJECTS_H
 #define GUARD_PHYSICSOBJECTS_H
 
+#include "utility/CompactCollection.hxx"
+
 namespace physicsobject {
 /// write by botao
 ROOT::RDF::RNode M_dileptonMass(ROOT::RDF::RNode df, const std::string &outputname,
@@ -220,20 +222,15 @@ template <class... Masks>
 inline ROOT::RDF::RNode CombineMasks(ROOT::RDF::RNode df,
                                      const std::string &maskname,
                                      const Masks &...masks) {
-    auto multiplyMasks = [](const ROOT::RVec<ROOT::RVec<int>> &x) {
-        ROOT::RVec<int> result(x[0].size(), 1);
-        for (auto &xx : x) {
-            result *= xx;
-        }
-        return result;
-    };
     // std::vector<std::string> MaskList{{masks...}}; does weird things in case
     // of two arguments in masks
     std::vector<std::string> MaskList;
     utility::appendParameterPackToVector(MaskList, masks...);
     const auto nMasks = sizeof...(Masks);
     return df.Define(
-        maskname, ROOT::RDF::PassAsVec<nMasks, ROOT::RVec<int>>(multiplyMasks),
+        maskname,
+        utility::PassAsArgs<nMasks, ROOT::RVec<int>>(
+            utility::combinators::MultiplyMasks()),
         MaskList);
 }
 ROOT::RDF::RNode VetoCandInMask(ROOT::RDF::RNode df,
@@ -267,6 +264,31 @@ ROOT::RDF::RNode CheckForDiLeptonPairs(
     const std::string &leptons_phi, const std::string &leptons_mass,
     const std::string &leptons_charge, const std::string &leptons_mask,
     const float dR_cut);
+ROOT::RDF::RNode GatherSelectedObjects(
+    ROOT::RDF::RNode df, const std::string &outputname, const std::string &pt,
+    const std::string &eta, const std::string &phi, const std::string &mass,
+    const std::string &charge, const std::string &mask);
+namespace compact {
+ROOT::RDF::RNode LeptonVetoFlag(ROOT::RDF::RNode df,
+                                const std::string &outputname,
+                                const std::string &collection);
+ROOT::RDF::RNode IsEmptyFlag(ROOT::RDF::RNode df, const std::string &outputname,
+                             const std::string &collection);
+ROOT::RDF::RNode CutNFlag(ROOT::RDF::RNode df, const std::string &outputname,
+                          const std::string &collection, const int &n);
+ROOT::RDF::RNode SelectedObjects(ROOT::RDF::RNode df,
+                                 const std::string &outputname,
+                                 const std::string &collection);
+ROOT::RDF::RNode DeltaRParticleVeto(ROOT::RDF::RNode df,
+                                    const std::string &output_flag,
+                                    const std::string &p4,
+                                    const std::string &collection,
+                                    const float dR_cut);
+ROOT::RDF::RNode CheckForDiLeptonPairs(ROOT::RDF::RNode df,
+                                       const std::string &output_flag,
+                                       const std::string &collection,
+                                       const float dR_cut);
+} // namespace compact
 namespace muon {
 ROOT::RDF::RNode CutID(ROOT::RDF::RNode df, const std::string &maskname,
                        const std::string &nameID);
@@ -275,7 +297,10 @@ ROOT::RDF::RNode CutIsolation(ROOT::RDF::RNode df, const std::string &maskname,
                               const float &Threshold);
 ROOT::RDF::RNode GenerateRndmRVec(ROOT::RDF::RNode df,
                                   const std::string &outputname,
-                                  const std::string &objCollection, int seed);
+                                  const std::string &objCollection,
+                                  const std::string &run,
+                                  const std::string &lumi,
+                                  const std::string &event, int seed);
 ROOT::RDF::RNode
 applyRoccoRData(ROOT::RDF::RNode df, const std::string &outputname,
                 const std::string &filename, const int &position,
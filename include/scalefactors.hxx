@@ -135,6 +135,15 @@ ROOT::RDF::RNode electron_sf(ROOT::RDF::RNode df, const std::string &pt,
                              const std::string correctiontype,
                              const std::string &idAlgorithm,
                              const float &extrapolation_factor = 1.0);
+ROOT::RDF::RNode
+fused_sf(ROOT::RDF::RNode df, const std::string &pt_1,
+         const std::string &eta_1, const std::string &pt_2,
+         const std::string &eta_2, const std::vector<std::string> &outputs,
+         const std::string &sf_file,
+         const std::vector<std::string> &corrections,
+         const std::vector<std::string> &legs,
+         const std::vector<std::string> &correctiontypes,
+         const std::vector<float> &extrapolation_factors);
 } // namespace embedding
 } // namespace scalefactor
 #endif /* GUARD_SCALEFACTORS_H */
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef GUARD_TRIGGERS_H
 #define GUARD_TRIGGERS_H
 
+#include "utility/Bitmask.hxx"
+#include "utility/utility.hxx"
+
 typedef std::bitset<20> IntBits;
 
 namespace trigger {
@@ -68,6 +71,117 @@ ROOT::RDF::RNode GenerateQuadTriggerORFlag(
     const int &p1_trigger_particle_id_cut, const int &p2_trigger_particle_id_cut, const int &p3_trigger_particle_id_cut, const int &p4_trigger_particle_id_cut,
     const int &p1_triggerbit_cut, const int &p2_triggerbit_cut, const int &p3_triggerbit_cut, const int &p4_triggerbit_cut, const float &DeltaR_threshold);
 
+std::vector<std::string>
+MatchHLTPaths(ROOT::RDF::RNode df, const std::vector<std::string> &hltpaths);
+
+/// Function to pack the decisions of a set of HLT paths into a single
+/// per-event bitmask, defined by a single node reading all HLT paths. The bit
+/// position of each path is given by its position in the parameter pack, the
+/// paths are resolved by MatchHLTPaths().
+///
+/// \param df The input dataframe
+/// \param outputname name of the output bitmask column (`ULong64_t`)
+/// \param hltpaths Parameter pack of hlt paths, each entry can be a valid
+/// regex matching at most one HLT path. If no matching HLT path is found for
+/// an entry, the corresponding bit is never set. At most 64 paths are
+/// supported.
+///
+/// \returns a new dataframe containing the bitmask column
+template <class... Paths>
+inline ROOT::RDF::RNode GenerateHLTBitset(ROOT::RDF::RNode df,
+                                          const std::string &outputname,
+                                          const Paths &...hltpaths) {
+    constexpr auto nPaths = sizeof...(Paths);
+    static_assert(nPaths > 0 && nPaths <= 64,
+                  "between 1 and 64 hlt paths are supported");
+    std::vector<std::string> PathList;
+    utility::appendParameterPackToVector(PathList, hltpaths...);
+    const auto matched = MatchHLTPaths(df, PathList);
+    std::vector<std::string> columns;
+    std::vector<std::size_t> bits;
+    for (std::size_t bit = 0; bit < nPaths; ++bit) {
+        if (matched[bit].empty())
+            continue;
+        columns.push_back(matched[bit]);
+        bits.push_back(bit);
+    }
+    return utility::bitmask::Pack<nPaths>(df, outputname, columns, bits);
+}
+
+std::string
+IdentifyPrimaryDataset(const std::vector<std::string> &input_files,
+                       const std::map<std::string, std::string> &datasets);
+
+bool MatchOverlapVetoPaths(ROOT::RDF::RNode df,
+                           const std::vector<std::string> &datasets,
+                           const std::vector<std::string> &path_datasets,
+                           const std::vector<std::string> &paths,
+                           std::vector<std::string> &columns,
+                           std::vector<std::size_t> &bits);
+
+ROOT::RDF::RNode FilterOverlapVeto(ROOT::RDF::RNode df,
+                                   const std::string &filtername,
+                                   const std::string &mask,
+                                   const std::vector<std::string> &datasets);
+
+/// Function to remove the overlap between the primary datasets (PDs) of
+/// data. An event recorded by several triggers is contained in the PD of each
+/// of them. It is only kept in the PD with the highest priority among them,
+/// i.e. it is rejected if any trigger of a PD with a higher priority than the
+/// processed one fired. The processed PD is determined by
+/// IdentifyPrimaryDataset(). The fired PDs are packed into a bitmask by a
+/// single node reading all selected HLT paths. The numbers of processed,
+/// passed and vetoed events are printed with PrintOverlapReports() and
+/// written to the output file with WriteOverlapReports().
+///
+/// \param df The input dataframe
+/// \param filtername name of the filter in the dataframe report
+/// \param datasets the PDs, ordered by their priority starting with the
+/// highest
+/// \param path_datasets the PD of each HLT path
+/// \param paths Parameter pack of the HLT paths of all PDs, see
+/// MatchOverlapVetoPaths()
+///
+/// \returns a dataframe with the veto applied
+template <class... Paths>
+inline ROOT::RDF::RNode
+PrimaryDatasetOverlapVeto(ROOT::RDF::RNode df, const std::string &filtername,
+                          const std::vector<std::string> &datasets,
+                          const std::vector<std::string> &path_datasets,
+                          const Paths &...paths) {
+    constexpr auto nPaths = sizeof...(Paths);
+    static_assert(nPaths > 0, "at least one hlt path is required");
+    std::vector<std::string> PathList;
+    utility::appendParameterPackToVector(PathList, paths...);
+    std::vector<std::string> columns;
+    std::vector<std::size_t> bits;
+    if (!MatchOverlapVetoPaths(df, datasets, path_datasets, PathList, columns,
+                               bits))
+        return df;
+    const std::string mask = filtername + "_fired";
+    return FilterOverlapVeto(
+        utility::bitmask::Pack<nPaths>(df, mask, columns, bits), filtername,
+        mask, datasets);
+}
+
+void PrintOverlapReports();
+void WriteOverlapReports();
+
+ROOT::RDF::RNode GeometricTriggerMatch(
+    ROOT::RDF::RNode df, const std::string &outputname,
+    const std::string &object_etas, const std::string &object_phis,
+    const std::string &triggerobject_bits, const std::string &triggerobject_id,
+    const std::string &triggerobject_eta, const std::string &triggerobject_phi,
+    const std::string &hltbits, const int &hltbit,
+    const int &trigger_particle_id_cut, const int &triggerbit_cut,
+    const float &DeltaR_threshold);
+
+ROOT::RDF::RNode GenerateTriggerORFlagFromMatch(
+    ROOT::RDF::RNode df, const std::string &triggerflag_name,
+    const std::string &collection, const std::string &object_pts,
+    const std::string &object_etas, const std::string &matches,
+    const int &nobjects, const float &pt_cut, const float &eta_cut);
+
 ROOT::RDF::RNode MatchSingleTriggerObject(
     ROOT::RDF::RNode df, const std::string &triggerflag_name,
     const std::string &particle_p4, const std::string &triggerobject_bits,
@@ -0,0 +1,278 @@
+#ifndef GUARDARROWSINK_H
+#define GUARDARROWSINK_H
+
+#include "Logger.hxx"
+#include "ROOT/RDF/ActionHelpers.hxx"
+#include "ROOT/RVec.hxx"
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+#ifdef CROWN_PARQUET_OUTPUT
+#include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
+#endif
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Output sink writing the output columns of a scope as Arrow IPC or Parquet
+/// file from within the event loop, next to the ROOT Snapshot. Each slot
+/// fills its own Arrow builders and converts them into a record batch every
+/// `batch_size` events. The batches of all slots are collected and written
+/// together as one row group (Parquet) or as consecutive record batches (IPC)
+/// once `row_group_size` rows are pending. The CROWN metadata is stored as
+/// schema metadata. Flat columns of arithmetic type and `ROOT::RVec` of them
+/// are supported.
+namespace utility {
+namespace arrowsink {
+
+enum class Format { IPC, Parquet };
+
+inline void Check(const arrow::Status &status) {
+    if (!status.ok())
+        throw std::runtime_error("Arrow output: " + status.ToString());
+}
+
+/// Mapping of a C++ column type to the Arrow type and builder
+template <typename T> struct ArrowColumn;
+
+#define CROWN_ARROW_COLUMN(CTYPE, BUILDER, ARROWTYPE)                          \
+    template <> struct ArrowColumn<CTYPE> {                                    \
+        static std::shared_ptr<arrow::DataType> type() {                       \
+            return arrow::ARROWTYPE();                                         \
+        }                                                                      \
+        static std::shared_ptr<arrow::ArrayBuilder> builder() {                \
+            return std::make_shared<arrow::BUILDER>();                         \
+        }                                                                      \
+        static arrow::Status append(arrow::ArrayBuilder *builder,              \
+                                    const CTYPE &value) {                      \
+            auto typed = static_cast<arrow::BUILDER *>(builder);               \
+            return typed->Append(                                              \
+                static_cast<arrow::BUILDER::value_type>(value));               \
+        }                                                                      \
+    };
+
+CROWN_ARROW_COLUMN(bool, BooleanBuilder, boolean)
+CROWN_ARROW_COLUMN(char, Int8Builder, int8)
+CROWN_ARROW_COLUMN(signed char, Int8Builder, int8)
+CROWN_ARROW_COLUMN(unsigned char, UInt8Builder, uint8)
+CROWN_ARROW_COLUMN(short, Int16Builder, int16)
+CROWN_ARROW_COLUMN(unsigned short, UInt16Builder, uint16)
+CROWN_ARROW_COLUMN(int, Int32Builder, int32)
+CROWN_ARROW_COLUMN(unsigned int, UInt32Builder, uint32)
+CROWN_ARROW_COLUMN(long, Int64Builder, int64)
+CROWN_ARROW_COLUMN(unsigned long, UInt64Builder, uint64)
+CROWN_ARROW_COLUMN(long long, Int64Builder, int64)
+CROWN_ARROW_COLUMN(unsigned long long, UInt64Builder, uint64)
+CROWN_ARROW_COLUMN(float, FloatBuilder, float32)
+CROWN_ARROW_COLUMN(double, DoubleBuilder, float64)
+#undef CROWN_ARROW_COLUMN
+
+/// jagged columns are stored as Arrow list of the element type
+template <typename T> struct ArrowColumn<ROOT::RVec<T>> {
+    static std::shared_ptr<arrow::DataType> type() {
+        return arrow::list(ArrowColumn<T>::type());
+    }
+    static std::shared_ptr<arrow::ArrayBuilder> builder() {
+        return std::make_shared<arrow::ListBuilder>(
+            arrow::default_memory_pool(), ArrowColumn<T>::builder());
+    }
+    static arrow::Status append(arrow::ArrayBuilder *builder,
+                                const ROOT::RVec<T> &values) {
+        auto list = static_cast<arrow::ListBuilder *>(builder);
+        ARROW_RETURN_NOT_OK(list->Append());
+        for (const auto &value : values) {
+            ARROW_RETURN_NOT_OK(
+                ArrowColumn<T>::append(list->value_builder(), value));
+        }
+        return arrow::Status::OK();
+    }
+};
+
+/// RDataFrame action writing the given columns, to be booked via
+/// `df.Book<ColTypes...>(ArrowSink<ColTypes...>(...), columns)`. The result
+/// is the number of written rows.
+template <typename... ColTypes>
+class ArrowSink
+    : public ROOT::Detail::RDF::RActionImpl<ArrowSink<ColTypes...>> {
+  public:
+    using Result_t = ULong64_t;
+
+    /// \param filename the output file
+    /// \param columns the names of the columns, in the order of ColTypes
+    /// \param format the output format
+    /// \param metadata the metadata stored in the schema
+    /// \param nslots the number of slots of the dataframe
+    /// \param batch_size the number of rows of a record batch of one slot
+    /// \param row_group_size the number of rows written at once
+    ArrowSink(const std::string &filename,
+              const std::vector<std::string> &columns, Format format,
+              const std::map<std::string, std::string> &metadata,
+              unsigned int nslots, std::size_t batch_size = 10000,
+              std::size_t row_group_size = 100000)
+        : filename_(filename), format_(format), batch_size_(batch_size),
+          row_group_size_(row_group_size),
+          rows_(std::make_shared<Result_t>(0)),
+          state_(std::make_unique<State>()) {
+        if (columns.size() != sizeof...(ColTypes))
+            throw std::runtime_error("Arrow output: number of columns and "
+                                     "types do not match");
+        std::vector<std::shared_ptr<arrow::DataType>> types = {
+            ArrowColumn<ColTypes>::type()...};
+        std::vector<std::shared_ptr<arrow::Field>> fields;
+        for (std::size_t i = 0; i < columns.size(); ++i)
+            fields.push_back(arrow::field(columns[i], types[i]));
+        std::vector<std::string> keys, values;
+        for (auto const &[key, value] : metadata) {
+            keys.push_back(key);
+            values.push_back(value);
+        }
+        schema_ =
+            arrow::schema(fields, arrow::key_value_metadata(keys, values));
+        builders_.resize(nslots);
+        for (auto &slot : builders_)
+            slot = {ArrowColumn<ColTypes>::builder()...};
+        counts_.resize(nslots, 0);
+    }
+    ArrowSink(ArrowSink &&) = default;
+    ArrowSink(const ArrowSink &) = delete;
+
+    std::shared_ptr<Result_t> GetResultPtr() const { return rows_; }
+
+    void Initialize() {
+        auto stream = arrow::io::FileOutputStream::Open(filename_);
+        Check(stream.status());
+        state_->stream = *stream;
+        if (format_ == Format::IPC) {
+            auto writer =
+                arrow::ipc::MakeFileWriter(state_->stream, schema_);
+            Check(writer.status());
+            state_->ipc_writer = *writer;
+        } else {
+#ifdef CROWN_PARQUET_OUTPUT
+            auto properties = parquet::WriterProperties::Builder()
+                                  .compression(parquet::Compression::ZSTD)
+                                  ->build();
+            auto arrow_properties = parquet::ArrowWriterProperties::Builder()
+                                        .store_schema()
+                                        ->build();
+            auto writer = parquet::arrow::FileWriter::Open(
+                *schema_, arrow::default_memory_pool(), state_->stream,
+                properties, arrow_properties);
+            Check(writer.status());
+            state_->parquet_writer = std::move(*writer);
+#else
+            throw std::runtime_error(
+                "Parquet output requested, but CROWN was built without "
+                "Parquet support, use -DARROW_OUTPUT=parquet");
+#endif
+        }
+    }
+
+    void InitTask(TTreeReader *, unsigned int) {}
+
+    void Exec(unsigned int slot, const ColTypes &...values) {
+        Append(slot, std::index_sequence_for<ColTypes...>{}, values...);
+        if (++counts_[slot] >= batch_size_)
+            FlushSlot(slot);
+    }
+
+    void Finalize() {
+        for (unsigned int slot = 0; slot < builders_.size(); ++slot)
+            FlushSlot(slot);
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        WritePending();
+        if (state_->ipc_writer)
+            Check(state_->ipc_writer->Close());
+#ifdef CROWN_PARQUET_OUTPUT
+        if (state_->parquet_writer)
+            Check(state_->parquet_writer->Close());
+#endif
+        Check(state_->stream->Close());
+        Logger::get("ArrowSink")
+            ->info("Wrote {} rows to {}", *rows_, filename_);
+    }
+
+    std::string GetActionName() { return "ArrowSink"; }
+
+  private:
+    struct State {
+        std::mutex mutex;
+        std::shared_ptr<arrow::io::FileOutputStream> stream;
+        std::shared_ptr<arrow::ipc::RecordBatchWriter> ipc_writer;
+#ifdef CROWN_PARQUET_OUTPUT
+        std::unique_ptr<parquet::arrow::FileWriter> parquet_writer;
+#endif
+        std::vector<std::shared_ptr<arrow::RecordBatch>> pending;
+        std::size_t pending_rows = 0;
+    };
+
+    template <std::size_t... I>
+    void Append(unsigned int slot, std::index_sequence<I...>,
+                const ColTypes &...values) {
+        (Check(ArrowColumn<ColTypes>::append(builders_[slot][I].get(),
+                                             values)),
+         ...);
+    }
+
+    /// convert the builders of a slot into a record batch and add it to the
+    /// pending batches
+    void FlushSlot(unsigned int slot) {
+        if (counts_[slot] == 0)
+            return;
+        std::vector<std::shared_ptr<arrow::Array>> arrays;
+        for (auto &builder : builders_[slot]) {
+            std::shared_ptr<arrow::Array> array;
+            Check(builder->Finish(&array));
+            arrays.push_back(array);
+        }
+        auto batch = arrow::RecordBatch::Make(schema_, counts_[slot], arrays);
+        counts_[slot] = 0;
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->pending.push_back(batch);
+        state_->pending_rows += batch->num_rows();
+        if (state_->pending_rows >= row_group_size_)
+            WritePending();
+    }
+
+    /// write all pending batches, has to be called with the lock held
+    void WritePending() {
+        if (state_->pending_rows == 0)
+            return;
+        auto table =
+            arrow::Table::FromRecordBatches(schema_, state_->pending);
+        Check(table.status());
+        if (state_->ipc_writer) {
+            Check(state_->ipc_writer->WriteTable(**table));
+        }
+#ifdef CROWN_PARQUET_OUTPUT
+        if (state_->parquet_writer) {
+            auto combined = (*table)->CombineChunks();
+            Check(combined.status());
+            Check(state_->parquet_writer->WriteTable(**combined,
+                                                     state_->pending_rows));
+        }
+#endif
+        *rows_ += state_->pending_rows;
+        state_->pending.clear();
+        state_->pending_rows = 0;
+    }
+
+    std::string filename_;
+    Format format_;
+    std::size_t batch_size_;
+    std::size_t row_group_size_;
+    std::shared_ptr<Result_t> rows_;
+    std::unique_ptr<State> state_;
+    std::shared_ptr<arrow::Schema> schema_;
+    std::vector<std::vector<std::shared_ptr<arrow::ArrayBuilder>>> builders_;
+    std::vector<std::size_t> counts_;
+};
+} // namespace arrowsink
+} // namespace utility
+
+#endif /* GUARDARROWSINK_H */
@@ -0,0 +1,251 @@
+#ifndef GUARDASYNCSNAPSHOT_H
+#define GUARDASYNCSNAPSHOT_H
+
+#include "Compression.h"
+#include "Logger.hxx"
+#include "ROOT/RDF/ActionHelpers.hxx"
+#include "ROOT/RSnapshotOptions.hxx"
+#include "TFile.h"
+#include "TROOT.h"
+#include "TTree.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/// Snapshot for single-threaded executables, which moves the filling,
+/// compression and writing of the output tree to a background thread. The
+/// event loop copies the output values of each event into a chunk of
+/// `chunk_size` events. Full chunks are handed to the writer thread via a
+/// bounded queue, so at most `max_chunks` chunks are held in memory. If the
+/// queue is full, the event loop waits for the writer. At the end of the run,
+/// the time spent by the writer, the part of it that overlapped with the
+/// event loop and the time the event loop was blocked are reported.
+///
+/// The output tree contains the same branches as the one written by
+/// `Snapshot`.
+namespace utility {
+namespace asyncsnapshot {
+
+template <typename... ColTypes>
+class AsyncSnapshot
+    : public ROOT::Detail::RDF::RActionImpl<AsyncSnapshot<ColTypes...>> {
+  public:
+    using Result_t = ULong64_t;
+    using clock = std::chrono::steady_clock;
+
+    /// \param treename the name of the output tree
+    /// \param filename the output file
+    /// \param columns the names of the columns, in the order of ColTypes
+    /// \param options the snapshot options, the compression settings and the
+    /// autoflush setting are used
+    /// \param chunk_size the number of events handed to the writer at once
+    /// \param max_chunks the maximal number of chunks held in memory
+    AsyncSnapshot(const std::string &treename, const std::string &filename,
+                  const std::vector<std::string> &columns,
+                  const ROOT::RDF::RSnapshotOptions &options,
+                  std::size_t chunk_size = 1000, std::size_t max_chunks = 4)
+        : treename_(treename), filename_(filename), columns_(columns),
+          options_(options), chunk_size_(chunk_size), max_chunks_(max_chunks),
+          rows_(std::make_shared<Result_t>(0)),
+          state_(std::make_unique<State>()) {
+        if (columns.size() != sizeof...(ColTypes))
+            throw std::runtime_error("AsyncSnapshot: number of columns and "
+                                     "types do not match");
+    }
+    AsyncSnapshot(AsyncSnapshot &&) = default;
+    AsyncSnapshot(const AsyncSnapshot &) = delete;
+    ~AsyncSnapshot() {
+        if (state_ && state_->writer.joinable()) {
+            Stop();
+            state_->writer.join();
+        }
+    }
+
+    std::shared_ptr<Result_t> GetResultPtr() const { return rows_; }
+
+    void Initialize() {
+        // the writer creates and fills the output tree concurrently to the
+        // event loop reading the input, so ROOT has to be made thread-safe
+        // before the writer thread is started
+        ROOT::EnableThreadSafety();
+        state_->loop_start = clock::now();
+        state_->current = NewChunk();
+        state_->writer = std::thread([this] { Write(); });
+    }
+
+    void InitTask(TTreeReader *, unsigned int) {}
+
+    void Exec(unsigned int, const ColTypes &...values) {
+        Store(std::index_sequence_for<ColTypes...>{}, values...);
+        if (++state_->current->size == chunk_size_)
+            Push();
+    }
+
+    void Finalize() {
+        const auto loop_end = clock::now();
+        if (state_->current->size > 0)
+            Push();
+        Stop();
+        state_->writer.join();
+        if (state_->error)
+            std::rethrow_exception(state_->error);
+        const double loop = seconds(loop_end - state_->loop_start);
+        const double tail = seconds(clock::now() - loop_end);
+        const double busy = state_->writer_busy;
+        const double overlap = std::max(busy - tail, 0.);
+        Logger::get("AsyncSnapshot")
+            ->info("{}: {} events written, event loop {:.2f} s, writer busy "
+                   "{:.2f} s, overlapping with the event loop {:.2f} s "
+                   "({:.1f} %), event loop blocked by the writer {:.2f} s, "
+                   "max. {} chunks of {} events queued",
+                   filename_, *rows_, loop, busy, overlap,
+                   busy > 0. ? 100. * overlap / busy : 0.,
+                   state_->producer_blocked, state_->max_queued, chunk_size_);
+    }
+
+    std::string GetActionName() { return "AsyncSnapshot"; }
+
+  private:
+    struct Chunk {
+        std::tuple<std::vector<ColTypes>...> columns;
+        std::size_t size = 0;
+    };
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::unique_ptr<Chunk>> queue;
+        std::unique_ptr<Chunk> current;
+        bool done = false;
+        std::thread writer;
+        std::exception_ptr error;
+        clock::time_point loop_start;
+        double writer_busy = 0.;
+        double producer_blocked = 0.;
+        std::size_t max_queued = 0;
+    };
+
+    static double seconds(clock::duration duration) {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    std::unique_ptr<Chunk> NewChunk() const {
+        auto chunk = std::make_unique<Chunk>();
+        std::apply(
+            [this](auto &...column) { (column.resize(chunk_size_), ...); },
+            chunk->columns);
+        return chunk;
+    }
+
+    template <std::size_t... I>
+    void Store(std::index_sequence<I...>, const ColTypes &...values) {
+        const std::size_t row = state_->current->size;
+        ((std::get<I>(state_->current->columns)[row] = values), ...);
+    }
+
+    /// hand the current chunk to the writer, waiting if the queue is full
+    void Push() {
+        {
+            std::unique_lock<std::mutex> lock(state_->mutex);
+            const auto start = clock::now();
+            state_->cv.wait(lock, [this] {
+                return state_->queue.size() < max_chunks_ || state_->error;
+            });
+            state_->producer_blocked += seconds(clock::now() - start);
+            if (state_->error)
+                std::rethrow_exception(state_->error);
+            state_->queue.push_back(std::move(state_->current));
+            state_->max_queued =
+                std::max(state_->max_queued, state_->queue.size());
+        }
+        state_->cv.notify_all();
+        state_->current = NewChunk();
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->done = true;
+        }
+        state_->cv.notify_all();
+    }
+
+    /// the writer thread, owning the output file and tree
+    void Write() {
+        try {
+            TFile file(filename_.c_str(), "RECREATE", "",
+                       ROOT::CompressionSettings(options_.fCompressionAlgorithm,
+                                                 options_.fCompressionLevel));
+            // the tree is owned by the file
+            auto tree = new TTree(treename_.c_str(), treename_.c_str());
+            if (options_.fAutoFlush != 0)
+                tree->SetAutoFlush(options_.fAutoFlush);
+            std::tuple<ColTypes...> row;
+            Branch(*tree, row, std::index_sequence_for<ColTypes...>{});
+            while (true) {
+                std::unique_ptr<Chunk> chunk;
+                {
+                    std::unique_lock<std::mutex> lock(state_->mutex);
+                    state_->cv.wait(lock, [this] {
+                        return !state_->queue.empty() || state_->done;
+                    });
+                    if (state_->queue.empty())
+                        break;
+                    chunk = std::move(state_->queue.front());
+                    state_->queue.pop_front();
+                }
+                state_->cv.notify_all();
+                const auto start = clock::now();
+                for (std::size_t i = 0; i < chunk->size; ++i) {
+                    Load(row, *chunk, i,
+                         std::index_sequence_for<ColTypes...>{});
+                    tree->Fill();
+                }
+                *rows_ += chunk->size;
+                state_->writer_busy += seconds(clock::now() - start);
+            }
+            const auto start = clock::now();
+            tree->Write();
+            file.Close();
+            state_->writer_busy += seconds(clock::now() - start);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->error = std::current_exception();
+            state_->cv.notify_all();
+        }
+    }
+
+    template <std::size_t... I>
+    void Branch(TTree &tree, std::tuple<ColTypes...> &row,
+                std::index_sequence<I...>) {
+        (tree.Branch(columns_[I].c_str(), &std::get<I>(row)), ...);
+    }
+
+    template <std::size_t... I>
+    static void Load(std::tuple<ColTypes...> &row, Chunk &chunk,
+                     std::size_t i, std::index_sequence<I...>) {
+        ((std::get<I>(row) = std::move(std::get<I>(chunk.columns)[i])), ...);
+    }
+
+    std::string treename_;
+    std::string filename_;
+    std::vector<std::string> columns_;
+    ROOT::RDF::RSnapshotOptions options_;
+    std::size_t chunk_size_;
+    std::size_t max_chunks_;
+    std::shared_ptr<Result_t> rows_;
+    std::unique_ptr<State> state_;
+};
+} // namespace asyncsnapshot
+} // namespace utility
+
+#endif /* GUARDASYNCSNAPSHOT_H */
@@ -0,0 +1,91 @@
+#ifndef GUARDBITMASK_H
+#define GUARDBITMASK_H
+
+#include "Logger.hxx"
+#include "ROOT/RDataFrame.hxx"
+#include "utility.hxx"
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Packing of boolean columns into a single per-event bitmask. The mask is
+/// defined by a single typed node reading all columns, whose number is a
+/// template parameter, known when the code is generated. Used for the trigger
+/// bitset, the fused met filters and the primary dataset overlap veto.
+namespace utility {
+namespace bitmask {
+
+/// Function object combining a fixed number of flags into a bitmask, to be
+/// used together with utility::PassAsArgs
+template <std::size_t N> struct Packer {
+    std::array<ULong64_t, N> masks;
+    bool negate;
+
+    template <class... Flags>
+    ULong64_t operator()(const Flags &...flags) const {
+        const bool values[] = {flags...};
+        ULong64_t mask = 0;
+        for (std::size_t i = 0; i < N; ++i) {
+            if (values[i] != negate)
+                mask |= masks[i];
+        }
+        return mask;
+    }
+};
+
+/// Define a `ULong64_t` column, where bit `bits[i]` is set if the boolean
+/// column `columns[i]` is true, or false if `negate` is set. Several columns
+/// can be assigned to the same bit, which is then set if any of them is. The
+/// mask is defined by a single node reading `N` columns. If less than `N`
+/// columns are given, e.g. since some HLT paths are missing in the input, the
+/// remaining inputs of the node repeat the first column without setting a
+/// bit.
+///
+/// \tparam N number of columns read by the node
+/// \param df the input dataframe
+/// \param outputname name of the bitmask column
+/// \param columns names of the boolean columns, at most N
+/// \param bits bit of each column, has to be below 64
+/// \param negate set the bit for a false column instead of a true one
+///
+/// \returns a dataframe containing the bitmask column
+template <std::size_t N>
+inline ROOT::RDF::RNode Pack(ROOT::RDF::RNode df, const std::string &outputname,
+                             const std::vector<std::string> &columns,
+                             const std::vector<std::size_t> &bits,
+                             const bool negate = false) {
+    if (columns.size() != bits.size() || columns.size() > N) {
+        Logger::get("bitmask")->error(
+            "Received {} columns and {} bits for the bitmask {}, expected the "
+            "same number of at most {}",
+            columns.size(), bits.size(), outputname, N);
+        throw std::invalid_argument("invalid columns for the bitmask");
+    }
+    if constexpr (N == 0) {
+        return df.Define(outputname, []() { return ULong64_t(0); });
+    } else {
+        if (columns.empty())
+            return df.Define(outputname, []() { return ULong64_t(0); });
+        Packer<N> packer{{}, negate};
+        std::vector<std::string> inputs(N, columns[0]);
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            if (bits[i] >= 64) {
+                Logger::get("bitmask")->error(
+                    "Bit {} of column {} does not fit into the bitmask {}",
+                    bits[i], columns[i], outputname);
+                throw std::invalid_argument("invalid bit for the bitmask");
+            }
+            packer.masks[i] = ULong64_t(1) << bits[i];
+            inputs[i] = columns[i];
+        }
+        return df.Define(outputname,
+                         utility::PassAsArgs<N, bool>(std::move(packer)),
+                         inputs);
+    }
+}
+
+} // namespace bitmask
+} // namespace utility
+
+#endif /* GUARDBITMASK_H */
@@ -0,0 +1,36 @@
+#ifndef GUARDCOMPACTCOLLECTION_H
+#define GUARDCOMPACTCOLLECTION_H
+
+#include "ROOT/RVec.hxx"
+#include <cstddef>
+
+namespace physicsobject {
+/// Compact copy of the objects of a collection passing a selection mask, stored
+/// as contiguous arrays (structure of arrays). The collection is created once
+/// per event by physicsobject::GatherSelectedObjects, so that functions only
+/// interested in the selected objects can loop over dense arrays instead of
+/// calling `ROOT::VecOps::Nonzero` and `ROOT::VecOps::Take` on the full
+/// collection again. `index` contains the index of each object in the
+/// original collection.
+struct CompactCollection {
+    ROOT::RVec<float> pt;
+    ROOT::RVec<float> eta;
+    ROOT::RVec<float> phi;
+    ROOT::RVec<float> mass;
+    ROOT::RVec<int> charge;
+    ROOT::RVec<int> index;
+
+    std::size_t size() const { return index.size(); }
+    bool empty() const { return index.empty(); }
+    void resize(std::size_t n) {
+        pt.resize(n);
+        eta.resize(n);
+        phi.resize(n);
+        mass.resize(n);
+        charge.resize(n);
+        index.resize(n);
+    }
+};
+} // namespace physicsobject
+
+#endif /* GUARDCOMPACTCOLLECTION_H */
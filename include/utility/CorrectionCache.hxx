@@ -0,0 +1,43 @@
+#ifndef GUARDCORRECTIONCACHE_H
+#define GUARDCORRECTIONCACHE_H
+
+#include "Logger.hxx"
+#include "correction.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/// Loading of the correctionlib files used by the producers.
+///
+/// Within a process, every file is only parsed once and the resulting
+/// CorrectionSet is shared by all producers and shifts using it.
+namespace utility {
+namespace corrections {
+
+/// Load a correctionlib file. Each file is parsed only once per process.
+///
+/// \param filename the path of the correction file, as given in the
+/// configuration
+///
+/// \returns the CorrectionSet of the file
+inline std::shared_ptr<const correction::CorrectionSet>
+Load(const std::string &filename) {
+    static std::mutex mutex;
+    static std::map<std::string,
+                    std::shared_ptr<const correction::CorrectionSet>>
+        cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto cached = cache.find(filename);
+    if (cached != cache.end())
+        return cached->second;
+    Logger::get("corrections")->debug("Loading {}", filename);
+    std::shared_ptr<const correction::CorrectionSet> correctionset =
+        correction::CorrectionSet::from_file(filename);
+    cache[filename] = correctionset;
+    return correctionset;
+}
+} // namespace corrections
+} // namespace utility
+
+#endif /* GUARDCORRECTIONCACHE_H */
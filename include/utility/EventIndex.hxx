@@ -0,0 +1,143 @@
+#ifndef GUARDEVENTINDEX_H
+#define GUARDEVENTINDEX_H
+
+#include "Logger.hxx"
+#include "TBranch.h"
+#include "TFile.h"
+#include "TLeaf.h"
+#include "TTree.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/// Sorted index of the events in an output file. For every entry of the
+/// output tree, the (run, lumi, event) triplet and the entry number are
+/// stored in a separate `eventindex` tree, sorted by (run, lumi, event).
+/// The index is small compared to the output, so single events can be found
+/// by a binary search instead of a full scan of the output tree.
+namespace utility {
+namespace eventindex {
+
+struct EventKey {
+    UInt_t run;
+    UInt_t lumi;
+    ULong64_t event;
+    Long64_t entry;
+};
+
+inline bool operator<(const EventKey &a, const EventKey &b) {
+    return std::tie(a.run, a.lumi, a.event) < std::tie(b.run, b.lumi, b.event);
+}
+
+/// Build the index of an output tree and write it as tree `indexname` to
+/// the same file. Only the run, lumi and event branches are read. If one of
+/// the branches is not part of the output, no index is written.
+///
+/// \param filename the output file
+/// \param treename the name of the output tree
+/// \param indexname the name of the index tree
+inline void Write(const std::string &filename,
+                  const std::string &treename = "ntuple",
+                  const std::string &indexname = "eventindex") {
+    std::unique_ptr<TFile> file{TFile::Open(filename.c_str(), "UPDATE")};
+    if (!file || file->IsZombie()) {
+        Logger::get("eventindex")
+            ->error("Could not open {} to write the event index", filename);
+        return;
+    }
+    auto tree = file->Get<TTree>(treename.c_str());
+    if (!tree) {
+        return;
+    }
+    TLeaf *runleaf = tree->GetLeaf("run");
+    TLeaf *lumileaf = tree->GetLeaf("lumi");
+    TLeaf *eventleaf = tree->GetLeaf("event");
+    if (!runleaf || !lumileaf || !eventleaf) {
+        Logger::get("eventindex")
+            ->warn("{} does not contain run, lumi and event, no event index "
+                   "written",
+                   filename);
+        return;
+    }
+    const Long64_t nentries = tree->GetEntries();
+    std::vector<EventKey> keys(nentries);
+    for (Long64_t entry = 0; entry < nentries; ++entry) {
+        runleaf->GetBranch()->GetEntry(entry);
+        lumileaf->GetBranch()->GetEntry(entry);
+        eventleaf->GetBranch()->GetEntry(entry);
+        keys[entry] = {static_cast<UInt_t>(runleaf->GetValueLong64()),
+                       static_cast<UInt_t>(lumileaf->GetValueLong64()),
+                       static_cast<ULong64_t>(eventleaf->GetValueLong64()),
+                       entry};
+    }
+    std::sort(keys.begin(), keys.end());
+    EventKey key;
+    TTree index(indexname.c_str(), "sorted (run, lumi, event) index");
+    index.Branch("run", &key.run);
+    index.Branch("lumi", &key.lumi);
+    index.Branch("event", &key.event);
+    index.Branch("entry", &key.entry);
+    for (auto const &k : keys) {
+        key = k;
+        index.Fill();
+    }
+    index.Write("", TObject::kOverwrite);
+    file->Close();
+    Logger::get("eventindex")
+        ->debug("Event index with {} entries written to {}", nentries,
+                filename);
+}
+
+/// Read the index of an output file
+///
+/// \param file the output file
+/// \param indexname the name of the index tree
+///
+/// \returns the index, sorted by (run, lumi, event), or an empty vector if
+/// the file does not contain an index
+inline std::vector<EventKey> Read(TFile &file,
+                                  const std::string &indexname = "eventindex") {
+    std::vector<EventKey> keys;
+    auto index = file.Get<TTree>(indexname.c_str());
+    if (!index) {
+        return keys;
+    }
+    EventKey key;
+    index->SetBranchAddress("run", &key.run);
+    index->SetBranchAddress("lumi", &key.lumi);
+    index->SetBranchAddress("event", &key.event);
+    index->SetBranchAddress("entry", &key.entry);
+    keys.reserve(index->GetEntries());
+    for (Long64_t i = 0; i < index->GetEntries(); ++i) {
+        index->GetEntry(i);
+        keys.push_back(key);
+    }
+    index->ResetBranchAddresses();
+    return keys;
+}
+
+/// Find the entries of an event in the output tree. An event can appear
+/// more than once, e.g. if the input contains duplicates.
+///
+/// \param keys the index, as returned by utility::eventindex::Read
+/// \param run the run number
+/// \param lumi the luminosity block
+/// \param event the event number
+///
+/// \returns the entry numbers of the event, empty if it is not found
+inline std::vector<Long64_t> Find(const std::vector<EventKey> &keys,
+                                  UInt_t run, UInt_t lumi, ULong64_t event) {
+    std::vector<Long64_t> entries;
+    const EventKey target{run, lumi, event, 0};
+    auto range = std::equal_range(keys.begin(), keys.end(), target);
+    for (auto it = range.first; it != range.second; ++it) {
+        entries.push_back(it->entry);
+    }
+    return entries;
+}
+} // namespace eventindex
+} // namespace utility
+
+#endif /* GUARDEVENTINDEX_H */
@@ -0,0 +1,41 @@
+#ifndef GUARDEVENTSEED_H
+#define GUARDEVENTSEED_H
+
+#include "RtypesCore.h"
+
+/// Seeds of random number generators, that only depend on the processed
+/// event. Producers drawing random numbers create a generator per event,
+/// seeded from the (run, lumi, event) triplet, so the drawn numbers do not
+/// depend on the order in which the events are processed, the number of
+/// threads or the slot processing the event.
+namespace utility {
+namespace eventseed {
+
+/// Mix a value into a seed, using the finalizer of the splitmix64 generator
+inline ULong64_t Mix(ULong64_t seed, ULong64_t value) {
+    ULong64_t z = seed + 0x9e3779b97f4a7c15ULL + value * 0xd1b54a32d192ed03ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/// Get the seed of an event, to be used for TRandom3. The seed is never
+/// zero, since TRandom3 would then be seeded from the time.
+///
+/// \param seed the seed of the producer, to draw different numbers in
+/// different producers
+/// \param run the run number of the event
+/// \param lumi the luminosity block of the event
+/// \param event the event number
+///
+/// \returns the seed of the event
+inline UInt_t Seed(ULong64_t seed, UInt_t run, UInt_t lumi, ULong64_t event) {
+    const ULong64_t mixed = Mix(Mix(Mix(seed, run), lumi), event);
+    const UInt_t folded = static_cast<UInt_t>(mixed ^ (mixed >> 32));
+    return folded == 0 ? 1 : folded;
+}
+
+} // namespace eventseed
+} // namespace utility
+
+#endif /* GUARDEVENTSEED_H */
@@ -0,0 +1,67 @@
+#ifndef GUARDINDEXACCESS_H
+#define GUARDINDEXACCESS_H
+
+#include "ROOT/RVec.hxx"
+#include <cstddef>
+
+/// Exception-free access of collection elements via the indices stored in
+/// pair or index columns.
+///
+/// An index is valid if it points into the collection. All other indices, in
+/// particular the negative sentinels used for missing objects, give the
+/// default value of the quantity. The validity check is a single unsigned
+/// comparison, so no exception is thrown or caught per event. If several
+/// collections are accessed with the same index, the index is checked once
+/// against all of them via `Check`, and the values are loaded without further
+/// checks.
+namespace utility {
+namespace index {
+
+/// sentinel of a missing object
+constexpr int missing = -1;
+
+/// Check if an index points into a collection of the given size. Negative
+/// indices wrap around to large unsigned values and are rejected by the same
+/// comparison.
+inline bool Valid(const int index, const std::size_t size) {
+    return static_cast<std::size_t>(static_cast<unsigned int>(index)) < size;
+}
+
+/// Get the index stored at a position of a pair column
+///
+/// \param pair the pair column
+/// \param position the position in the pair
+///
+/// \returns the stored index, or `missing` if the pair has no such position
+inline int Position(const ROOT::RVec<int> &pair, const int position) {
+    return Valid(position, pair.size()) ? pair[position] : missing;
+}
+
+/// Validate an index against all collections accessed with it. For a
+/// returned index other than `missing`, the elements of all collections can
+/// be loaded via `operator[]` without further checks.
+///
+/// \param index the index to validate
+/// \param collections the collections accessed with the index
+///
+/// \returns the index if it is valid for all collections, `missing` otherwise
+template <typename... Collections>
+int Check(const int index, const Collections &...collections) {
+    return (Valid(index, collections.size()) && ...) ? index : missing;
+}
+
+/// Load an element of a collection, or the fallback for invalid indices
+///
+/// \param values the collection
+/// \param index the index of the element
+/// \param fallback the value returned for invalid indices
+///
+/// \returns the element or the fallback
+template <typename T>
+T Load(const ROOT::RVec<T> &values, const int index, const T &fallback) {
+    return Valid(index, values.size()) ? T(values[index]) : fallback;
+}
+} // namespace index
+} // namespace utility
+
+#endif /* GUARDINDEXACCESS_H */
@@ -0,0 +1,259 @@
+#ifndef GUARDLOCKPROFILER_H
+#define GUARDLOCKPROFILER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Instrumentation of the synchronization points of CROWN. If the code is
+/// compiled with `CROWN_LOCK_PROFILING` (cmake option `-DPROFILE_LOCKS=true`),
+/// the time spent waiting for and holding each instrumented lock is recorded
+/// per thread and per site, and a summary can be printed at the end of the
+/// run. Without the flag, all functions are empty and get optimized away.
+///
+/// Sites are registered once by name as a LockProfiler::Site, typically a
+/// function-local static, so recording a measurement only indexes the
+/// counters of the current thread. Locks are instrumented with
+/// LockProfiler::Guard, a drop-in replacement for `std::lock_guard`. Code
+/// sections, which are not protected by a lock, but are serialized or not
+/// thread-safe (e.g. the access to a global object) can be instrumented with
+/// LockProfiler::Section, which only records the hold time.
+class LockProfiler {
+  public:
+#ifdef CROWN_LOCK_PROFILING
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+    using clock = std::chrono::steady_clock;
+    /// an acquisition is counted as contended, if the wait for the lock took
+    /// longer than this, in seconds
+    static constexpr double contention_threshold = 1e-5;
+
+    struct Counters {
+        std::uint64_t acquisitions = 0;
+        std::uint64_t contended = 0;
+        double wait = 0.; // seconds
+        double hold = 0.; // seconds
+        double max_wait = 0.; // seconds
+    };
+
+    /// Handle of an instrumented site, sites with the same name share their
+    /// counters
+    class Site {
+      public:
+        explicit Site(const char *name)
+            : id_(enabled ? registerSite(name) : 0) {}
+        std::size_t id() const { return id_; }
+
+      private:
+        std::size_t id_;
+    };
+
+    /// Simple stopwatch, which only reads the clock if profiling is enabled
+    class Stopwatch {
+      public:
+        Stopwatch() {
+            if constexpr (enabled)
+                start_ = clock::now();
+        }
+        void restart() {
+            if constexpr (enabled)
+                start_ = clock::now();
+        }
+        double elapsed() const {
+            if constexpr (enabled)
+                return std::chrono::duration<double>(clock::now() - start_)
+                    .count();
+            return 0.;
+        }
+
+      private:
+        clock::time_point start_;
+    };
+
+    /// Replacement of `std::lock_guard`, recording the wait and hold time of
+    /// the lock for the given site.
+    template <class Mutex> class Guard {
+      public:
+        Guard(Mutex &mutex, const Site &site) : mutex_(mutex), site_(site) {
+            Stopwatch wait;
+            mutex_.lock();
+            if constexpr (enabled) {
+                wait_ = wait.elapsed();
+                hold_.restart();
+            }
+        }
+        ~Guard() {
+            if constexpr (enabled) {
+                const double hold = hold_.elapsed();
+                mutex_.unlock();
+                record(site_, wait_, hold);
+            } else {
+                mutex_.unlock();
+            }
+        }
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+      private:
+        Mutex &mutex_;
+        const Site &site_;
+        double wait_ = 0.;
+        Stopwatch hold_;
+    };
+
+    /// Records the time spent in a code section for the given site, from
+    /// construction to destruction.
+    class Section {
+      public:
+        explicit Section(const Site &site) : site_(site) {}
+        ~Section() {
+            if constexpr (enabled)
+                record(site_, 0., watch_.elapsed());
+        }
+        Section(const Section &) = delete;
+        Section &operator=(const Section &) = delete;
+
+      private:
+        const Site &site_;
+        Stopwatch watch_;
+    };
+
+    /// Add a single measurement for a site to the counters of the current
+    /// thread
+    static void record(const Site &site, double wait, double hold) {
+        if constexpr (enabled) {
+            auto &sites = threadCounters().sites;
+            if (site.id() >= sites.size())
+                sites.resize(site.id() + 1);
+            auto &counters = sites[site.id()];
+            counters.acquisitions++;
+            counters.contended += wait > contention_threshold;
+            counters.wait += wait;
+            counters.hold += hold;
+            counters.max_wait = std::max(counters.max_wait, wait);
+        }
+    }
+
+    /// Summary of all recorded sites, including the per thread counters, and
+    /// the CPU utilisation of the run, defined as the used CPU time divided by
+    /// the wall time times the number of threads. Should only be called after
+    /// the event loop has finished.
+    ///
+    /// \param realtime the wall time of the run in seconds
+    /// \param cputime the CPU time of the run in seconds
+    /// \param nthreads the number of threads used in the run
+    ///
+    /// \returns the formatted summary
+    static std::string summary(double realtime, double cputime,
+                               unsigned int nthreads) {
+        nthreads = std::max(nthreads, 1u);
+        const double utilisation =
+            realtime > 0. ? cputime / (realtime * nthreads) : 0.;
+        std::string result;
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "Lock profile: %u thread(s), wall time %.2f s, CPU time "
+                      "%.2f s, CPU utilisation %.1f %%\n",
+                      nthreads, realtime, cputime, 100. * utilisation);
+        result += line;
+        if constexpr (!enabled) {
+            result += "  lock profiling is disabled, rebuild with "
+                      "-DPROFILE_LOCKS=true to record the lock contention\n";
+            return result;
+        }
+        // merge the counters of all threads, keeping the per thread values
+        std::map<std::string, std::vector<std::pair<std::size_t, Counters>>>
+            per_site;
+        std::map<std::string, Counters> totals;
+        auto &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (std::size_t thread = 0; thread < reg.threads.size(); ++thread) {
+            const auto &sites = reg.threads[thread]->sites;
+            for (std::size_t id = 0; id < sites.size(); ++id) {
+                const auto &counters = sites[id];
+                if (counters.acquisitions == 0)
+                    continue;
+                const auto &site = reg.sites[id];
+                per_site[site].emplace_back(thread, counters);
+                auto &total = totals[site];
+                total.acquisitions += counters.acquisitions;
+                total.contended += counters.contended;
+                total.wait += counters.wait;
+                total.hold += counters.hold;
+                total.max_wait = std::max(total.max_wait, counters.max_wait);
+            }
+        }
+        const double available = realtime * nthreads;
+        for (auto const &[site, total] : totals) {
+            std::snprintf(
+                line, sizeof(line),
+                "  %s: %llu acquisitions, %.1f %% contended (wait > %.0f us), "
+                "wait %.3f s "
+                "(%.2f %% of thread time, max %.3f ms), hold %.3f s\n",
+                site.c_str(), (unsigned long long)total.acquisitions,
+                total.acquisitions > 0
+                    ? 100. * total.contended / total.acquisitions
+                    : 0.,
+                1e6 * contention_threshold, total.wait, available > 0. ? 100. * total.wait / available : 0.,
+                1000. * total.max_wait, total.hold);
+            result += line;
+            for (auto const &[thread, counters] : per_site[site]) {
+                std::snprintf(line, sizeof(line),
+                              "    thread %zu: %llu acquisitions, %llu "
+                              "contended, wait %.3f s, hold %.3f s\n",
+                              thread,
+                              (unsigned long long)counters.acquisitions,
+                              (unsigned long long)counters.contended,
+                              counters.wait, counters.hold);
+                result += line;
+            }
+        }
+        return result;
+    }
+
+  private:
+    /// counters of a thread, indexed by the id of the site
+    struct ThreadCounters {
+        std::vector<Counters> sites;
+    };
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::string> sites;
+        std::vector<std::shared_ptr<ThreadCounters>> threads;
+    };
+    static Registry &registry() {
+        static Registry instance;
+        return instance;
+    }
+    static std::size_t registerSite(const char *name) {
+        auto &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        const auto site = std::find(reg.sites.begin(), reg.sites.end(), name);
+        if (site != reg.sites.end())
+            return site - reg.sites.begin();
+        reg.sites.push_back(name);
+        return reg.sites.size() - 1;
+    }
+    /// the counters are thread local, so recording does not need any
+    /// synchronization, only the registration of a new thread is locked
+    static ThreadCounters &threadCounters() {
+        thread_local std::shared_ptr<ThreadCounters> counters = [] {
+            auto newCounters = std::make_shared<ThreadCounters>();
+            auto &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.threads.push_back(newCounters);
+            return newCounters;
+        }();
+        return *counters;
+    }
+};
+
+#endif /* GUARDLOCKPROFILER_H */
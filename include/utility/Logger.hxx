@@ -1,7 +1,9 @@
 #ifndef GUARDLOGGER_H
 #define GUARDLOGGER_H
 
+#include "LockProfiler.hxx"
 #include <map>
+#include <shared_mutex>
 #include <spdlog/fmt/ostr.h> // for formatting of RVecs
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
@@ -10,15 +12,27 @@
 class Logger {
   public:
     static std::shared_ptr<spdlog::logger> get(std::string name) {
+        // the logger map is shared by all slots of the event loop, existing
+        // loggers are looked up under a shared lock, so only the creation of
+        // a new logger is serialized
+        {
+            std::shared_lock<std::shared_mutex> lookup(getInstance()._mutex);
+            auto logger = getInstance()._loggers.find(name);
+            if (logger != getInstance()._loggers.end())
+                return logger->second;
+        }
+        static const LockProfiler::Site site("Logger::get");
+        LockProfiler::Guard<std::shared_mutex> guard(getInstance()._mutex,
+                                                     site);
         if (getInstance()._loggers.count(name) == 0) {
             std::vector<spdlog::sink_ptr> sinkVector;
             sinkVector.push_back(
-                std::make_shared<spdlog::sinks::stdout_color_sink_st>());
+                std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
 
             // check if file logging is enabled
             if (getInstance()._fileName)
                 sinkVector.push_back(
-                    std::make_shared<spdlog::sinks::basic_file_sink_st>(
+                    std::make_shared<spdlog::sinks::basic_file_sink_mt>(
                         *getInstance()._fileName));
 
             auto newLogger = std::make_shared<spdlog::logger>(
@@ -31,6 +45,7 @@ class Logger {
     }
     enum class LogLevel { DEBUG, INFO, WARN, ERR, CRITICAL, OFF };
     static void setLevel(LogLevel level) {
+        std::unique_lock<std::shared_mutex> guard(getInstance()._mutex);
         getInstance()._level = level;
 
         // set level globally (probably superfluous..)
@@ -41,12 +56,13 @@ class Logger {
             logger->set_level(convertLevelToSpdlog(level));
     }
     static void enableFileLogging(std::string filename) {
+        std::unique_lock<std::shared_mutex> guard(getInstance()._mutex);
         getInstance()._fileName = std::make_unique<std::string>(filename);
         for (auto &[key, logger] : getInstance()._loggers) {
             // if there is less than two sinks, add a file sink
             if (logger->sinks().size() < 2)
                 logger->sinks().push_back(
-                    std::make_shared<spdlog::sinks::basic_file_sink_st>(
+                    std::make_shared<spdlog::sinks::basic_file_sink_mt>(
                         *getInstance()._fileName));
         }
     }
@@ -77,6 +93,7 @@ class Logger {
     }
     std::unique_ptr<std::string> _fileName{};
     std::map<std::string, std::shared_ptr<spdlog::logger>> _loggers;
+    std::shared_mutex _mutex;
 };
 
 #endif /* GUARDLOGGER_H */
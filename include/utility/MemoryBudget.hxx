@@ -0,0 +1,132 @@
+#ifndef GUARDMEMORYBUDGET_H
+#define GUARDMEMORYBUDGET_H
+
+#include "Logger.hxx"
+#include "TFile.h"
+#include "TSystem.h"
+#include "TTree.h"
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Choice of the number of threads of the event loop within a memory budget.
+/// Every slot of the event loop holds its own copy of the cached value of
+/// each column, its own read buffers of the input branches and, for the
+/// multithreaded Snapshot, its own buffers of the output branches. With many
+/// shifts, the memory per slot can exceed the memory of a batch slot when
+/// running with many threads.
+namespace utility {
+namespace memory {
+
+/// default buffer size of an output branch of the Snapshot in bytes
+constexpr std::size_t output_buffer_size = 32000;
+
+/// Resident memory of the current process in bytes
+inline std::size_t ResidentMemory() {
+    ProcInfo_t info;
+    gSystem->GetProcInfo(&info);
+    return static_cast<std::size_t>(info.fMemResident) * 1024;
+}
+
+/// Measure the memory of the read buffers of the input branches, by reading
+/// the first cluster (at most 1000 events) of the first input file.
+///
+/// \param filename the input file
+/// \param treename the name of the input tree
+/// \param branches the input branches read by the executable
+///
+/// \returns the increase of the resident memory in bytes
+inline std::size_t WarmUp(const std::string &filename,
+                          const std::string &treename,
+                          const std::vector<std::string> &branches) {
+    std::unique_ptr<TFile> file{TFile::Open(filename.c_str(), "READ")};
+    if (!file || file->IsZombie()) {
+        return 0;
+    }
+    auto tree = file->Get<TTree>(treename.c_str());
+    if (!tree) {
+        return 0;
+    }
+    tree->SetBranchStatus("*", 0);
+    for (auto const &branch : branches) {
+        if (tree->GetBranch(branch.c_str()))
+            tree->SetBranchStatus(branch.c_str(), 1);
+    }
+    const std::size_t before = ResidentMemory();
+    auto iterator = tree->GetClusterIterator(0);
+    iterator.Next();
+    const Long64_t nentries =
+        std::min<Long64_t>({iterator.GetNextEntry(), tree->GetEntries(), 1000});
+    for (Long64_t entry = 0; entry < nentries; ++entry) {
+        tree->GetEntry(entry);
+    }
+    const std::size_t after = ResidentMemory();
+    return after > before ? after - before : 0;
+}
+
+/// Get the number of threads for the event loop. If the environment variable
+/// `CROWN_MEMORY_BUDGET` is set (in MB), the memory per slot is estimated
+/// from the cached column values of the graph, the buffers of the output
+/// branches and a short warm-up reading the input branches, and the largest
+/// number of threads fitting into the budget is chosen. Without a budget,
+/// the configured number of threads is used. The configured number can be
+/// overridden via the environment variable `CROWN_THREADS`, e.g. to run the
+/// same executable with different numbers of threads in the determinism tests.
+///
+/// \param max_threads the number of threads configured for the executable
+/// \param files the input files
+/// \param treename the name of the input tree
+/// \param input_branches the input branches read by the executable
+/// \param output_branches the total number of output branches of all scopes
+/// \param column_bytes the estimated size of the cached column values of a
+/// single slot, as determined by the code generation
+///
+/// \returns the number of threads
+inline unsigned int
+ThreadsForBudget(unsigned int max_threads,
+                 const std::vector<std::string> &files,
+                 const std::string &treename,
+                 const std::vector<std::string> &input_branches,
+                 std::size_t output_branches, std::size_t column_bytes) {
+    if (const char *threads = std::getenv("CROWN_THREADS")) {
+        max_threads = std::max(1, std::atoi(threads));
+        Logger::get("memory")->info("Number of threads set to {} via "
+                                    "CROWN_THREADS",
+                                    max_threads);
+    }
+    const char *value = std::getenv("CROWN_MEMORY_BUDGET");
+    if (!value || files.empty()) {
+        return max_threads;
+    }
+    const double mb = 1024. * 1024.;
+    const std::size_t budget = std::atof(value) * mb;
+    const std::size_t input_bytes = WarmUp(files[0], treename, input_branches);
+    const std::size_t output_bytes = output_branches * output_buffer_size;
+    const std::size_t slot_bytes = column_bytes + input_bytes + output_bytes;
+    const std::size_t baseline = ResidentMemory();
+    unsigned int threads = 1;
+    if (budget > baseline && slot_bytes > 0) {
+        threads = std::clamp<std::size_t>((budget - baseline) / slot_bytes, 1,
+                                          max_threads);
+    }
+    Logger::get("memory")->info(
+        "Memory budget {:.0f} MB, baseline {:.0f} MB, estimated memory per "
+        "slot {:.1f} MB (columns {:.1f} MB, input buffers {:.1f} MB, output "
+        "buffers {:.1f} MB)",
+        budget / mb, baseline / mb, slot_bytes / mb, column_bytes / mb,
+        input_bytes / mb, output_bytes / mb);
+    Logger::get("memory")->info(
+        "Using {} of {} threads, expected peak memory {:.0f} MB", threads,
+        max_threads, (baseline + threads * slot_bytes) / mb);
+    if (baseline + slot_bytes > budget) {
+        Logger::get("memory")->warn(
+            "The estimated memory of a single thread exceeds the budget");
+    }
+    return threads;
+}
+} // namespace memory
+} // namespace utility
+
+#endif /* GUARDMEMORYBUDGET_H */
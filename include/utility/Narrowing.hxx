@@ -0,0 +1,182 @@
+#ifndef GUARDNARROWING_H
+#define GUARDNARROWING_H
+
+#include "Logger.hxx"
+#include "ROOT/RDataFrame.hxx"
+#include "ROOT/RVec.hxx"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/// Narrowing of integer output branches to the smallest storage type
+/// covering their value range.
+///
+/// In calibration mode, enabled by setting the environment variable
+/// `CROWN_RANGE_CALIBRATION` to the path of a json file, the minimum and
+/// maximum of all integer outputs are recorded during the event loop and
+/// written to the file, keyed by the nominal name of the quantity. Placed in
+/// the analysis folder as `quantity_ranges.json`, the ranges are used by the
+/// code generation to write these outputs with a narrower type.
+///
+/// Narrowed values are checked at runtime. If a value does not fit into the
+/// narrowed type, the calibrated ranges are outdated. The event loop is then
+/// stopped and the executable is started again, writing all outputs with
+/// their original types. The narrowing can also be disabled by setting
+/// `CROWN_DISABLE_NARROWING`.
+namespace utility {
+namespace narrowing {
+
+/// True if the outputs are written with the narrowed types. Calibration runs
+/// always record the ranges of the original types.
+inline bool Enabled() {
+    return std::getenv("CROWN_DISABLE_NARROWING") == nullptr &&
+           std::getenv("CROWN_RANGE_CALIBRATION") == nullptr;
+}
+
+/// Thrown if a value does not fit into the narrowed type of its column
+class Overflow : public std::runtime_error {
+  public:
+    Overflow(const std::string &column, const std::string &value)
+        : std::runtime_error("Value " + value + " of output " + column +
+                             " does not fit into its narrowed type"),
+          column(column) {}
+    std::string column;
+};
+
+/// Check if an integer value is representable by the narrowed type
+template <typename Narrow, typename Wide> bool Fits(const Wide &value) {
+    if constexpr (std::is_same_v<Narrow, bool>) {
+        return value == Wide(0) || value == Wide(1);
+    } else if constexpr (std::is_signed_v<Wide>) {
+        return static_cast<long long>(value) >=
+                   static_cast<long long>(std::numeric_limits<Narrow>::min()) &&
+               static_cast<long long>(value) <=
+                   static_cast<long long>(std::numeric_limits<Narrow>::max());
+    } else {
+        return static_cast<unsigned long long>(value) <=
+               static_cast<unsigned long long>(
+                   std::numeric_limits<Narrow>::max());
+    }
+}
+
+/// Checked conversion of a column to its narrowed type, to be used in a
+/// `Redefine` of the column, e.g.
+/// `df.Redefine("njets", Checked<Char_t, int>{"njets"}, {"njets"})`
+template <typename Narrow, typename Wide> struct Checked {
+    std::string column;
+    Narrow operator()(const Wide &value) const {
+        if (!Fits<Narrow>(value))
+            throw Overflow(column, std::to_string(value));
+        return static_cast<Narrow>(value);
+    }
+};
+
+/// elementwise checked conversion of vector columns
+template <typename Narrow, typename Wide>
+struct Checked<ROOT::RVec<Narrow>, ROOT::RVec<Wide>> {
+    std::string column;
+    ROOT::RVec<Narrow> operator()(const ROOT::RVec<Wide> &values) const {
+        ROOT::RVec<Narrow> narrowed(values.size());
+        const Checked<Narrow, Wide> element{column};
+        for (std::size_t i = 0; i < values.size(); ++i)
+            narrowed[i] = element(values[i]);
+        return narrowed;
+    }
+};
+
+/// Restart the executable with the original output types, after a narrowed
+/// output overflowed. The executable is started again via `argv[0]`, which is
+/// looked up in the `PATH` if it does not contain a directory, like the
+/// shell does. The output files are recreated by the new process.
+///
+/// \param argv the arguments of the executable
+/// \param overflow the overflow stopping the event loop
+///
+/// \returns the exit code, only returned if the restart failed
+inline int RerunWide(char *argv[], const Overflow &overflow) {
+    Logger::get("narrowing")
+        ->warn("{}, the calibrated value ranges are outdated and should be "
+               "calibrated again. Restarting with the original output types.",
+               overflow.what());
+    setenv("CROWN_DISABLE_NARROWING", "1", 1);
+    execvp(argv[0], argv);
+    Logger::get("narrowing")
+        ->error("Restart of {} failed, rerun it with "
+                "CROWN_DISABLE_NARROWING=1 to write the original output types",
+                argv[0]);
+    return 1;
+}
+
+/// Recording of the value ranges of integer outputs in calibration mode
+class Calibration {
+  public:
+    Calibration() {
+        if (const char *path = std::getenv("CROWN_RANGE_CALIBRATION"))
+            path_ = path;
+    }
+
+    bool enabled() const { return !path_.empty(); }
+
+    /// Book the minimum and maximum of the given columns, nothing is booked
+    /// if the calibration mode is not enabled
+    ///
+    /// \param df the dataframe containing the columns
+    /// \param columns the output columns
+    /// \param quantities the nominal quantity name of each column, the ranges
+    /// of all columns of a quantity are merged
+    void Book(ROOT::RDF::RNode df, const std::vector<std::string> &columns,
+              const std::vector<std::string> &quantities) {
+        if (!enabled())
+            return;
+        for (std::size_t i = 0; i < columns.size(); ++i)
+            booked_.emplace_back(quantities[i], df.Min(columns[i]),
+                                 df.Max(columns[i]));
+    }
+
+    /// Write the recorded ranges, has to be called after the event loop
+    void Write() {
+        if (!enabled())
+            return;
+        std::map<std::string, std::pair<double, double>> ranges;
+        for (auto &[quantity, min, max] : booked_) {
+            // columns without any selected event do not constrain the range
+            if (*min > *max)
+                continue;
+            auto range = ranges.find(quantity);
+            if (range == ranges.end()) {
+                ranges[quantity] = {*min, *max};
+            } else {
+                range->second.first = std::min(range->second.first, *min);
+                range->second.second = std::max(range->second.second, *max);
+            }
+        }
+        nlohmann::json json;
+        for (auto const &[quantity, range] : ranges)
+            json[quantity] = {static_cast<long long>(range.first),
+                              static_cast<long long>(range.second)};
+        std::ofstream(path_) << json.dump(4) << std::endl;
+        Logger::get("narrowing")
+            ->info("Value ranges of {} quantities written to {}",
+                   ranges.size(), path_);
+    }
+
+  private:
+    std::string path_;
+    std::vector<std::tuple<std::string, ROOT::RDF::RResultPtr<double>,
+                           ROOT::RDF::RResultPtr<double>>>
+        booked_;
+};
+} // namespace narrowing
+} // namespace utility
+
+#endif /* GUARDNARROWING_H */
@@ -1,6 +1,7 @@
 #ifndef GUARDROOFUNCTORTHREADSAFE_H
 #define GUARDROOFUNCTORTHREADSAFE_H
 
+#include "LockProfiler.hxx"
 #include "RooFunctor.h"
 #include "RooWorkspace.h"
 #include "TFile.h"
@@ -30,7 +31,16 @@ class RooFunctorThreadsafe {
 
     double operator()(const double *input) { return eval(input); }
 
-    double eval(const double *input) { return getIdleExecutor().eval(input); }
+    double eval(const double *input) {
+        static const LockProfiler::Site idle_site(
+            "RooFunctorThreadsafe::getIdleExecutor");
+        static const LockProfiler::Site eval_site("RooFunctorThreadsafe::eval");
+        LockProfiler::Stopwatch wait;
+        auto &executor = getIdleExecutor();
+        LockProfiler::record(idle_site, wait.elapsed(), 0.);
+        LockProfiler::Section hold(eval_site);
+        return executor.eval(input);
+    }
 
   private:
     class Executor {
@@ -76,7 +86,9 @@ class RooFunctorThreadsafe {
     };
 
     Executor &addNewExecutor() {
-        std::lock_guard<std::mutex> lock(mutex_);
+        static const LockProfiler::Site site(
+            "RooFunctorThreadsafe::addNewExecutor");
+        LockProfiler::Guard<std::mutex> lock(mutex_, site);
         if (executors_.size() >= maxNExecutors) {
             throw std::runtime_error("Maximum number of executors reached.");
         }
@@ -0,0 +1,240 @@
+#ifndef GUARDSAMPLING_H
+#define GUARDSAMPLING_H
+
+#include "Logger.hxx"
+#include "ROOT/RCutFlowReport.hxx"
+#include "TBranch.h"
+#include "TChain.h"
+#include "TEntryList.h"
+#include "TFile.h"
+#include "TTree.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace utility {
+namespace sampling {
+
+/// Quick-look sampling of the input files. Instead of processing the first N
+/// events, which are usually all taken from the same file and run, a fraction
+/// of the clusters of the input tree is selected, spread uniformly over all
+/// input files. The clusters of each file are grouped by the run number of
+/// their first entry, and from each of these strata the given fraction of
+/// clusters is selected at equidistant positions with a random offset. Since
+/// only complete clusters are selected, the multithreaded event loop only
+/// reads the selected clusters.
+///
+/// The sampling is configured via the environment variables
+/// `CROWN_SAMPLE_FRACTION` (fraction of clusters in (0, 1)) and
+/// `CROWN_SAMPLE_SEED` (seed of the random offsets, defaults to 42). If the
+/// fraction is not set, all functions are no-ops.
+class ClusterSampling {
+  public:
+    /// Select the clusters to be processed
+    ///
+    /// \param files the input files
+    /// \param treename the name of the input tree
+    /// \param fraction the fraction of clusters to be selected, the sampling
+    /// is disabled for fractions outside of (0, 1)
+    /// \param seed the seed for the random offsets of the selection
+    ClusterSampling(const std::vector<std::string> &files,
+                    const std::string &treename, double fraction,
+                    unsigned int seed)
+        : fraction_(fraction), seed_(seed),
+          file_entries_(files.size(), 0), file_selected_(files.size(), 0) {
+        if (!enabled())
+            return;
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<double> uniform(0., 1.);
+        entrylist_ = std::make_unique<TEntryList>("sampling", "sampling");
+        chain_ = std::make_unique<TChain>(treename.c_str());
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            chain_->Add(files[i].c_str());
+            std::unique_ptr<TFile> file{TFile::Open(files[i].c_str(), "READ")};
+            if (!file || file->IsZombie())
+                throw std::runtime_error("Could not open " + files[i] +
+                                         " for the sampling");
+            auto tree = file->Get<TTree>(treename.c_str());
+            if (!tree)
+                throw std::runtime_error("Could not read " + treename +
+                                         " from " + files[i]);
+            const auto strata = Strata(tree);
+            file_entries_[i] = tree->GetEntries();
+            TEntryList selection("", "", treename.c_str(), files[i].c_str());
+            for (auto const &[run, clusters] : strata) {
+                // the expected number of clusters is rounded randomly, so
+                // that the sampling is unbiased also for small strata
+                const double expected = fraction_ * clusters.size();
+                std::size_t nselected = std::floor(expected);
+                if (uniform(generator) < expected - nselected)
+                    nselected++;
+                if (nselected == 0)
+                    continue;
+                const double step = double(clusters.size()) / nselected;
+                const double offset = uniform(generator) * step;
+                for (std::size_t n = 0; n < nselected; ++n) {
+                    auto const &[start, end] =
+                        clusters[std::min<std::size_t>(offset + n * step,
+                                                       clusters.size() - 1)];
+                    for (Long64_t entry = start; entry < end; ++entry)
+                        selection.Enter(entry);
+                    file_selected_[i] += end - start;
+                    selected_clusters_++;
+                }
+            }
+            total_clusters_ += CountClusters(strata);
+            total_strata_ += strata.size();
+            entrylist_->Add(&selection);
+        }
+        chain_->SetEntryList(entrylist_.get(), "ne");
+        Logger::get("sampling")
+            ->info("Sampling {} of {} clusters ({} strata): {} of {} events",
+                   selected_clusters_, total_clusters_, total_strata_,
+                   SelectedEvents(), TotalEvents());
+    }
+
+    /// Create the sampling from the environment variables
+    /// `CROWN_SAMPLE_FRACTION` and `CROWN_SAMPLE_SEED`
+    static ClusterSampling FromEnvironment(const std::vector<std::string> &files,
+                                           const std::string &treename) {
+        double fraction = 1.;
+        unsigned int seed = 42;
+        if (const char *value = std::getenv("CROWN_SAMPLE_FRACTION"))
+            fraction = std::atof(value);
+        if (const char *value = std::getenv("CROWN_SAMPLE_SEED"))
+            seed = std::strtoul(value, nullptr, 10);
+        return ClusterSampling(files, treename, fraction, seed);
+    }
+
+    bool enabled() const { return fraction_ > 0. && fraction_ < 1.; }
+
+    /// Chain of the input files with the entry list of the selected clusters
+    TChain &chain() const { return *chain_; }
+
+    Long64_t TotalEvents() const {
+        Long64_t total = 0;
+        for (auto const &entries : file_entries_)
+            total += entries;
+        return total;
+    }
+    Long64_t SelectedEvents() const {
+        Long64_t selected = 0;
+        for (auto const &entries : file_selected_)
+            selected += entries;
+        return selected;
+    }
+
+    /// Factor to scale event counts of the sampled run to the full dataset
+    double scale() const {
+        return SelectedEvents() > 0 ? double(TotalEvents()) / SelectedEvents()
+                                    : 0.;
+    }
+
+    /// Sum of the generator weights of the processed events, estimated from
+    /// the sum of weights of each file and the fraction of events selected in
+    /// the file. Without sampling, the sum of all files is returned.
+    ///
+    /// \param sumw_per_file the genEventSumw of each input file
+    double SumOfWeights(const std::vector<double> &sumw_per_file) const {
+        double sumw = 0.;
+        for (std::size_t i = 0; i < sumw_per_file.size(); ++i) {
+            if (!enabled())
+                sumw += sumw_per_file[i];
+            else if (file_entries_[i] > 0)
+                sumw += sumw_per_file[i] * file_selected_[i] / file_entries_[i];
+        }
+        return sumw;
+    }
+
+    /// Print the cutflow of a scope, scaled to the full dataset
+    void PrintReport(ROOT::RDF::RCutFlowReport &report) const {
+        if (!enabled())
+            return;
+        Logger::get("sampling")
+            ->info("Cutflow scaled to the full dataset (x {:.3f}):", scale());
+        for (auto &&cut : report) {
+            Logger::get("sampling")
+                ->info("{:<20s}: pass={:<12.0f} all={:<12.0f} -- eff={:.2f} %",
+                       cut.GetName(), cut.GetPass() * scale(),
+                       cut.GetAll() * scale(), cut.GetEff());
+        }
+    }
+
+    /// Write the parameters of the sampling as `sampling` tree to the current
+    /// directory
+    void Write() const {
+        if (!enabled())
+            return;
+        double fraction = fraction_;
+        double scalefactor = scale();
+        unsigned int seed = seed_;
+        ULong64_t clusters_total = total_clusters_;
+        ULong64_t clusters_selected = selected_clusters_;
+        ULong64_t strata = total_strata_;
+        ULong64_t events_total = TotalEvents();
+        ULong64_t events_selected = SelectedEvents();
+        TTree sampling_meta("sampling", "sampling");
+        sampling_meta.Branch("fraction", &fraction);
+        sampling_meta.Branch("seed", &seed);
+        sampling_meta.Branch("strata", &strata);
+        sampling_meta.Branch("clusters_total", &clusters_total);
+        sampling_meta.Branch("clusters_selected", &clusters_selected);
+        sampling_meta.Branch("events_total", &events_total);
+        sampling_meta.Branch("events_selected", &events_selected);
+        sampling_meta.Branch("scale", &scalefactor);
+        sampling_meta.Fill();
+        sampling_meta.Write();
+    }
+
+  private:
+    using Cluster = std::pair<Long64_t, Long64_t>;
+
+    /// Group the clusters of a tree by the run number of their first entry
+    static std::map<UInt_t, std::vector<Cluster>> Strata(TTree *tree) {
+        std::map<UInt_t, std::vector<Cluster>> strata;
+        UInt_t run = 0;
+        TBranch *runbranch = tree->GetBranch("run");
+        if (runbranch)
+            runbranch->SetAddress(&run);
+        const Long64_t nentries = tree->GetEntries();
+        auto iterator = tree->GetClusterIterator(0);
+        for (Long64_t start = iterator.Next(); start < nentries;
+             start = iterator.Next()) {
+            const Long64_t end = std::min(iterator.GetNextEntry(), nentries);
+            if (runbranch)
+                runbranch->GetEntry(start);
+            strata[run].emplace_back(start, end);
+        }
+        if (runbranch)
+            runbranch->ResetAddress();
+        return strata;
+    }
+    static std::size_t
+    CountClusters(const std::map<UInt_t, std::vector<Cluster>> &strata) {
+        std::size_t nclusters = 0;
+        for (auto const &[run, clusters] : strata)
+            nclusters += clusters.size();
+        return nclusters;
+    }
+
+    double fraction_;
+    unsigned int seed_;
+    std::vector<Long64_t> file_entries_;
+    std::vector<Long64_t> file_selected_;
+    std::size_t total_clusters_ = 0;
+    std::size_t selected_clusters_ = 0;
+    std::size_t total_strata_ = 0;
+    std::unique_ptr<TEntryList> entrylist_;
+    std::unique_ptr<TChain> chain_;
+};
+} // namespace sampling
+} // namespace utility
+
+#endif /* GUARDSAMPLING_H */
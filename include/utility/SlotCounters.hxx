@@ -0,0 +1,81 @@
+#ifndef GUARDSLOTCOUNTERS_H
+#define GUARDSLOTCOUNTERS_H
+
+#include "RtypesCore.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Event counters filled concurrently by the slots of the event loop, used by
+/// the reports of the fused met filters and the primary dataset overlap veto.
+namespace utility {
+namespace slotcounters {
+
+/// A fixed number of counters per slot of the event loop. The counters of
+/// every slot are stored inline in their own cache lines, so slots never
+/// write to the same cache line. The counters are summed over all slots after
+/// the event loop.
+class SlotCounters {
+  public:
+    /// \param ncounters the number of counters per slot
+    /// \param nslots the number of slots of the event loop
+    SlotCounters(std::size_t ncounters, unsigned int nslots)
+        : ncounters_(ncounters),
+          lines_per_slot_((ncounters + per_line - 1) / per_line),
+          lines_(nslots * lines_per_slot_) {}
+
+    /// Increment a counter of a slot
+    void Increment(unsigned int slot, std::size_t counter) {
+        ++lines_[slot * lines_per_slot_ + counter / per_line]
+              .counts[counter % per_line];
+    }
+
+    /// the counters summed over all slots
+    std::vector<ULong64_t> Sum() const {
+        std::vector<ULong64_t> sum(ncounters_, 0);
+        for (std::size_t line = 0; line < lines_.size(); ++line) {
+            const std::size_t first = (line % lines_per_slot_) * per_line;
+            for (std::size_t i = 0; i < per_line && first + i < ncounters_;
+                 ++i)
+                sum[first + i] += lines_[line].counts[i];
+        }
+        return sum;
+    }
+
+  private:
+    static constexpr std::size_t per_line = 64 / sizeof(ULong64_t);
+    struct alignas(64) Line {
+        ULong64_t counts[per_line] = {};
+    };
+    std::size_t ncounters_;
+    std::size_t lines_per_slot_;
+    std::vector<Line> lines_;
+};
+
+/// Get a name for a new report, which is not used by any of the registered
+/// reports. Several reports with the same name are registered, if the same
+/// filter is applied in more than one configuration of a multi-configuration
+/// executable, so the second one is suffixed with `_1` and so on.
+///
+/// \param reports the registered reports, providing their `name`
+/// \param name the requested name
+///
+/// \returns the name of the new report
+template <typename Report>
+std::string UniqueName(const std::vector<std::shared_ptr<Report>> &reports,
+                       const std::string &name) {
+    std::string unique = name;
+    for (std::size_t suffix = 1;; ++suffix) {
+        bool used = false;
+        for (auto const &report : reports)
+            used = used || report->name == unique;
+        if (!used)
+            return unique;
+        unique = name + "_" + std::to_string(suffix);
+    }
+}
+
+} // namespace slotcounters
+} // namespace utility
+
+#endif /* GUARDSLOTCOUNTERS_H */
@@ -0,0 +1,75 @@
+#ifndef GUARDUSAGEMANIFEST_H
+#define GUARDUSAGEMANIFEST_H
+
+#include "Logger.hxx"
+#include "TBranch.h"
+#include "TLeaf.h"
+#include "TTree.h"
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <set>
+#include <string>
+#include <vector>
+
+/// Recording of the output branches read by downstream jobs.
+///
+/// Downstream selections and histogramming jobs record the branches they
+/// read from a CROWN output into a usage manifest, a json file listing the
+/// branch names per scope. Placed in the analysis folder as
+/// `usage_manifest*.json`, the manifests of all jobs are merged by the code
+/// generation, which then removes the outputs not read by any job and the
+/// producers only needed for them.
+namespace utility {
+namespace usage {
+
+/// Add branches to the usage manifest of a scope. An existing manifest is
+/// extended, so several jobs can record into the same file one after the
+/// other.
+///
+/// \param branches the names of the branches read downstream
+/// \param scope the scope of the output file, e.g. `mm` for `output_mm.root`
+/// \param path the json file of the manifest
+inline void Record(const std::vector<std::string> &branches,
+                   const std::string &scope, const std::string &path) {
+    nlohmann::json manifest = nlohmann::json::object();
+    std::ifstream existing(path);
+    if (existing.good())
+        existing >> manifest;
+    std::set<std::string> recorded;
+    if (manifest.contains(scope))
+        recorded = manifest[scope].get<std::set<std::string>>();
+    recorded.insert(branches.begin(), branches.end());
+    manifest[scope] = recorded;
+    std::ofstream(path) << manifest.dump(4) << std::endl;
+    Logger::get("usage")->info("{} branches of scope {} recorded in {}",
+                               recorded.size(), scope, path);
+}
+
+/// Add the branches read from a tree to the usage manifest of a scope, has
+/// to be called after the event loop of the downstream job. A branch is
+/// considered to be read if any of its entries was loaded. For a chain, the
+/// branches read from the current tree are recorded.
+///
+/// \param tree the output tree read by the downstream job
+/// \param scope the scope of the output file
+/// \param path the json file of the manifest
+inline void Record(TTree &tree, const std::string &scope,
+                   const std::string &path) {
+    std::set<std::string> branches;
+    auto current = tree.GetTree();
+    if (current) {
+        for (auto object : *current->GetListOfLeaves()) {
+            auto branch = static_cast<TLeaf *>(object)->GetBranch();
+            if (branch->GetReadEntry() < 0)
+                continue;
+            // members of split objects are recorded via their top level branch
+            branches.insert(branch->GetMother()->GetName());
+        }
+    }
+    Record(std::vector<std::string>(branches.begin(), branches.end()), scope,
+           path);
+}
+} // namespace usage
+} // namespace utility
+
+#endif /* GUARDUSAGEMANIFEST_H */
@@ -0,0 +1,134 @@
+#ifndef GUARDVARIATIONS_H
+#define GUARDVARIATIONS_H
+
+#include "Logger.hxx"
+#include "ROOT/RDataFrame.hxx"
+#include "ROOT/RSnapshotOptions.hxx"
+#include "RVersion.h"
+#include "TBranch.h"
+#include "TFile.h"
+#include "TLeaf.h"
+#include "TTree.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Helper functions for the Vary based systematics backend of the code
+/// generation. Shifts, that only replace input columns, are expressed as
+/// `Vary` of the source columns, and the variations are propagated by
+/// RDataFrame through all producers. The varied outputs are written by the
+/// Snapshot and converted to the layout of the duplicate backend afterwards.
+namespace utility {
+namespace variations {
+
+/// Enable the writing of systematic variations in a Snapshot. Requires
+/// ROOT 6.36 or newer.
+///
+/// \param options the snapshot options to be modified
+inline void EnableInSnapshot(ROOT::RDF::RSnapshotOptions &options) {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 36, 0)
+    options.fIncludeVariations = true;
+#else
+#error "The Vary systematics backend requires ROOT 6.36 or newer, use -DSYSTEMATICS_BACKEND=duplicate"
+#endif
+}
+
+/// Convert the output of a Snapshot with variations to the layout of the
+/// duplicate backend. A Snapshot with variations writes every event passing
+/// the selection of the nominal or of any variation, and adds mask branches
+/// (`R_rdf_mask_*`) flagging the variations the event passed, with bit 0 for
+/// nominal and one bit per variation in the order of the Vary calls. The
+/// duplicate backend applies the filters of all shifts to the same
+/// dataframe, so only events passing all of them are written. The tree is
+/// therefore rewritten without the events failing the nominal selection or
+/// any variation and without the mask branches. RDataFrame appends the
+/// variation name and tag to the column name, everything following
+/// `__<shift>` in a branch name is removed.
+///
+/// \param filename the output file
+/// \param treename the name of the output tree
+/// \param shifts the shifts to be renamed, without the leading `__`, in the
+/// order of the Vary calls
+inline void Finalize(const std::string &filename, const std::string &treename,
+                     const std::vector<std::string> &shifts) {
+    std::unique_ptr<TFile> file{TFile::Open(filename.c_str(), "UPDATE")};
+    if (!file || file->IsZombie()) {
+        Logger::get("variations")
+            ->error("Could not open {} to convert the varied output",
+                    filename);
+        return;
+    }
+    auto tree = file->Get<TTree>(treename.c_str());
+    if (!tree) {
+        return;
+    }
+    std::vector<std::string> masks;
+    for (auto object : *tree->GetListOfBranches()) {
+        const std::string name = object->GetName();
+        if (name.rfind("R_rdf_mask_", 0) == 0)
+            masks.push_back(name);
+    }
+    // every mask branch holds the bits of 64 variations
+    const std::size_t nbits = shifts.size() + 1;
+    std::vector<ULong64_t> values(masks.size(), 0);
+    std::vector<ULong64_t> required(masks.size(), 0);
+    for (std::size_t bit = 0; bit < nbits && bit / 64 < masks.size(); ++bit)
+        required[bit / 64] |= ULong64_t(1) << (bit % 64);
+    tree->SetBranchStatus("*", false);
+    for (std::size_t i = 0; i < masks.size(); ++i) {
+        tree->SetBranchStatus(masks[i].c_str(), true);
+        tree->SetBranchAddress(masks[i].c_str(), &values[i]);
+    }
+    std::vector<Long64_t> selected;
+    for (Long64_t entry = 0; entry < tree->GetEntries(); ++entry) {
+        tree->GetEntry(entry);
+        bool passed = true;
+        for (std::size_t i = 0; i < masks.size(); ++i)
+            passed = passed && (values[i] & required[i]) == required[i];
+        if (passed)
+            selected.push_back(entry);
+    }
+    tree->ResetBranchAddresses();
+    tree->SetBranchStatus("*", true);
+    for (const auto &mask : masks)
+        tree->SetBranchStatus(mask.c_str(), false);
+    auto converted = tree->CloneTree(0);
+    for (auto entry : selected) {
+        tree->GetEntry(entry);
+        converted->Fill();
+    }
+    int renamed = 0;
+    for (auto object : *converted->GetListOfBranches()) {
+        auto branch = static_cast<TBranch *>(object);
+        const std::string name = branch->GetName();
+        for (const auto &shift : shifts) {
+            const auto position = name.find("__" + shift);
+            if (position == std::string::npos || position == 0)
+                continue;
+            const std::string newname = name.substr(0, position + 2) + shift;
+            if (newname == name)
+                break;
+            TLeaf *leaf = branch->GetLeaf(name.c_str());
+            if (leaf) {
+                leaf->SetName(newname.c_str());
+                leaf->SetTitle(newname.c_str());
+            }
+            branch->SetName(newname.c_str());
+            branch->SetTitle(newname.c_str());
+            renamed++;
+            break;
+        }
+    }
+    const Long64_t total = tree->GetEntries();
+    file->Delete((treename + ";*").c_str());
+    converted->Write(treename.c_str());
+    file->Close();
+    Logger::get("variations")
+        ->info("Kept {} of {} events passing all variations in {}, renamed {} "
+               "varied branches",
+               selected.size(), total, filename, renamed);
+}
+} // namespace variations
+} // namespace utility
+
+#endif /* GUARDVARIATIONS_H */
@@ -2,6 +2,7 @@
 #define GUARDUTILITY_H
 
 #include <cmath>
+#include <stdexcept>
 #include <string>
 #include <utility> // make_index_sequence
 #include <vector>
@@ -50,5 +51,55 @@ auto PassAsVec(F &&f) -> PassAsVecHelper<std::make_index_sequence<N>, T, F> {
     return utility::PassAsVecHelper<std::make_index_sequence<N>, T, F>(
         std::forward<F>(f));
 }
+
+/// Helper class to pass a fixed number of columns of the same type to a
+/// function. In contrast to PassAsVecHelper, no temporary container is
+/// created, the arguments are forwarded as references, so the wrapped function
+/// can operate on them directly, e.g. via fold expressions.
+template <typename I, typename T, typename F> class PassAsArgsHelper;
+
+template <std::size_t... N, typename T, typename F>
+class PassAsArgsHelper<std::index_sequence<N...>, T, F> {
+    template <std::size_t Idx> using AlwaysT = const T &;
+    typename std::decay<F>::type fFunc;
+
+  public:
+    PassAsArgsHelper(F &&f) : fFunc(std::forward<F>(f)) {}
+    auto operator()(AlwaysT<N>... args) -> decltype(fFunc(args...)) {
+        return fFunc(args...);
+    }
+};
+
+template <std::size_t N, typename T, typename F>
+auto PassAsArgs(F &&f) -> PassAsArgsHelper<std::make_index_sequence<N>, T, F> {
+    return utility::PassAsArgsHelper<std::make_index_sequence<N>, T, F>(
+        std::forward<F>(f));
+}
+
+/// Variadic combinators to be used together with PassAsArgs
+namespace combinators {
+/// Returns true if any of the given flags is true
+struct AnyOf {
+    template <class... Flags> bool operator()(const Flags &...flags) const {
+        return (... || flags);
+    }
+};
+/// Returns the elementwise product of the given masks. All masks are required
+/// to have the same size.
+struct MultiplyMasks {
+    template <class Mask, class... Masks>
+    Mask operator()(const Mask &first, const Masks &...masks) const {
+        if (((masks.size() != first.size()) || ...)) {
+            throw std::runtime_error(
+                "cannot combine masks of different sizes");
+        }
+        Mask result(first.size());
+        for (std::size_t i = 0; i < first.size(); ++i) {
+            result[i] = (first[i] * ... * masks[i]);
+        }
+        return result;
+    }
+};
+} // end namespace combinators
 } // end namespace utility
 #endif /* GUARDUTILITY_H */
\ No newline at end of file
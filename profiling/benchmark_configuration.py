@@ -0,0 +1,207 @@
+import argparse
+import logging
+import os
+import random
+import sys
+import time
+from typing import Callable, Dict, List
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+
+from code_generation.configuration import Configuration  # noqa: E402
+from code_generation.producer import BaseFilter, Producer  # noqa: E402
+from code_generation.quantity import NanoAODQuantity, Quantity  # noqa: E402
+from code_generation.systematics import SystematicShift  # noqa: E402
+
+# Benchmark of the configuration phase of the code generation. A synthetic
+# configuration is built with a chain of global producers, which all depend on
+# a single "jet energy correction" producer, and a set of scopes consuming the
+# global quantities. Every shift varies the correction, like the individual JES
+# and JER sources, so that all quantities downstream of it are shifted. The
+# producers are added in random order, so that the optimizer has to sort them.
+# The time spent in each phase of the configuration is reported.
+#
+# Example:
+# python3 profiling/benchmark_configuration.py --producers 1000 --shifts 500 --scopes 4
+
+
+def build_producers(
+    rng: random.Random, scopes: List[str], nproducers: int
+) -> Dict[str, List[Producer]]:
+    """
+    Build the producers of the synthetic configuration
+
+    Args:
+        rng: the random number generator
+        scopes: the non-global scopes
+        nproducers: the number of producers per scope
+
+    Returns:
+        the producers of each scope, in random order
+    """
+    nanoaod = [NanoAODQuantity("Input_{}".format(i)) for i in range(10)]
+    correction = Producer(
+        name="Correction",
+        call='correction({df}, {output}, {input}, "{source}")',
+        input=nanoaod[:2],
+        output=[Quantity("corrected")],
+        scopes=["global"],
+    )
+    produced = {"global": [correction.output[0]]}
+    producers = {"global": [correction]}
+    for scope in ["global"] + scopes:
+        if scope != "global":
+            produced[scope] = []
+            producers[scope] = []
+        for i in range(nproducers):
+            available = produced["global"] + produced[scope]
+            inputs = rng.sample(available, min(len(available), 2))
+            inputs.append(rng.choice(nanoaod))
+            if i % 50 == 49:
+                producers[scope].append(
+                    BaseFilter(
+                        name="Filter_{}_{}".format(scope, i),
+                        call='filter({{df}}, {{input}}, "filter_{}")'.format(i),
+                        input=inputs[:1],
+                        scopes=[scope],
+                    )
+                )
+                continue
+            output = Quantity("{}_quantity_{}".format(scope, i))
+            producers[scope].append(
+                Producer(
+                    name="Producer_{}_{}".format(scope, i),
+                    call="produce({df}, {output}, {input}, {threshold})",
+                    input=inputs,
+                    output=[output],
+                    scopes=[scope],
+                )
+            )
+            produced[scope].append(output)
+    for scope in producers:
+        rng.shuffle(producers[scope])
+    return producers
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Benchmark the configuration phase of the code generation"
+    )
+    parser.add_argument(
+        "--producers", type=int, default=1000, help="Producers per scope"
+    )
+    parser.add_argument("--shifts", type=int, default=500, help="Number of shifts")
+    parser.add_argument("--scopes", type=int, default=4, help="Number of scopes")
+    parser.add_argument("--seed", type=int, default=42, help="Random seed")
+    args = parser.parse_args()
+    logging.basicConfig(level=logging.WARNING)
+
+    rng = random.Random(args.seed)
+    scopes = ["scope{}".format(i) for i in range(args.scopes)]
+    timings: Dict[str, float] = {}
+
+    def measure(phase: str, function: Callable[[], None]) -> None:
+        start = time.perf_counter()
+        function()
+        timings[phase] = time.perf_counter() - start
+
+    state = {}
+
+    def setup():
+        state["producers"] = build_producers(rng, scopes, args.producers)
+
+    def configure():
+        configuration = Configuration(
+            era="2018",
+            sample="benchmark",
+            scopes=scopes,
+            shifts=["all"],
+            available_sample_types=["benchmark"],
+            available_eras=["2018"],
+            available_scopes=scopes,
+        )
+        configuration.preselection_pushdown = False
+        configuration.add_config_parameters(
+            "global", {"source": "nominal", "threshold": 1}
+        )
+        configuration.add_config_parameters(scopes, {"threshold": 2})
+        for scope, producers in state["producers"].items():
+            configuration.add_producers(scope, producers)
+            configuration.add_outputs(
+                scope,
+                [
+                    output
+                    for producer in producers
+                    if producer.output is not None
+                    for output in producer.output
+                ],
+            )
+        state["configuration"] = configuration
+
+    def shift():
+        correction = [
+            producer
+            for producer in state["producers"]["global"]
+            if producer.name == "Correction"
+        ]
+        for i in range(args.shifts):
+            state["configuration"].add_shift(
+                SystematicShift(
+                    name="source{}".format(i),
+                    shift_config={"global": {"source": "source{}".format(i)}},
+                    producers={"global": correction},
+                )
+            )
+
+    def optimize():
+        state["configuration"].optimize()
+
+    def validate():
+        state["configuration"].validate()
+
+    def expand():
+        state["configuration"].expanded_configuration()
+
+    def writecalls():
+        configuration = state["configuration"]
+        ncalls = 0
+        for scope in configuration.scopes:
+            for producer in configuration.producers[scope]:
+                ncalls += len(
+                    producer.writecalls(configuration.config_parameters[scope], scope)
+                )
+        state["calls"] = ncalls
+
+    def outputs():
+        configuration = state["configuration"]
+        nleaves = 0
+        for scope in configuration.scopes:
+            for output in configuration.outputs[scope]:
+                nleaves += len(output.get_leaves_of_scope(scope))
+        state["leaves"] = nleaves
+
+    measure("build producers", setup)
+    measure("add producers", configure)
+    measure("add shifts", shift)
+    measure("optimize", optimize)
+    measure("validate", validate)
+    measure("expand", expand)
+    measure("write calls", writecalls)
+    measure("output leaves", outputs)
+
+    print(
+        "{} scopes, {} producers per scope, {} shifts: {} calls, {} output leaves".format(
+            args.scopes + 1,
+            args.producers,
+            args.shifts,
+            state["calls"],
+            state["leaves"],
+        )
+    )
+    for phase, seconds in timings.items():
+        print("    {:<16} {:8.2f} s".format(phase, seconds))
+    print("    {:<16} {:8.2f} s".format("total", sum(timings.values())))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,119 @@
+// Microbenchmark of the access of collection elements via pair indices,
+// comparing the exception based lookups with the validated index access of
+// include/utility/IndexAccess.hxx. A set of synthetic events is generated,
+// where a configurable fraction of the pairs contains the sentinel of a
+// missing object. For each event, the four-vector of the first pair entry
+// and a single quantity of the second entry are built.
+//
+// Build and run with:
+// g++ -O2 -std=c++17 $(root-config --cflags --libs) -lGenVector
+//     profiling/benchmark_index_access.cxx -o benchmark_index_access
+// ./benchmark_index_access [events] [fraction of missing objects]
+
+#include "../include/utility/IndexAccess.hxx"
+#include "ROOT/RVec.hxx"
+#include <Math/Vector4D.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+const float default_float = -10.0;
+
+struct Event {
+    ROOT::RVec<int> pair;
+    ROOT::RVec<float> pts, etas, phis, masses;
+};
+
+std::vector<Event> generate(std::size_t nevents, double missing) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> multiplicity(1, 6);
+    std::uniform_real_distribution<float> value(0.f, 100.f);
+    std::bernoulli_distribution is_missing(missing);
+    std::vector<Event> events(nevents);
+    for (auto &event : events) {
+        const int n = multiplicity(rng);
+        for (int i = 0; i < n; ++i) {
+            event.pts.push_back(value(rng));
+            event.etas.push_back(value(rng) / 40.f - 1.25f);
+            event.phis.push_back(value(rng) / 32.f - 1.57f);
+            event.masses.push_back(value(rng) / 1000.f);
+        }
+        event.pair = {is_missing(rng) ? -1 : 0, is_missing(rng) ? -1 : n - 1};
+    }
+    return events;
+}
+
+/// the previous implementation of lorentzvectors::buildparticle and the
+/// quantities, using at() and exceptions for missing objects
+double exceptions(const std::vector<Event> &events) {
+    double sum = 0.;
+    for (const auto &event : events) {
+        ROOT::Math::PtEtaPhiMVector p4;
+        try {
+            const int index = event.pair.at(0);
+            p4 = ROOT::Math::PtEtaPhiMVector(
+                event.pts.at(index), event.etas.at(index),
+                event.phis.at(index), event.masses.at(index));
+        } catch (const std::out_of_range &e) {
+            p4 = ROOT::Math::PtEtaPhiMVector(default_float, default_float,
+                                             default_float, default_float);
+        }
+        const int index = event.pair.at(1);
+        sum += p4.pt() + event.etas.at(index, default_float);
+    }
+    return sum;
+}
+
+/// the validated index access
+double validated(const std::vector<Event> &events) {
+    double sum = 0.;
+    for (const auto &event : events) {
+        ROOT::Math::PtEtaPhiMVector p4(default_float, default_float,
+                                       default_float, default_float);
+        const int index = utility::index::Check(
+            utility::index::Position(event.pair, 0), event.pts, event.etas,
+            event.phis, event.masses);
+        if (index != utility::index::missing)
+            p4 = ROOT::Math::PtEtaPhiMVector(event.pts[index],
+                                             event.etas[index],
+                                             event.phis[index],
+                                             event.masses[index]);
+        sum += p4.pt() +
+               utility::index::Load(event.etas,
+                                    utility::index::Position(event.pair, 1),
+                                    default_float);
+    }
+    return sum;
+}
+
+template <typename F>
+void measure(const char *name, F function, const std::vector<Event> &events,
+             int repetitions) {
+    double checksum = 0.;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i)
+        checksum += function(events);
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    std::printf("%-12s %8.2f ns/event (checksum %.6g)\n", name,
+                1e9 * seconds / (double(events.size()) * repetitions),
+                checksum);
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const std::size_t nevents = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const double missing = argc > 2 ? std::atof(argv[2]) : 0.1;
+    const auto events = generate(nevents, missing);
+    std::printf("%zu events, %.0f %% missing objects\n", nevents,
+                100. * missing);
+    measure("exceptions", exceptions, events, 5);
+    measure("validated", validated, events, 5);
+    return 0;
+}
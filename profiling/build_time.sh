@@ -0,0 +1,34 @@
+#!/bin/bash
+
+BUILDDIR=$1
+UNITY_BUILD=${2:-0}
+JOBS=${3:-$(nproc)}
+shift $(( $# < 3 ? $# : 3 ))
+CMAKE_ARGS="$@"
+# producer source modified before the incremental build
+TOUCHED=${TOUCHED:-src/quantities.cxx}
+
+# Measure the clean and the incremental build time of the analysis, built with
+# the given number of unity build sources (0 disables the unity build).
+# The remaining arguments are passed to cmake, e.g.
+# ./profiling/build_time.sh build_unity 8 8 -DANALYSIS=hmm -DCONFIG=vhmm_config -DSAMPLES=dyjets -DERAS=2018 -DSCOPES=m2m
+# The incremental build follows a change of a single producer: the source
+# given by TOUCHED (default src/quantities.cxx) is touched, and the code
+# generation is rerun, which does not rewrite unchanged generated sources.
+
+mkdir -p ${BUILDDIR}
+START=$(date +%s.%N)
+cmake -S . -B ${BUILDDIR} -DUNITY_BUILD=${UNITY_BUILD} ${CMAKE_ARGS} > ${BUILDDIR}/configure.log 2>&1
+cmake --build ${BUILDDIR} -j${JOBS} > ${BUILDDIR}/build.log
+CLEAN=$(echo "$(date +%s.%N) - ${START}" | bc)
+
+touch ${TOUCHED}
+START=$(date +%s.%N)
+cmake -S . -B ${BUILDDIR} -DUNITY_BUILD=${UNITY_BUILD} ${CMAKE_ARGS} > ${BUILDDIR}/reconfigure.log 2>&1
+cmake --build ${BUILDDIR} -j${JOBS} > ${BUILDDIR}/rebuild.log
+INCREMENTAL=$(echo "$(date +%s.%N) - ${START}" | bc)
+
+grep -h "Unity build:" ${BUILDDIR}/configure.log ${BUILDDIR}/reconfigure.log
+echo "Unity build sources: ${UNITY_BUILD}, build jobs: ${JOBS}"
+echo "Clean build:       ${CLEAN} s"
+echo "Incremental build: ${INCREMENTAL} s (after touching ${TOUCHED})"
@@ -0,0 +1,364 @@
+import argparse
+import fnmatch
+import math
+import os
+import time
+from typing import List, Optional, Set
+
+import ROOT
+
+# This script rewrites NanoAOD files with a new cluster size of the Events tree.
+# The number of clusters is the basic limitation to multi-thread scaling (see
+# root_cluster_ranges.sh), and many private skims only contain a handful of huge
+# clusters. The Events tree is rewritten with the target cluster size, all other
+# trees (Runs, LuminosityBlocks, ...) are fast-cloned. If no cluster size is given
+# and the clustering of a file is already sufficient, the Events tree is
+# fast-cloned as well.
+# Optionally, branches that are not read by a CROWN executable can be dropped,
+# using the <executable>_input_branches.txt list written by the code generation.
+#
+# Example:
+# python3 recluster_nanoaod.py --output skims_reclustered --threads 8 \
+#     --keep-branches build/vhmm_config_dyjets_2018_generated_code/vhmm_config_dyjets_2018_input_branches.txt \
+#     --measure skims/*.root
+
+# branches, that are always kept when dropping branches. Trigger paths and MET
+# filters are only accessed via their names in the configuration parameters and
+# are therefore not part of the input list of the code generation
+DEFAULT_KEEP = [
+    "run",
+    "luminosityBlock",
+    "event",
+    "genWeight",
+    "HLT_*",
+    "Flag_*",
+    "L1PreFiringWeight_*",
+    "Pileup_*",
+    "LHE*",
+    "PS*",
+]
+
+
+def cluster_sizes(tree: ROOT.TTree) -> List[int]:
+    """
+    Get the number of entries of each cluster of a tree
+
+    Args:
+        tree: the tree
+
+    Returns:
+        list of the cluster sizes
+    """
+    sizes = []
+    nentries = tree.GetEntries()
+    iterator = tree.GetClusterIterator(0)
+    start = iterator.Next()
+    while start < nentries:
+        end = min(iterator.GetNextEntry(), nentries)
+        sizes.append(end - start)
+        start = iterator.Next()
+    return sizes
+
+
+def expected_speedup(sizes: List[int], threads: int) -> float:
+    """
+    Expected speedup of an event loop on a given number of threads, if every cluster
+    is processed as one task. The clusters are distributed greedily to the threads,
+    largest first, and the speedup is the total number of entries divided by the
+    number of entries processed by the busiest thread.
+
+    Args:
+        sizes: the cluster sizes
+        threads: the number of threads
+
+    Returns:
+        the expected speedup
+    """
+    if len(sizes) == 0:
+        return 1.0
+    load = [0] * threads
+    for size in sorted(sizes, reverse=True):
+        load[load.index(min(load))] += size
+    return sum(sizes) / max(load)
+
+
+def selected_branches(
+    tree: ROOT.TTree, keep: Optional[Set[str]], patterns: List[str]
+) -> Optional[List[str]]:
+    """
+    Get the list of branches to be written. Counter branches of kept collections
+    (e.g. nMuon for Muon_pt) are always kept.
+
+    Args:
+        tree: the input tree
+        keep: the branches to be kept, None to keep all branches
+        patterns: additional wildcard patterns of branches to be kept
+
+    Returns:
+        the branches to be written or None, if all branches are kept
+    """
+    if keep is None:
+        return None
+    branches = set()
+    for branch in tree.GetListOfBranches():
+        name = branch.GetName()
+        if name in keep or any(fnmatch.fnmatch(name, p) for p in patterns):
+            branches.add(name)
+            leaf = branch.GetLeaf(name)
+            if leaf and leaf.GetLeafCount():
+                branches.add(leaf.GetLeafCount().GetBranch().GetName())
+    missing = sorted(b for b in keep if not tree.GetBranch(b))
+    if len(missing) > 0:
+        print(
+            "  Warning: {} required branches not found in input: {}".format(
+                len(missing), ", ".join(missing)
+            )
+        )
+    return sorted(branches)
+
+
+def measure(filename: str, treename: str, threads: int, columns: int) -> float:
+    """
+    Measure the runtime of an event loop reading the first branches of the tree
+
+    Args:
+        filename: the file to be read
+        treename: the name of the tree
+        threads: the number of threads, 1 for single-threaded mode
+        columns: the number of branches to be read
+
+    Returns:
+        the runtime in seconds
+    """
+    if threads > 1:
+        ROOT.EnableImplicitMT(threads)
+    else:
+        ROOT.DisableImplicitMT()
+    df = ROOT.RDataFrame(treename, filename)
+    results = []
+    for i, column in enumerate(list(df.GetColumnNames())[:columns]):
+        if "RVec" in str(df.GetColumnType(column)):
+            df = df.Define(f"_measure_{i}", f"ROOT::VecOps::Sum({column})")
+            results.append(df.Sum(f"_measure_{i}"))
+        else:
+            results.append(df.Sum(str(column)))
+    start = time.perf_counter()
+    ROOT.RDF.RunGraphs(results)
+    runtime = time.perf_counter() - start
+    ROOT.DisableImplicitMT()
+    return runtime
+
+
+def recluster(
+    inputfile: str,
+    outputfile: str,
+    treename: str,
+    cluster_size: Optional[int],
+    clusters: Optional[int],
+    min_cluster_size: int,
+    keep: Optional[Set[str]],
+    patterns: List[str],
+) -> None:
+    """
+    Rewrite a single file with the target clustering
+
+    Args:
+        inputfile: the input file
+        outputfile: the output file
+        treename: the name of the tree to be reclustered
+        cluster_size: the target number of entries per cluster, the tree is always rewritten if it is set
+        clusters: the target number of clusters, only used if cluster_size is not set
+        min_cluster_size: the minimal number of entries per cluster
+        keep: the branches to be kept, None to keep all branches
+        patterns: additional wildcard patterns of branches to be kept
+
+    Returns:
+        None
+    """
+    infile = ROOT.TFile.Open(inputfile, "READ")
+    if not infile or infile.IsZombie():
+        raise FileNotFoundError(f"Could not open {inputfile}")
+    tree = infile.Get(treename)
+    nentries = tree.GetEntries()
+    sizes = cluster_sizes(tree)
+    explicit_size = cluster_size is not None
+    if cluster_size is None:
+        cluster_size = math.ceil(nentries / clusters) if nentries > 0 else 1
+    cluster_size = max(cluster_size, min_cluster_size)
+    target_clusters = math.ceil(nentries / cluster_size) if nentries > 0 else 0
+    branches = selected_branches(tree, keep, patterns)
+    if branches is not None:
+        tree.SetBranchStatus("*", 0)
+        for branch in branches:
+            tree.SetBranchStatus(branch, 1)
+
+    outfile = ROOT.TFile(outputfile, "RECREATE")
+    outfile.SetCompressionSettings(infile.GetCompressionSettings())
+    # fast cloning copies the compressed baskets and keeps the clustering, so it
+    # can only be used if the input is already clustered finely enough. An
+    # explicit cluster size, e.g. a coarser one, is always applied
+    fast = not explicit_size and len(sizes) >= target_clusters
+    outfile.cd()
+    if fast:
+        newtree = tree.CloneTree(-1, "fast")
+    else:
+        newtree = tree.CloneTree(0)
+        newtree.SetAutoFlush(cluster_size)
+        newtree.CopyEntries(tree, -1)
+    newtree.Write("", ROOT.TObject.kOverwrite)
+    # all other trees are copied without changes
+    for key in infile.GetListOfKeys():
+        if key.GetName() == treename or key.GetClassName() != "TTree":
+            continue
+        othertree = infile.Get(key.GetName())
+        outfile.cd()
+        othertree.CloneTree(-1, "fast").Write("", ROOT.TObject.kOverwrite)
+    nbranches = tree.GetListOfBranches().GetEntries()
+    outfile.Close()
+    infile.Close()
+    outfile = ROOT.TFile.Open(outputfile, "READ")
+    new_sizes = cluster_sizes(outfile.Get(treename))
+    outfile.Close()
+    print(
+        "  {} -> {}: {} entries, {} -> {} clusters, {} -> {} branches ({})".format(
+            inputfile,
+            outputfile,
+            nentries,
+            len(sizes),
+            len(new_sizes),
+            nbranches,
+            len(branches) if branches is not None else nbranches,
+            "fast clone" if fast else "rewritten",
+        )
+    )
+
+
+def report(
+    inputfile: str,
+    outputfile: str,
+    treename: str,
+    threads: int,
+    run_measurement: bool,
+    columns: int,
+) -> None:
+    """
+    Print the expected, and optionally the measured, multi-thread speedup of the
+    input and the output file
+
+    Args:
+        inputfile: the input file
+        outputfile: the output file
+        treename: the name of the tree
+        threads: the number of threads
+        run_measurement: if set, the speedup is measured as well
+        columns: the number of branches read in the measurement
+
+    Returns:
+        None
+    """
+    for label, filename in [("input", inputfile), ("output", outputfile)]:
+        rootfile = ROOT.TFile.Open(filename, "READ")
+        sizes = cluster_sizes(rootfile.Get(treename))
+        rootfile.Close()
+        line = "    {:6s}: {:5d} clusters, expected speedup on {} threads: {:.2f}".format(
+            label, len(sizes), threads, expected_speedup(sizes, threads)
+        )
+        if run_measurement:
+            single = measure(filename, treename, 1, columns)
+            multi = measure(filename, treename, threads, columns)
+            line += ", measured: {:.2f} ({:.2f} s -> {:.2f} s)".format(
+                single / multi, single, multi
+            )
+        print(line)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Rewrite NanoAOD files with a cluster size suited for multi-threaded processing"
+    )
+    parser.add_argument("inputs", nargs="+", help="Input files")
+    parser.add_argument("--output", type=str, required=True, help="Output directory")
+    parser.add_argument(
+        "--tree", type=str, default="Events", help="Tree to be reclustered"
+    )
+    parser.add_argument(
+        "--threads",
+        type=int,
+        default=8,
+        help="Number of threads the files will be processed with",
+    )
+    parser.add_argument(
+        "--clusters-per-thread",
+        type=int,
+        default=10,
+        help="Target number of clusters per thread, used if no cluster size is given",
+    )
+    parser.add_argument(
+        "--cluster-size",
+        type=int,
+        default=None,
+        help="Target number of entries per cluster, if given, all files are rewritten with this cluster size",
+    )
+    parser.add_argument(
+        "--min-cluster-size",
+        type=int,
+        default=1000,
+        help="Minimal number of entries per cluster, smaller clusters reduce the compression",
+    )
+    parser.add_argument(
+        "--keep-branches",
+        type=str,
+        default=None,
+        help="File with the branches to be kept, e.g. the <executable>_input_branches.txt file written by the code generation. If not set, all branches are kept",
+    )
+    parser.add_argument(
+        "--keep",
+        type=str,
+        default=",".join(DEFAULT_KEEP),
+        help="Comma separated wildcard patterns of branches, that are always kept when dropping branches",
+    )
+    parser.add_argument(
+        "--measure",
+        action="store_true",
+        help="Measure the multi-thread speedup of the input and output files",
+    )
+    parser.add_argument(
+        "--measure-columns",
+        type=int,
+        default=10,
+        help="Number of branches read in the speedup measurement",
+    )
+    args = parser.parse_args()
+
+    keep = None
+    if args.keep_branches is not None:
+        with open(args.keep_branches, "r") as f:
+            keep = set(line.strip() for line in f if line.strip() != "")
+    patterns = [p for p in args.keep.split(",") if p != ""]
+    if not os.path.exists(args.output):
+        os.makedirs(args.output)
+
+    for inputfile in args.inputs:
+        outputfile = os.path.join(args.output, os.path.basename(inputfile))
+        recluster(
+            inputfile,
+            outputfile,
+            args.tree,
+            args.cluster_size,
+            args.threads * args.clusters_per_thread,
+            args.min_cluster_size,
+            keep,
+            patterns,
+        )
+        report(
+            inputfile,
+            outputfile,
+            args.tree,
+            args.threads,
+            args.measure,
+            args.measure_columns,
+        )
+
+
+if __name__ == "__main__":
+    main()
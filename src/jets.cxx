@@ -3,6 +3,9 @@
 
 #include "../include/basefunctions.hxx"
 #include "../include/defaults.hxx"
+#include "../include/utility/CorrectionCache.hxx"
+#include "../include/utility/EventSeed.hxx"
+#include "../include/utility/IndexAccess.hxx"
 #include "../include/utility/Logger.hxx"
 #include "ROOT/RDataFrame.hxx"
 #include "ROOT/RVec.hxx"
@@ -254,6 +257,11 @@ ROOT::RDF::RNode CutPUID(ROOT::RDF::RNode df, const std::string &maskname,
 /// \param[in] gen_jet_eta name of the gen jet etas
 /// \param[in] gen_jet_phi name of the gen jet phis
 /// \param[in] rho name of the pileup density
+/// \param[in] run name of the run number, used to seed the stochastic smearing
+/// \param[in] lumi name of the luminosity block, used to seed the stochastic
+/// smearing
+/// \param[in] event name of the event number, used to seed the stochastic
+/// smearing
 /// \param[in] reapplyJES boolean for reapplying the JES correction
 /// \param[in] jes_shift_sources vector of JEC unc source names to be applied
 /// in one group
@@ -274,7 +282,8 @@ JetPtCorrection(ROOT::RDF::RNode df, const std::string &corrected_jet_pt,
                 const std::string &jet_rawFactor, const std::string &jet_ID,
                 const std::string &gen_jet_pt, const std::string &gen_jet_eta,
                 const std::string &gen_jet_phi, const std::string &rho,
-                bool reapplyJES,
+                const std::string &run, const std::string &lumi,
+                const std::string &event, bool reapplyJES,
                 const std::vector<std::string> &jes_shift_sources,
                 const int &jes_shift, const std::string &jer_shift,
                 const std::string &jec_file, const std::string &jer_tag,
@@ -291,30 +300,28 @@ JetPtCorrection(ROOT::RDF::RNode df, const std::string &corrected_jet_pt,
         // check if any JES shift is chosen
         if (source != "" && source != "HEMIssue") {
             auto JES_source_evaluator =
-                correction::CorrectionSet::from_file(jec_file)->at(
+                utility::corrections::Load(jec_file)->at(
                     jes_tag + "_" + source + "_" + jec_algo);
             JetEnergyScaleShifts.push_back(JES_source_evaluator);
         }
     };
     // loading jet energy correction scale factor evaluation function
-    auto JES_evaluator =
-        correction::CorrectionSet::from_file(jec_file)->compound().at(
-            jes_tag + "_L1L2L3Res_" + jec_algo);
+    auto JES_evaluator = utility::corrections::Load(jec_file)->compound().at(
+        jes_tag + "_L1L2L3Res_" + jec_algo);
     auto JetEnergyScaleSF = [JES_evaluator](const float area, const float eta,
                                             const float pt, const float rho) {
         return JES_evaluator->evaluate({area, eta, pt, rho});
     };
     // loading relative pT resolution evaluation function
-    auto JER_resolution_evaluator =
-        correction::CorrectionSet::from_file(jec_file)->at(
-            jer_tag + "_PtResolution_" + jec_algo);
+    auto JER_resolution_evaluator = utility::corrections::Load(jec_file)->at(
+        jer_tag + "_PtResolution_" + jec_algo);
     auto JetEnergyResolution = [JER_resolution_evaluator](const float eta,
                                                           const float pt,
                                                           const float rho) {
         return JER_resolution_evaluator->evaluate({eta, pt, rho});
     };
     // loading JER scale factor evaluation function
-    auto JER_SF_evaluator = correction::CorrectionSet::from_file(jec_file)->at(
+    auto JER_SF_evaluator = utility::corrections::Load(jec_file)->at(
         jer_tag + "_ScaleFactor_" + jec_algo);
     auto JetEnergyResolutionSF =
         [JER_SF_evaluator](const float eta, const std::string jer_shift) {
@@ -337,9 +344,14 @@ JetPtCorrection(ROOT::RDF::RNode df, const std::string &corrected_jet_pt,
                                              &gen_eta_values,
                                          const ROOT::RVec<float>
                                              &gen_phi_values,
-                                         const float &rho_value) {
-        // random value generator for jet smearing
-        TRandom3 randm = TRandom3(0);
+                                         const float &rho_value,
+                                         const UInt_t &run_value,
+                                         const UInt_t &lumi_value,
+                                         const ULong64_t &event_value) {
+        // random value generator for jet smearing, seeded per event so the
+        // smearing does not depend on the thread processing the event
+        TRandom3 randm(utility::eventseed::Seed(0, run_value, lumi_value,
+                                                event_value));
 
         ROOT::RVec<float> pt_values_corrected;
         for (int i = 0; i < pt_values.size(); i++) {
@@ -473,7 +485,8 @@ JetPtCorrection(ROOT::RDF::RNode df, const std::string &corrected_jet_pt,
     };
     auto df1 = df.Define(corrected_jet_pt, JetEnergyCorrectionLambda,
                          {jet_pt, jet_eta, jet_phi, jet_area, jet_rawFactor,
-                          jet_ID, gen_jet_pt, gen_jet_eta, gen_jet_phi, rho});
+                          jet_ID, gen_jet_pt, gen_jet_eta, gen_jet_phi, rho,
+                          run, lumi, event});
     return df1;
 }
 /// Function to correct jet energy for data
@@ -500,7 +513,7 @@ JetPtCorrection_data(ROOT::RDF::RNode df, const std::string &corrected_jet_pt,
     if (jes_tag != "") {
         // loading jet energy correction scale factor evaluation function
         auto JES_evaluator =
-            correction::CorrectionSet::from_file(jec_file)->compound().at(
+            utility::corrections::Load(jec_file)->compound().at(
                 jes_tag + "_L1L2L3Res_" + jec_algo);
         Logger::get("JetEnergyScaleData")
             ->debug("file: {}, function {}", jec_file,
@@ -618,13 +631,10 @@ ROOT::RDF::RNode btagValue(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(outputname,
                      [position](const ROOT::RVec<float> &btagvalues,
                                 const ROOT::RVec<int> &jetcollection) {
-                         float btagValue = default_float;
-                         try {
-                             const int index = jetcollection.at(position);
-                             btagValue = btagvalues.at(index);
-                         } catch (const std::out_of_range &e) {
-                         }
-                         return btagValue;
+                         const int index =
+                             utility::index::Position(jetcollection, position);
+                         return utility::index::Load(btagvalues, index,
+                                                     default_float);
                      },
                      {btagcolumn, jetcollection});
 }
@@ -2,6 +2,7 @@
 #define GUARDLVECS_H
 
 #include "../include/defaults.hxx"
+#include "../include/utility/IndexAccess.hxx"
 #include "../include/utility/Logger.hxx"
 #include "ROOT/RDataFrame.hxx"
 #include "ROOT/RVec.hxx"
@@ -35,35 +36,19 @@ ROOT::RDF::RNode buildparticle(ROOT::RDF::RNode df,
                                const int &position) {
     auto df1 = df.Define(
         outputname,
-        [position, outputname](
-            const ROOT::RVec<int> &pair, const ROOT::RVec<float> &pts,
-            const ROOT::RVec<float> &etas, const ROOT::RVec<float> &phis,
-            const ROOT::RVec<float> &masses) {
-            // the index of the particle is stored in the pair vector
-            ROOT::Math::PtEtaPhiMVector p4;
-            Logger::get("lorentzvectors")
-                ->debug("starting to build 4vector {}!", outputname);
-            try {
-                const int index = pair.at(position);
-                Logger::get("lorentzvectors")->debug("pair {}", pair);
-                Logger::get("lorentzvectors")->debug("pts {}", pts);
-                Logger::get("lorentzvectors")->debug("etas {}", etas);
-                Logger::get("lorentzvectors")->debug("phis {}", phis);
-                Logger::get("lorentzvectors")->debug("masses {}", masses);
-                Logger::get("lorentzvectors")->debug("Index {}", index);
-
-                p4 = ROOT::Math::PtEtaPhiMVector(pts.at(index), etas.at(index),
-                                                 phis.at(index),
-                                                 masses.at(index));
-            } catch (const std::out_of_range &e) {
-                p4 = ROOT::Math::PtEtaPhiMVector(default_float, default_float,
-                                                 default_float, default_float);
-                Logger::get("lorentzvectors")
-                    ->debug("Index not found, retuning dummy vector !");
-            }
-            Logger::get("lorentzvectors")
-                ->debug("P4 - Particle {} : {}", position, p4);
-            return p4;
+        [position](const ROOT::RVec<int> &pair, const ROOT::RVec<float> &pts,
+                   const ROOT::RVec<float> &etas, const ROOT::RVec<float> &phis,
+                   const ROOT::RVec<float> &masses) {
+            // the index of the particle is stored in the pair vector, it is
+            // validated once against all four collections, missing particles
+            // result in the default vector
+            const int index =
+                utility::index::Check(utility::index::Position(pair, position),
+                                      pts, etas, phis, masses);
+            if (index == utility::index::missing)
+                return default_lorentzvector;
+            return ROOT::Math::PtEtaPhiMVector(pts[index], etas[index],
+                                               phis[index], masses[index]);
         },
         quantities);
     return df1;
@@ -655,8 +655,16 @@ ROOT::RDF::RNode applyRecoilCorrections(
     bool shiftDown, bool isWjets) {
     if (applyRecoilCorrections) {
         Logger::get("RecoilCorrections")->debug("Will run recoil corrections");
-        const auto corrector = new RecoilCorrector(recoilfile);
-        const auto systematics = new MetSystematic(systematicsfile);
+        // the histograms of the correctors cache their integrals on first
+        // use, so every slot of the event loop gets its own corrector
+        std::vector<std::shared_ptr<RecoilCorrector>> correctors;
+        std::vector<std::shared_ptr<MetSystematic>> systematics;
+        for (unsigned int slot = 0; slot < df.GetNSlots(); ++slot) {
+            correctors.push_back(
+                std::make_shared<RecoilCorrector>(recoilfile));
+            systematics.push_back(
+                std::make_shared<MetSystematic>(systematicsfile));
+        }
         auto shiftType = MetSystematic::SysShift::Nominal;
         if (shiftUp) {
             shiftType = MetSystematic::SysShift::Up;
@@ -669,8 +677,9 @@ ROOT::RDF::RNode applyRecoilCorrections(
         } else if (resolution) {
             sysType = MetSystematic::SysType::Resolution;
         }
-        auto RecoilCorrections = [sysType, systematics, shiftType, corrector,
+        auto RecoilCorrections = [sysType, systematics, shiftType, correctors,
                                   isWjets](
+                                     unsigned int slot,
                                      ROOT::Math::PtEtaPhiMVector &met,
                                      std::pair<ROOT::Math::PtEtaPhiMVector,
                                                ROOT::Math::PtEtaPhiMVector>
@@ -706,14 +715,15 @@ ROOT::RDF::RNode applyRecoilCorrections(
             Logger::get("RecoilCorrections")
                 ->debug("correctedMetY {} ", correctedMetY);
             Logger::get("RecoilCorrections")->debug("old met {} ", met.Pt());
-            corrector->CorrectWithHist(MetX, MetY, genPx, genPy, visPx, visPy,
-                                       nJets30, correctedMetX, correctedMetY);
+            correctors[slot]->CorrectWithHist(MetX, MetY, genPx, genPy, visPx,
+                                              visPy, nJets30, correctedMetX,
+                                              correctedMetY);
             // only apply shifts if the correpsonding variables are set
             if (sysType != MetSystematic::SysType::None &&
                 shiftType != MetSystematic::SysShift::Nominal) {
                 Logger::get("RecoilCorrections")
                     ->debug(" apply systematics {} {}", sysType, shiftType);
-                systematics->ApplyMetSystematic(
+                systematics[slot]->ApplyMetSystematic(
                     correctedMetX, correctedMetY, genPx, genPy, visPx, visPy,
                     nJets30, sysType, shiftType, correctedMetX, correctedMetY);
             }
@@ -726,7 +736,7 @@ ROOT::RDF::RNode applyRecoilCorrections(
             return corrected_met;
         };
         return df.Define(outputname, RecoilCorrections,
-                         {met, genboson, jet_pt});
+                         {"rdfslot_", met, genboson, jet_pt});
     } else {
         // if we do not apply the recoil corrections, just rename the met
         // column to the new outputname and dont change anything else
@@ -1,10 +1,17 @@
 #ifndef GUARDMETFILTER_H
 #define GUARDMETFILTER_H
 /// The namespace that contains the metfilter function.
+#include "../include/utility/Logger.hxx"
+#include "../include/utility/SlotCounters.hxx"
 #include "ROOT/RDFHelpers.hxx"
 #include "ROOT/RDataFrame.hxx"
+#include "TTree.h"
+#include <cstdint>
+#include <memory>
 #include <regex>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace metfilter {
 
@@ -22,5 +29,131 @@ ROOT::RDF::RNode ApplyMetFilter(ROOT::RDF::RNode df,
                      filtername);
 }
 
+namespace {
+/// Rejection counts of a fused met filter, counted per slot of the event
+/// loop. An event is counted as rejected *sequentially* by the first flag it
+/// fails, in the order of the configuration, which reproduces the cutflow of
+/// a chain of single filters. It is counted as rejected *exclusively* by a
+/// flag, if this is the only flag it fails.
+struct Report {
+    struct Counts {
+        ULong64_t total = 0;
+        ULong64_t passed = 0;
+        std::vector<ULong64_t> sequential;
+        std::vector<ULong64_t> exclusive;
+    };
+
+    // counter indices: total, passed, sequential and exclusive per flag
+    Report(const std::string &name, const std::vector<std::string> &flags,
+           unsigned int nslots)
+        : name(name), flags(flags), counters(2 + 2 * flags.size(), nslots) {}
+
+    void Count(unsigned int slot, ULong64_t failed) {
+        counters.Increment(slot, 0);
+        if (failed == 0) {
+            counters.Increment(slot, 1);
+            return;
+        }
+        std::size_t first = 0;
+        while (!((failed >> first) & 1))
+            ++first;
+        counters.Increment(slot, 2 + first);
+        if ((failed & (failed - 1)) == 0)
+            counters.Increment(slot, 2 + flags.size() + first);
+    }
+
+    /// the counts summed over all slots
+    Counts Sum() const {
+        const auto sum = counters.Sum();
+        Counts counts;
+        counts.total = sum[0];
+        counts.passed = sum[1];
+        counts.sequential.assign(sum.begin() + 2,
+                                 sum.begin() + 2 + flags.size());
+        counts.exclusive.assign(sum.begin() + 2 + flags.size(), sum.end());
+        return counts;
+    }
+
+    std::string name;
+    std::vector<std::string> flags;
+    utility::slotcounters::SlotCounters counters;
+};
+
+std::vector<std::shared_ptr<Report>> &Reports() {
+    static std::vector<std::shared_ptr<Report>> reports;
+    return reports;
+}
+} // namespace
+
+/// Function to apply the bitmask of failed met filters defined by
+/// ApplyMetFilters(). Events with an empty mask are kept, and the rejections
+/// per flag are counted in a report. If the same filter name is used more
+/// than once, e.g. by several configurations of one executable, the report of
+/// the second filter is named `<filtername>_1` and so on.
+///
+/// \param df the dataframe containing the bitmask
+/// \param filtername Name of the Filter to be shown in the dataframe report
+/// \param mask Name of the bitmask column of the failed flags
+/// \param flags Names of the Filterflags in NanoAOD, in the order of their bits
+///
+/// \returns a dataframe with the filter applied
+ROOT::RDF::RNode FilterFailedFlags(ROOT::RDF::RNode df,
+                                   const std::string &filtername,
+                                   const std::string &mask,
+                                   const std::vector<std::string> &flags) {
+    auto report = std::make_shared<Report>(
+        utility::slotcounters::UniqueName(Reports(), filtername), flags,
+        df.GetNSlots());
+    Reports().push_back(report);
+    return df.Filter(
+        [report](unsigned int slot, const ULong64_t failed) {
+            report->Count(slot, failed);
+            return failed == 0;
+        },
+        {"rdfslot_", mask}, filtername);
+}
+
+/// Function to print the rejection counts of all met filters applied with
+/// ApplyMetFilters(). Has to be called after the event loop.
+void PrintReports() {
+    for (auto const &report : Reports()) {
+        const auto sum = report->Sum();
+        Logger::get("ApplyMetFilters")
+            ->info("{}: {} events, {} passed", report->name, sum.total,
+                   sum.passed);
+        ULong64_t remaining = sum.total;
+        for (std::size_t i = 0; i < report->flags.size(); ++i) {
+            remaining -= sum.sequential[i];
+            Logger::get("ApplyMetFilters")
+                ->info("    {}: rejected {} (sequential, {} remaining), {} "
+                       "(exclusive)",
+                       report->flags[i], sum.sequential[i], remaining,
+                       sum.exclusive[i]);
+        }
+    }
+}
+
+/// Function to write the rejection counts of all met filters applied with
+/// ApplyMetFilters() to the current directory. For each filter, a tree with
+/// the name of the filter is written, containing the total number of events,
+/// the number of passed events and the sequential and exclusive rejections
+/// of each flag as `<flag>_sequential` and `<flag>_exclusive`.
+void WriteReports() {
+    for (auto const &report : Reports()) {
+        auto sum = report->Sum();
+        TTree meta(report->name.c_str(), report->name.c_str());
+        meta.Branch("total", &sum.total);
+        meta.Branch("passed", &sum.passed);
+        for (std::size_t i = 0; i < report->flags.size(); ++i) {
+            meta.Branch((report->flags[i] + "_sequential").c_str(),
+                        &sum.sequential[i]);
+            meta.Branch((report->flags[i] + "_exclusive").c_str(),
+                        &sum.exclusive[i]);
+        }
+        meta.Fill();
+        meta.Write();
+    }
+}
+
 } // namespace metfilter
 #endif /* GUARDMETFILTER_H */
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "../include/defaults.hxx"
 #include "../include/RoccoR.hxx"
 #include "../include/basefunctions.hxx"
+#include "../include/utility/CompactCollection.hxx"
+#include "../include/utility/CorrectionCache.hxx"
+#include "../include/utility/EventSeed.hxx"
 #include "../include/utility/Logger.hxx"
 #include "../include/utility/utility.hxx"
 #include "ROOT/RDFHelpers.hxx"
@@ -1774,6 +1777,197 @@ ROOT::RDF::RNode CheckForDiLeptonPairs(
     return df1;
 }
 
+/// Function to gather the objects of a collection passing a mask into a
+/// physicsobject::CompactCollection. The selected objects are copied once per
+/// event into contiguous arrays, which can then be used by the functions in
+/// the physicsobject::compact namespace instead of the full collection and
+/// the mask.
+///
+/// \param[in] df the input dataframe
+/// \param[out] outputname the name of the compact collection that is created
+/// \param[in] pt name of the pt column of the collection
+/// \param[in] eta name of the eta column of the collection
+/// \param[in] phi name of the phi column of the collection
+/// \param[in] mass name of the mass column of the collection
+/// \param[in] charge name of the charge column of the collection
+/// \param[in] mask name of the mask column marking the selected objects
+///
+/// \return a dataframe containing the compact collection
+ROOT::RDF::RNode GatherSelectedObjects(
+    ROOT::RDF::RNode df, const std::string &outputname, const std::string &pt,
+    const std::string &eta, const std::string &phi, const std::string &mass,
+    const std::string &charge, const std::string &mask) {
+    auto gather = [](const ROOT::RVec<float> &pt_values,
+                     const ROOT::RVec<float> &eta_values,
+                     const ROOT::RVec<float> &phi_values,
+                     const ROOT::RVec<float> &mass_values,
+                     const ROOT::RVec<int> &charge_values,
+                     const ROOT::RVec<int> &mask) {
+        std::size_t nselected = 0;
+        for (const auto &selected : mask) {
+            nselected += (selected != 0);
+        }
+        CompactCollection collection;
+        collection.resize(nselected);
+        std::size_t j = 0;
+        for (std::size_t i = 0; i < mask.size(); ++i) {
+            if (mask[i] == 0)
+                continue;
+            collection.pt[j] = pt_values.at(i);
+            collection.eta[j] = eta_values.at(i);
+            collection.phi[j] = phi_values.at(i);
+            collection.mass[j] = mass_values.at(i);
+            collection.charge[j] = charge_values.at(i);
+            collection.index[j] = static_cast<int>(i);
+            ++j;
+        }
+        return collection;
+    };
+    return df.Define(outputname, gather, {pt, eta, phi, mass, charge, mask});
+}
+
+/// Versions of the mask based functions, operating on a
+/// physicsobject::CompactCollection created by
+/// physicsobject::GatherSelectedObjects. The results are identical to the
+/// functions with the same name in the physicsobject namespace.
+namespace compact {
+/// Function to generate a veto flag, which is set if the collection contains
+/// at least one object, see physicsobject::LeptonVetoFlag
+///
+/// \param df the input dataframe
+/// \param outputname name of the new quantity containing the veto flags
+/// \param collection the name of the compact collection
+///
+/// \return a new df containing the veto flag column
+ROOT::RDF::RNode LeptonVetoFlag(ROOT::RDF::RNode df,
+                                const std::string &outputname,
+                                const std::string &collection) {
+    return df.Define(
+        outputname,
+        [](const CompactCollection &objects) { return !objects.empty(); },
+        {collection});
+}
+
+/// Function to create a flag, which is set if the collection is empty, see
+/// physicsobject::IsEmptyFlag
+///
+/// \param df the input dataframe
+/// \param outputname the name of the output column that is created
+/// \param collection the name of the compact collection
+///
+/// \return a new df containing the output flag column
+ROOT::RDF::RNode IsEmptyFlag(ROOT::RDF::RNode df, const std::string &outputname,
+                             const std::string &collection) {
+    return df.Define(
+        outputname,
+        [](const CompactCollection &objects) { return objects.empty(); },
+        {collection});
+}
+
+/// Function to create a flag, which is set if the collection contains exactly
+/// n objects, see physicsobject::CutNFlag
+///
+/// \param df the input dataframe
+/// \param outputname the name of the output column that is created
+/// \param collection the name of the compact collection
+/// \param n the allowed number of objects
+///
+/// \return a new df containing the output flag column
+ROOT::RDF::RNode CutNFlag(ROOT::RDF::RNode df, const std::string &outputname,
+                          const std::string &collection, const int &n) {
+    return df.Define(outputname,
+                     [n](const CompactCollection &objects) {
+                         return objects.size() == n;
+                     },
+                     {collection});
+}
+
+/// Function to create a column with the indices of the objects of the
+/// collection in the original collection, see physicsobject::SelectedObjects
+///
+/// \param[in] df the input dataframe
+/// \param[out] outputname the name of the output column that is created
+/// \param[in] collection the name of the compact collection
+///
+/// \return a dataframe containing a vector of indices for the selected objects
+ROOT::RDF::RNode SelectedObjects(ROOT::RDF::RNode df,
+                                 const std::string &outputname,
+                                 const std::string &collection) {
+    return df.Define(
+        outputname,
+        [](const CompactCollection &objects) { return objects.index; },
+        {collection});
+}
+
+/// Function used to veto a particle, if it is overlapping within a given
+/// DeltaR value with an object of the collection, see
+/// physicsobject::DeltaRParticleVeto
+///
+/// \param df The input dataframe
+/// \param output_flag The name of the veto flag to be added as column to the
+/// dataframe
+/// \param p4 The name of the Lorentz vector column to be used for the particle
+/// to test
+/// \param collection The name of the compact collection to test against
+/// \param dR_cut The maximum dR to be used for the veto
+///
+/// \return a dataframe containing the new veto flag
+ROOT::RDF::RNode DeltaRParticleVeto(ROOT::RDF::RNode df,
+                                    const std::string &output_flag,
+                                    const std::string &p4,
+                                    const std::string &collection,
+                                    const float dR_cut) {
+    auto veto_overlapping_particle =
+        [dR_cut](const ROOT::Math::PtEtaPhiMVector &p4,
+                 const CompactCollection &objects) {
+            for (std::size_t i = 0; i < objects.size(); ++i) {
+                const ROOT::Math::PtEtaPhiMVector p4_test(
+                    objects.pt[i], objects.eta[i], objects.phi[i],
+                    objects.mass[i]);
+                if (ROOT::Math::VectorUtil::DeltaR(p4_test, p4) < dR_cut) {
+                    return true;
+                }
+            }
+            return false;
+        };
+    return df.Define(output_flag, veto_overlapping_particle, {p4, collection});
+}
+
+/// Function to check whether at least one opposite charge pair with a minimal
+/// angular distance is present in the collection, see
+/// physicsobject::CheckForDiLeptonPairs
+///
+/// \param[in] df the input dataframe
+/// \param[out] output_flag the name of the bool column that is created
+/// \param[in] collection the name of the compact lepton collection
+/// \param[in] dR_cut minimum required angular distance between the leptons
+///
+/// \return a dataframe containing the new bool column
+ROOT::RDF::RNode CheckForDiLeptonPairs(ROOT::RDF::RNode df,
+                                       const std::string &output_flag,
+                                       const std::string &collection,
+                                       const float dR_cut) {
+    auto pair_finder_lambda = [dR_cut](const CompactCollection &leptons) {
+        for (std::size_t i = 0; i < leptons.size(); ++i) {
+            for (std::size_t j = i + 1; j < leptons.size(); ++j) {
+                if (leptons.charge[i] != leptons.charge[j]) {
+                    const ROOT::Math::PtEtaPhiMVector p4_1(
+                        leptons.pt[i], leptons.eta[i], leptons.phi[i],
+                        leptons.mass[i]);
+                    const ROOT::Math::PtEtaPhiMVector p4_2(
+                        leptons.pt[j], leptons.eta[j], leptons.phi[j],
+                        leptons.mass[j]);
+                    if (ROOT::Math::VectorUtil::DeltaR(p4_1, p4_2) >= dR_cut)
+                        return true;
+                }
+            }
+        }
+        return false;
+    };
+    return df.Define(output_flag, pair_finder_lambda, {collection});
+}
+} // end namespace compact
+
 /// Muon specific functions
 namespace muon {
 /// Function to cut on muons based on the muon ID
@@ -1809,29 +2003,33 @@ ROOT::RDF::RNode CutIsolation(ROOT::RDF::RNode df, const std::string &maskname,
 }
 
 /// Function to create a column of vector of random numbers between 0 and 1
-/// with size of the input object collection
+/// with size of the input object collection. The generator is seeded per
+/// event from the seed and the (run, lumi, event) triplet, so the numbers do
+/// not depend on the processing order or the number of threads.
 ///
 /// \param[in] df the input dataframe
 /// \param[out] outputname the name of the output column that is created
 /// \param[in] objCollection the name of the input object collection
+/// \param[in] run the name of the run number column
+/// \param[in] lumi the name of the luminosity block column
+/// \param[in] event the name of the event number column
 /// \param[in] seed the seed of the random number generator
 ///
 /// \return a dataframe with the new column
 ROOT::RDF::RNode GenerateRndmRVec(ROOT::RDF::RNode df,
                                   const std::string &outputname,
-                                  const std::string &objCollection, int seed) {
-    gRandom->SetSeed(seed);
-    auto lambda = [](const ROOT::RVec<int> &objects) {
-        const int len = objects.size();
-        float rndm[len];
-        gRandom->RndmArray(len, rndm);
-        ROOT::RVec<float> out = {};
-        for (auto &x : rndm) {
-            out.push_back(x);
-        }
+                                  const std::string &objCollection,
+                                  const std::string &run,
+                                  const std::string &lumi,
+                                  const std::string &event, int seed) {
+    auto lambda = [seed](const ROOT::RVec<int> &objects, const UInt_t &run,
+                         const UInt_t &lumi, const ULong64_t &event) {
+        TRandom3 generator(utility::eventseed::Seed(seed, run, lumi, event));
+        ROOT::RVec<float> out(objects.size());
+        generator.RndmArray(out.size(), out.data());
         return out;
     };
-    return df.Define(outputname, lambda, {objCollection});
+    return df.Define(outputname, lambda, {objCollection, run, lumi, event});
 }
 
 /// Function to create a column of Rochester correction applied transverse
@@ -2013,8 +2211,7 @@ PtCorrection_eleFake(ROOT::RDF::RNode df, const std::string &corrected_pt,
                      const std::string &idAlgorithm,
                      const std::string &sf_dm0_b, const std::string &sf_dm1_b,
                      const std::string &sf_dm0_e, const std::string &sf_dm1_e) {
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(jsonESname);
+    auto evaluator = utility::corrections::Load(sf_file)->at(jsonESname);
     auto tau_pt_correction_lambda = [evaluator, idAlgorithm, sf_dm0_b, sf_dm1_b,
                                      sf_dm0_e, sf_dm1_e](
                                         const ROOT::RVec<float> &pt_values,
@@ -2097,8 +2294,7 @@ PtCorrection_muFake(ROOT::RDF::RNode df, const std::string &corrected_pt,
                     const std::string &decayMode, const std::string &genMatch,
                     const std::string &sf_file, const std::string &jsonESname,
                     const std::string &idAlgorithm, const std::string &sf_es) {
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(jsonESname);
+    auto evaluator = utility::corrections::Load(sf_file)->at(jsonESname);
     auto tau_pt_correction_lambda =
         [evaluator, idAlgorithm, sf_es](const ROOT::RVec<float> &pt_values,
                                         const ROOT::RVec<float> &eta_values,
@@ -2200,8 +2396,7 @@ PtCorrection_genTau(ROOT::RDF::RNode df, const std::string &corrected_pt,
                     const std::string &idAlgorithm, const std::string &DM0,
                     const std::string &DM1, const std::string &DM10,
                     const std::string &DM11) {
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(jsonESname);
+    auto evaluator = utility::corrections::Load(sf_file)->at(jsonESname);
     auto tau_pt_correction_lambda = [evaluator, idAlgorithm, DM0, DM1, DM10,
                                      DM11](
                                         const ROOT::RVec<float> &pt_values,
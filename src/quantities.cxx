@@ -3,6 +3,7 @@
 
 #include "../include/basefunctions.hxx"
 #include "../include/defaults.hxx"
+#include "../include/utility/IndexAccess.hxx"
 #include "../include/utility/Logger.hxx"
 #include "../include/vectoroperations.hxx"
 #include "ROOT/RDataFrame.hxx"
@@ -145,8 +146,8 @@ ROOT::RDF::RNode dxy(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(
         outputname,
         [position](const ROOT::RVec<int> &pair, const ROOT::RVec<float> &dxy) {
-            const int index = pair.at(position);
-            return dxy.at(index, default_float);
+            const int index = utility::index::Position(pair, position);
+            return utility::index::Load(dxy, index, default_float);
         },
         {pairname, dxycolumn});
 }
@@ -167,8 +168,8 @@ ROOT::RDF::RNode dz(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(
         outputname,
         [position](const ROOT::RVec<int> &pair, const ROOT::RVec<float> &dz) {
-            const int index = pair.at(position);
-            return dz.at(index, default_float);
+            const int index = utility::index::Position(pair, position);
+            return utility::index::Load(dz, index, default_float);
         },
         {pairname, dzcolumn});
 }
@@ -189,8 +190,8 @@ ROOT::RDF::RNode charge(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(
         outputname,
         [position](const ROOT::RVec<int> &pair, const ROOT::RVec<int> &charge) {
-            const int index = pair.at(position);
-            return charge.at(index, default_int);
+            const int index = utility::index::Position(pair, position);
+            return utility::index::Load(charge, index, default_int);
         },
         {pairname, chargecolumn});
 }
@@ -470,8 +471,10 @@ ROOT::RDF::RNode isolation(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(outputname,
                      [position](const ROOT::RVec<int> &pair,
                                 const ROOT::RVec<float> &isolation) {
-                         const int index = pair.at(position);
-                         return isolation.at(index, default_float);
+                         const int index =
+                             utility::index::Position(pair, position);
+                         return utility::index::Load(isolation, index,
+                                                     default_float);
                      },
                      {pairname, isolationcolumn});
 }
@@ -492,8 +495,8 @@ ROOT::RDF::RNode pdgid(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(
         outputname,
         [position](const ROOT::RVec<int> &pair, const ROOT::RVec<int> &pdgid) {
-            const int index = pair.at(position);
-            return pdgid.at(index, default_pdgid);
+            const int index = utility::index::Position(pair, position);
+            return utility::index::Load(pdgid, index, default_pdgid);
         },
         {pairname, pdgidcolumn});
 }
@@ -554,8 +557,10 @@ ROOT::RDF::RNode decaymode(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(outputname,
                      [position](const ROOT::RVec<int> &pair,
                                 const ROOT::RVec<int> &decaymode) {
-                         const int index = pair.at(position);
-                         return decaymode.at(index, default_int);
+                         const int index =
+                             utility::index::Position(pair, position);
+                         return utility::index::Load(decaymode, index,
+                                                     default_int);
                      },
                      {pairname, decaymodecolumn});
 }
@@ -584,8 +589,10 @@ ROOT::RDF::RNode genmatch(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(outputname,
                      [position](const ROOT::RVec<int> &pair,
                                 const ROOT::RVec<UChar_t> &genmatch) {
-                         const int index = pair.at(position);
-                         return genmatch.at(index, default_uchar);
+                         const int index =
+                             utility::index::Position(pair, position);
+                         return utility::index::Load(genmatch, index,
+                                                     default_uchar);
                      },
                      {pairname, genmatchcolumn});
 }
@@ -611,9 +618,12 @@ ROOT::RDF::RNode matching_jet_pt(ROOT::RDF::RNode df,
                      [position](const ROOT::RVec<int> &pair,
                                 const ROOT::RVec<int> &taujets,
                                 const ROOT::RVec<float> &jetpt) {
-                         const int tauindex = pair.at(position);
-                         const int jetindex = taujets.at(tauindex, -1);
-                         return jetpt.at(jetindex, default_float);
+                         const int tauindex =
+                             utility::index::Position(pair, position);
+                         const int jetindex = utility::index::Load(
+                             taujets, tauindex, utility::index::missing);
+                         return utility::index::Load(jetpt, jetindex,
+                                                     default_float);
                      },
                      {pairname, taujet_index, jetpt_column});
 }
@@ -641,10 +651,14 @@ ROOT::RDF::RNode matching_genjet_pt(
                                 const ROOT::RVec<int> &taujets,
                                 const ROOT::RVec<int> &genjets,
                                 const ROOT::RVec<float> &genjetpt) {
-                         const int tauindex = pair.at(position);
-                         const int jetindex = taujets.at(tauindex, -1);
-                         const int genjetindex = genjets.at(jetindex, -1);
-                         return genjetpt.at(genjetindex, default_float);
+                         const int tauindex =
+                             utility::index::Position(pair, position);
+                         const int jetindex = utility::index::Load(
+                             taujets, tauindex, utility::index::missing);
+                         const int genjetindex = utility::index::Load(
+                             genjets, jetindex, utility::index::missing);
+                         return utility::index::Load(genjetpt, genjetindex,
+                                                     default_float);
                      },
                      {pairname, taujet_index, genjet_index, genjetpt_column});
 }
@@ -671,8 +685,9 @@ ROOT::RDF::RNode TauIDFlag(ROOT::RDF::RNode df, const std::string &outputname,
                 ->debug(
                     "position tau in pair {}, pair {}, id bit {}, vsjet ids {}",
                     position, pair, idxID, IDs);
-            const int index = pair.at(position);
-            const int ID = IDs.at(index, default_int);
+            const int index = utility::index::Position(pair, position);
+            const int ID =
+                utility::index::Load<UChar_t>(IDs, index, default_int);
             if (ID != default_int)
                 return std::min(1, int(ID & 1 << (idxID - 1)));
             else
@@ -699,8 +714,8 @@ ROOT::RDF::RNode id(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(
         outputname,
         [position](const ROOT::RVec<int> &pair, const ROOT::RVec<bool> &id) {
-            const int index = pair.at(position, -1);
-            return id.at(index, false);
+            const int index = utility::index::Position(pair, position);
+            return utility::index::Load(id, index, false);
         },
         {pairname, idcolumn});
 }
@@ -720,8 +735,9 @@ ROOT::RDF::RNode is_global(ROOT::RDF::RNode df, const std::string &outputname,
     return df.Define(outputname,
                      [position](const ROOT::RVec<int> &pair,
                                 const ROOT::RVec<bool> &globalflag) {
-                         const int index = pair.at(position, -1);
-                         return globalflag.at(index, false);
+                         const int index =
+                             utility::index::Position(pair, position);
+                         return utility::index::Load(globalflag, index, false);
                      },
                      {pairname, globalflagcolumn});
 }
@@ -2,6 +2,7 @@
 #define GUARD_REWEIGHTING_H
 
 #include "../include/basefunctions.hxx"
+#include "../include/utility/CorrectionCache.hxx"
 #include "../include/utility/Logger.hxx"
 #include "../include/utility/RooFunctorThreadsafe.hxx"
 #include "ROOT/RDataFrame.hxx"
@@ -68,8 +69,7 @@ ROOT::RDF::RNode puweights(ROOT::RDF::RNode df, const std::string &weightname,
                            const std::string &filename,
                            const std::string &eraname,
                            const std::string &variation) {
-    auto evaluator =
-        correction::CorrectionSet::from_file(filename)->at(eraname);
+    auto evaluator = utility::corrections::Load(filename)->at(eraname);
     auto df1 =
         df.Define(weightname,
                   [evaluator, variation](const float &pu) {
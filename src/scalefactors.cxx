@@ -2,6 +2,7 @@
 #define GUARD_SCALEFACTORS_H
 
 #include "../include/basefunctions.hxx"
+#include "../include/utility/CorrectionCache.hxx"
 #include "../include/utility/Logger.hxx"
 #include "../include/utility/RooFunctorThreadsafe.hxx"
 #include "ROOT/RDataFrame.hxx"
@@ -103,8 +104,7 @@ ROOT::RDF::RNode id(ROOT::RDF::RNode df, const std::string &pt,
 
     Logger::get("muonIdSF")->debug("Setting up functions for muon id sf");
     Logger::get("muonIdSF")->debug("ID - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto df1 = df.Define(
         id_output,
         [evaluator, year_id, variation](const float &pt, const float &eta) {
@@ -131,8 +131,7 @@ ROOT::RDF::RNode id_vhmm(ROOT::RDF::RNode df, const std::string &p4,
 
     Logger::get("muonIdSF")->debug("Setting up functions for muon id sf");
     Logger::get("muonIdSF")->debug("ID - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto df1 = df.Define(
         id_output,
         [evaluator, year_id, variation](ROOT::Math::PtEtaPhiMVector &p4) {
@@ -182,8 +181,7 @@ ROOT::RDF::RNode iso(ROOT::RDF::RNode df, const std::string &pt,
 
     Logger::get("muonIsoSF")->debug("Setting up functions for muon iso sf");
     Logger::get("muonIsoSF")->debug("ISO - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto df1 = df.Define(
         iso_output,
         [evaluator, year_id, variation](const float &pt, const float &eta) {
@@ -209,8 +207,7 @@ ROOT::RDF::RNode iso_vhmm(ROOT::RDF::RNode df, const std::string &p4,
 
     Logger::get("muonIsoSF")->debug("Setting up functions for muon iso sf");
     Logger::get("muonIsoSF")->debug("ISO - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto df1 = df.Define(
         iso_output,
         [evaluator, year_id, variation](ROOT::Math::PtEtaPhiMVector &p4) {
@@ -294,8 +291,7 @@ id_vsJet_lt(ROOT::RDF::RNode df, const std::string &pt,
     Logger::get("TauIDvsJet_lt_SF")
         ->debug("Setting up function for tau id vsJet sf");
     Logger::get("TauIDvsJet_lt_SF")->debug("ID - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto idSF_calculator = [evaluator, wp, sf_vsjet_tau30to35,
                             sf_vsjet_tau35to40, sf_vsjet_tau40to500,
                             sf_vsjet_tau500to1000, sf_vsjet_tau1000toinf,
@@ -390,8 +386,7 @@ ROOT::RDF::RNode id_vsJet_lt_embedding(
         ->debug("Setting up function for tau id vsJet sf");
     Logger::get("TauIDvsJet_lt_SF_embedding")
         ->debug("ID - Name {}", correctionset);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(correctionset);
+    auto evaluator = utility::corrections::Load(sf_file)->at(correctionset);
     auto idSF_calculator = [evaluator, wp, sf_vsjet_tau20to25,
                             sf_vsjet_tau25to30, sf_vsjet_tau30to35,
                             sf_vsjet_tau35to40, sf_vsjet_tau40toInf,
@@ -460,8 +455,7 @@ ROOT::RDF::RNode id_vsJet_tt_embedding(
         ->debug("Setting up function for tau id vsJet sf");
     Logger::get("TauIDvsJet_tt_SF_embedding")
         ->debug("ID - Name {}", correctionset);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(correctionset);
+    auto evaluator = utility::corrections::Load(sf_file)->at(correctionset);
     auto idSF_calculator = [evaluator, wp, sf_vsjet_tauDM0, sf_vsjet_tauDM1,
                             sf_vsjet_tauDM10, sf_vsjet_tauDM11,
                             correctionset](const int &decaymode) {
@@ -545,8 +539,7 @@ ROOT::RDF::RNode id_vsJet_tt(
     Logger::get("TauIDvsJet_tt_SF")
         ->debug("Setting up function for tau id vsJet sf");
     Logger::get("TauIDvsJet_tt_SF")->debug("ID - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto idSF_calculator = [evaluator, wp, sf_vsjet_tauDM0, sf_vsjet_tauDM1,
                             sf_vsjet_tauDM10, sf_vsjet_tauDM11, sf_dependence,
                             selectedDMs,
@@ -648,8 +641,7 @@ id_vsEle(ROOT::RDF::RNode df, const std::string &eta,
     Logger::get("TauIDvsEleSF")
         ->debug("Setting up function for tau id vsEle sf");
     Logger::get("TauIDvsEleSF")->debug("ID - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto idSF_calculator = [evaluator, wp, sf_vsele_barrel, sf_vsele_endcap,
                             selectedDMs,
                             idAlgorithm](const float &eta, const int &decayMode,
@@ -747,8 +739,7 @@ id_vsMu(ROOT::RDF::RNode df, const std::string &eta,
 
     Logger::get("TauIDvsMuSF")->debug("Setting up function for tau id vsMu sf");
     Logger::get("TauIDvsMuSF")->debug("ID - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto idSF_calculator = [evaluator, wp, sf_vsmu_wheel1, sf_vsmu_wheel2,
                             sf_vsmu_wheel3, sf_vsmu_wheel4, sf_vsmu_wheel5,
                             selectedDMs,
@@ -829,8 +820,7 @@ ROOT::RDF::RNode id(ROOT::RDF::RNode df, const std::string &pt,
     Logger::get("electronIDSF")
         ->debug("Setting up functions for electron id sf with correctionlib");
     Logger::get("electronIDSF")->debug("ID - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto df1 = df.Define(
         id_output,
         [evaluator, year_id, idAlgorithm, wp, variation](const float &pt,
@@ -858,8 +848,7 @@ ROOT::RDF::RNode id_e_vhmm(ROOT::RDF::RNode df,
     Logger::get("electronIDSF")
         ->debug("Setting up functions for electron id sf with correctionlib");
     Logger::get("electronIDSF")->debug("ID - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto df1 = df.Define(
         id_output,
         [evaluator, year_id, idAlgorithm, wp, variation](ROOT::Math::PtEtaPhiMVector &p4) {
@@ -918,8 +907,7 @@ btagSF(ROOT::RDF::RNode df, const std::string &pt, const std::string &eta,
         "Setting up functions for b-tag sf with correctionlib");
     Logger::get("btagSF")->debug("Correction algorithm - Name {}",
                                  corr_algorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(corr_algorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(corr_algorithm);
 
     auto btagSF_lambda = [evaluator,
                           variation](const ROOT::RVec<float> &pt_values,
@@ -1020,8 +1008,7 @@ selection_trigger(ROOT::RDF::RNode df, const std::string &pt_1,
 
     Logger::get("EmbeddingSelectionTriggerSF")
         ->debug("Correction - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto df1 = df.Define(
         output,
         [evaluator](const float &pt_1, const float &eta_1, const float &pt_2,
@@ -1059,8 +1046,7 @@ ROOT::RDF::RNode selection_id(ROOT::RDF::RNode df, const std::string &pt,
 
     Logger::get("EmbeddingSelectionIDSF")
         ->debug("Correction - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto df1 =
         df.Define(output,
                   [evaluator](const float &pt, const float &eta) {
@@ -1098,8 +1084,7 @@ ROOT::RDF::RNode muon_sf(ROOT::RDF::RNode df, const std::string &pt,
                          const float &extrapolation_factor = 1.0) {
 
     Logger::get("EmbeddingMuonSF")->debug("Correction - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto df1 = df.Define(
         output,
         [evaluator, correctiontype, extrapolation_factor](const float &pt,
@@ -1143,8 +1128,7 @@ ROOT::RDF::RNode electron_sf(ROOT::RDF::RNode df, const std::string &pt,
 
     Logger::get("EmbeddingElectronSF")
         ->debug("Correction - Name {}", idAlgorithm);
-    auto evaluator =
-        correction::CorrectionSet::from_file(sf_file)->at(idAlgorithm);
+    auto evaluator = utility::corrections::Load(sf_file)->at(idAlgorithm);
     auto df1 = df.Define(
         output,
         [evaluator, correctiontype, extrapolation_factor](const float &pt,
@@ -1162,6 +1146,129 @@ ROOT::RDF::RNode electron_sf(ROOT::RDF::RNode df, const std::string &pt,
         {pt, eta});
     return df1;
 }
+/**
+ * @brief Function used to evaluate several embedding scale factors of the two
+ * legs of the embedding selection in a single pass. Each scale factor is
+ * given by the name of the correction, the leg it is evaluated for and the
+ * correction type. The corrections are resolved once, and all scale factors
+ * are evaluated in a single Define, returning a vector with one entry per
+ * scale factor. This vector is then split into the output columns. The
+ * results are identical to the ones of `selection_trigger`, `selection_id`,
+ * `muon_sf` and `electron_sf`.
+ *
+ * @param df the input dataframe
+ * @param pt_1 the pt of the first leg
+ * @param eta_1 the eta of the first leg
+ * @param pt_2 the pt of the second leg
+ * @param eta_2 the eta of the second leg
+ * @param outputs the names of the output columns, one per scale factor
+ * @param sf_file the path to the correctionlib file containing the scale
+ * factors
+ * @param corrections the names of the scale factors in the correctionlib file
+ * @param legs the leg of each scale factor, `1` or `2` for scale factors of a
+ * single leg, `12` for scale factors of both legs, like the selection trigger
+ * @param correctiontypes the correction type of each scale factor, `emb` for
+ * embedding and `mc` for monte carlo, or an empty string for scale factors
+ * without a correction type, like the selection scale factors
+ * @param extrapolation_factors the extrapolation factor of each scale factor
+ * @return ROOT::RDF::RNode
+ */
+ROOT::RDF::RNode
+fused_sf(ROOT::RDF::RNode df, const std::string &pt_1,
+         const std::string &eta_1, const std::string &pt_2,
+         const std::string &eta_2, const std::vector<std::string> &outputs,
+         const std::string &sf_file,
+         const std::vector<std::string> &corrections,
+         const std::vector<std::string> &legs,
+         const std::vector<std::string> &correctiontypes,
+         const std::vector<float> &extrapolation_factors) {
+    const std::size_t nsfs = outputs.size();
+    if (corrections.size() != nsfs || legs.size() != nsfs ||
+        correctiontypes.size() != nsfs ||
+        extrapolation_factors.size() != nsfs) {
+        Logger::get("EmbeddingFusedSF")
+            ->error("Received {} outputs, but {} corrections, {} legs, {} "
+                    "correction types and {} extrapolation factors",
+                    nsfs, corrections.size(), legs.size(),
+                    correctiontypes.size(), extrapolation_factors.size());
+        throw std::invalid_argument(
+            "the number of embedding scale factors and outputs do not match");
+    }
+    struct Request {
+        correction::Correction::Ref evaluator;
+        int leg;
+        std::string correctiontype;
+        float extrapolation_factor;
+    };
+    // every correction is resolved once, even if it is used for several legs
+    // or correction types
+    auto correctionset = utility::corrections::Load(sf_file);
+    std::map<std::string, correction::Correction::Ref> evaluators;
+    std::vector<Request> requests;
+    for (std::size_t i = 0; i < nsfs; ++i) {
+        auto evaluator = evaluators.find(corrections[i]);
+        if (evaluator == evaluators.end())
+            evaluator =
+                evaluators
+                    .emplace(corrections[i], correctionset->at(corrections[i]))
+                    .first;
+        int leg = 0;
+        if (legs[i] == "1" || legs[i] == "2" || legs[i] == "12") {
+            leg = std::stoi(legs[i]);
+        } else {
+            Logger::get("EmbeddingFusedSF")
+                ->error("Invalid leg {} for {}, use 1, 2 or 12", legs[i],
+                        outputs[i]);
+            throw std::invalid_argument("invalid leg of an embedding scale "
+                                        "factor");
+        }
+        Logger::get("EmbeddingFusedSF")
+            ->debug("{}: correction {}, leg {}, correction type {}, "
+                    "extrapolation factor {}",
+                    outputs[i], corrections[i], legs[i], correctiontypes[i],
+                    extrapolation_factors[i]);
+        requests.push_back({evaluator->second, leg, correctiontypes[i],
+                            extrapolation_factors[i]});
+    }
+    Logger::get("EmbeddingFusedSF")
+        ->debug("Evaluating {} scale factors from {} corrections", nsfs,
+                evaluators.size());
+    if (nsfs == 0)
+        return df;
+    const std::string fused_output = outputs[0] + "_fused";
+    auto df1 = df.Define(
+        fused_output,
+        [requests](const float &pt_1, const float &eta_1, const float &pt_2,
+                   const float &eta_2) {
+            ROOT::RVec<double> sfs(requests.size());
+            for (std::size_t i = 0; i < requests.size(); ++i) {
+                const auto &request = requests[i];
+                if (request.leg == 12) {
+                    sfs[i] = request.evaluator->evaluate(
+                        {pt_1, std::abs(eta_1), pt_2, std::abs(eta_2)});
+                } else {
+                    const float pt = request.leg == 1 ? pt_1 : pt_2;
+                    const float eta = request.leg == 1 ? eta_1 : eta_2;
+                    if (request.correctiontype.empty())
+                        sfs[i] =
+                            request.evaluator->evaluate({pt, std::abs(eta)});
+                    else
+                        sfs[i] = request.evaluator->evaluate(
+                            {pt, std::abs(eta), request.correctiontype});
+                }
+                sfs[i] *= request.extrapolation_factor;
+            }
+            return sfs;
+        },
+        {pt_1, eta_1, pt_2, eta_2});
+    for (std::size_t i = 0; i < nsfs; ++i) {
+        df1 = df1.Define(
+            outputs[i],
+            [i](const ROOT::RVec<double> &sfs) { return sfs[i]; },
+            {fused_output});
+    }
+    return df1;
+}
 } // namespace embedding
 } // namespace scalefactor
 #endif /* GUARD_SCALEFACTORS_H */
\ No newline at end of file
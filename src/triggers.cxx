@@ -2,14 +2,25 @@
 #define GUARD_TRIGGERS_H
 
 #include "../include/utility/Logger.hxx"
+#include "../include/utility/SlotCounters.hxx"
 #include "ROOT/RDataFrame.hxx"
 #include "ROOT/RVec.hxx"
+#include "TTree.h"
 #include "bitset"
 #include <Math/Vector3D.h>
 #include <Math/Vector4D.h>
 #include <Math/VectorUtil.h>
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <map>
+#include <memory>
 #include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 typedef std::bitset<30> IntBits;
 
@@ -790,6 +801,462 @@ ROOT::RDF::RNode GenerateQuadTriggerORFlag(
         return df1;
     }
 }
+/**
+ * @brief Function to resolve a set of HLT paths against the columns of the
+ * dataframe. The names are resolved once, here, so that downstream trigger
+ * flags only have to test a bit of the bitmask created by GenerateHLTBitset()
+ * instead of reading their own HLT branch and repeating the lookup for every
+ * trigger producer and shift.
+ *
+ * @param df The input dataframe
+ * @param hltpaths vector of hlt paths, each entry can be a valid regex. If
+ * more than one matching HLT path is found for an entry, the function will
+ * throw an exception.
+ * @return for each entry of hltpaths, the name of the matching HLT path, or an
+ * empty string if no HLT path matches
+ */
+std::vector<std::string>
+MatchHLTPaths(ROOT::RDF::RNode df, const std::vector<std::string> &hltpaths) {
+    auto available_trigger = df.GetColumnNames();
+    std::vector<std::string> matched(hltpaths.size());
+    for (std::size_t i = 0; i < hltpaths.size(); ++i) {
+        std::vector<std::string> matched_trigger_names;
+        std::regex hltpath_regex = std::regex(hltpaths[i]);
+        for (auto &trigger : available_trigger) {
+            if (std::regex_match(trigger, hltpath_regex)) {
+                matched_trigger_names.push_back(trigger);
+            }
+        }
+        if (matched_trigger_names.size() == 0) {
+            Logger::get("MatchHLTPaths")
+                ->info("No matching trigger for {} found", hltpaths[i]);
+        } else if (matched_trigger_names.size() > 1) {
+            Logger::get("MatchHLTPaths")
+                ->debug(
+                    "More than one matching trigger found, not implemented yet");
+            throw std::invalid_argument(
+                "received too many matching trigger paths, not implemented yet");
+        } else {
+            Logger::get("MatchHLTPaths")
+                ->debug("Using trigger {} for {}", matched_trigger_names[0],
+                        hltpaths[i]);
+            matched[i] = matched_trigger_names[0];
+        }
+    }
+    return matched;
+}
+
+namespace {
+/// Counts of the primary dataset overlap veto, counted per slot of the event
+/// loop. A vetoed event is counted for the highest-priority primary dataset
+/// whose triggers fired.
+struct OverlapReport {
+    struct Counts {
+        ULong64_t total = 0;
+        ULong64_t passed = 0;
+        std::vector<ULong64_t> vetoed;
+    };
+
+    // counter indices: total, passed and vetoed per higher-priority PD
+    OverlapReport(const std::string &name, const std::string &dataset,
+                  const std::vector<std::string> &higher, unsigned int nslots)
+        : name(name), dataset(dataset), higher(higher),
+          counters(2 + higher.size(), nslots) {}
+
+    void Count(unsigned int slot, ULong64_t fired) {
+        counters.Increment(slot, 0);
+        if (fired == 0) {
+            counters.Increment(slot, 1);
+            return;
+        }
+        std::size_t first = 0;
+        while (!((fired >> first) & 1))
+            ++first;
+        counters.Increment(slot, 2 + first);
+    }
+
+    /// the counts summed over all slots
+    Counts Sum() const {
+        const auto sum = counters.Sum();
+        Counts counts;
+        counts.total = sum[0];
+        counts.passed = sum[1];
+        counts.vetoed.assign(sum.begin() + 2, sum.end());
+        return counts;
+    }
+
+    std::string name;
+    std::string dataset;
+    std::vector<std::string> higher;
+    utility::slotcounters::SlotCounters counters;
+};
+
+std::vector<std::shared_ptr<OverlapReport>> &OverlapReports() {
+    static std::vector<std::shared_ptr<OverlapReport>> reports;
+    return reports;
+}
+
+std::string &CurrentPrimaryDataset() {
+    static std::string dataset;
+    return dataset;
+}
+} // namespace
+
+/**
+ * @brief Function to determine the primary dataset (PD) of the input files of
+ * a data executable, which is used by the overlap veto
+ * PrimaryDatasetOverlapVeto(). If the environment variable
+ * `CROWN_PRIMARY_DATASET` is set, its value is used. Otherwise, the directories
+ * of every input file are compared to the datasets of the sample database: a
+ * directory starting with the nickname of a dataset, as used by the local
+ * copies of a sample, or named like a primary dataset, as in the
+ * `/store/data/<era>/<PD>/` paths of the original files, identifies the PD of
+ * the file. All input files have to belong to the same PD.
+ *
+ * @param input_files the input files of the executable
+ * @param datasets mapping of the nicknames of the data samples in the sample
+ * database to their PD, empty for simulated samples
+ * @return the PD, or an empty string if it could not be determined
+ */
+std::string
+IdentifyPrimaryDataset(const std::vector<std::string> &input_files,
+                       const std::map<std::string, std::string> &datasets) {
+    auto &dataset = CurrentPrimaryDataset();
+    if (const char *forced = std::getenv("CROWN_PRIMARY_DATASET")) {
+        dataset = forced;
+        Logger::get("IdentifyPrimaryDataset")
+            ->info("Primary dataset set to {} via CROWN_PRIMARY_DATASET",
+                   dataset);
+        return dataset;
+    }
+    dataset.clear();
+    if (datasets.empty())
+        return dataset;
+    for (auto const &file : input_files) {
+        std::string identified;
+        std::stringstream path(file);
+        std::string directory;
+        while (identified.empty() && std::getline(path, directory, '/')) {
+            for (auto const &[nick, pd] : datasets) {
+                if (directory.rfind(nick, 0) == 0 || directory == pd) {
+                    identified = pd;
+                    break;
+                }
+            }
+        }
+        if (identified.empty()) {
+            Logger::get("IdentifyPrimaryDataset")
+                ->warn("Could not determine the primary dataset of {}", file);
+            dataset.clear();
+            return dataset;
+        }
+        if (!dataset.empty() && identified != dataset) {
+            Logger::get("IdentifyPrimaryDataset")
+                ->error("Input files of the primary datasets {} and {} can "
+                        "not be processed together",
+                        dataset, identified);
+            throw std::invalid_argument(
+                "input files of different primary datasets");
+        }
+        dataset = identified;
+    }
+    Logger::get("IdentifyPrimaryDataset")
+        ->info("Processing primary dataset {}", dataset);
+    return dataset;
+}
+
+/**
+ * @brief Function to select the HLT paths checked by the overlap veto
+ * PrimaryDatasetOverlapVeto(), which are the paths of the primary datasets
+ * (PDs) with a higher priority than the processed one. The processed PD is
+ * determined by IdentifyPrimaryDataset().
+ *
+ * @param df The input dataframe
+ * @param datasets the PDs, ordered by their priority starting with the
+ * highest
+ * @param path_datasets the PD of each HLT path
+ * @param paths the HLT paths, each entry can be a valid regex matching at
+ * most one HLT path. For every PD with a higher priority than the processed
+ * one, at least one of its paths has to be found in the input.
+ * @param columns the selected HLT path columns
+ * @param bits for each selected column, the position of its PD in datasets
+ * @return false if no veto has to be applied, since the processed PD has no
+ * priority
+ */
+bool MatchOverlapVetoPaths(ROOT::RDF::RNode df,
+                           const std::vector<std::string> &datasets,
+                           const std::vector<std::string> &path_datasets,
+                           const std::vector<std::string> &paths,
+                           std::vector<std::string> &columns,
+                           std::vector<std::size_t> &bits) {
+    if (path_datasets.size() != paths.size() || datasets.size() > 64) {
+        Logger::get("PrimaryDatasetOverlapVeto")
+            ->error("Received {} primary datasets, and {} HLT paths with {} "
+                    "primary datasets, expected the same number of paths and "
+                    "datasets and at most 64 primary datasets",
+                    datasets.size(), paths.size(), path_datasets.size());
+        throw std::invalid_argument(
+            "invalid primary dataset priorities for the overlap veto");
+    }
+    const std::string &dataset = CurrentPrimaryDataset();
+    if (dataset.empty()) {
+        Logger::get("PrimaryDatasetOverlapVeto")
+            ->error("The primary dataset of the input files is not known, "
+                    "set it via CROWN_PRIMARY_DATASET");
+        throw std::runtime_error(
+            "unknown primary dataset for the overlap veto");
+    }
+    const auto position =
+        std::find(datasets.begin(), datasets.end(), dataset) - datasets.begin();
+    if (position == static_cast<long>(datasets.size())) {
+        Logger::get("PrimaryDatasetOverlapVeto")
+            ->warn("Primary dataset {} has no priority, no overlap veto is "
+                   "applied",
+                   dataset);
+        return false;
+    }
+    // bit i of the mask is set if any trigger of the i-th PD fired, only PDs
+    // with a higher priority than the processed one are included
+    const auto matched = MatchHLTPaths(df, paths);
+    std::vector<std::size_t> found(position, 0);
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        const auto bit =
+            std::find(datasets.begin(), datasets.end(), path_datasets[i]) -
+            datasets.begin();
+        if (bit == static_cast<long>(datasets.size())) {
+            Logger::get("PrimaryDatasetOverlapVeto")
+                ->error("HLT path {} belongs to {}, which has no priority",
+                        paths[i], path_datasets[i]);
+            throw std::invalid_argument(
+                "HLT path of an unknown primary dataset in the overlap veto");
+        }
+        if (bit >= position || matched[i].empty())
+            continue;
+        columns.push_back(matched[i]);
+        bits.push_back(bit);
+        ++found[bit];
+    }
+    for (long bit = 0; bit < position; ++bit) {
+        if (found[bit] == 0) {
+            Logger::get("PrimaryDatasetOverlapVeto")
+                ->error("No HLT path of {} is found in the input, the overlap "
+                        "with {} can not be removed",
+                        datasets[bit], datasets[bit]);
+            throw std::invalid_argument(
+                "no HLT path for a primary dataset of the overlap veto");
+        }
+        Logger::get("PrimaryDatasetOverlapVeto")
+            ->info("Vetoing events of {} triggered for {} ({} HLT paths)",
+                   dataset, datasets[bit], found[bit]);
+    }
+    return true;
+}
+
+/**
+ * @brief Function to apply the bitmask of the fired PDs defined by
+ * PrimaryDatasetOverlapVeto(). Events with an empty mask are kept, the
+ * numbers of processed, passed and vetoed events are counted in a report.
+ *
+ * @param df The dataframe containing the bitmask
+ * @param filtername name of the filter in the dataframe report
+ * @param mask name of the bitmask column of the fired PDs
+ * @param datasets the PDs, ordered by their priority starting with the
+ * highest
+ * @return a dataframe with the veto applied
+ */
+ROOT::RDF::RNode FilterOverlapVeto(ROOT::RDF::RNode df,
+                                   const std::string &filtername,
+                                   const std::string &mask,
+                                   const std::vector<std::string> &datasets) {
+    const std::string &dataset = CurrentPrimaryDataset();
+    const auto position =
+        std::find(datasets.begin(), datasets.end(), dataset) - datasets.begin();
+    auto report = std::make_shared<OverlapReport>(
+        utility::slotcounters::UniqueName(OverlapReports(), filtername),
+        dataset,
+        std::vector<std::string>(datasets.begin(),
+                                 datasets.begin() + position),
+        df.GetNSlots());
+    OverlapReports().push_back(report);
+    return df.Filter(
+        [report](unsigned int slot, const ULong64_t fired) {
+            report->Count(slot, fired);
+            return fired == 0;
+        },
+        {"rdfslot_", mask}, filtername);
+}
+
+/// Function to print the counts of all overlap vetoes applied with
+/// PrimaryDatasetOverlapVeto(). Has to be called after the event loop.
+void PrintOverlapReports() {
+    for (auto const &report : OverlapReports()) {
+        const auto sum = report->Sum();
+        Logger::get("PrimaryDatasetOverlapVeto")
+            ->info("{} ({}): {} events, {} passed", report->name,
+                   report->dataset, sum.total, sum.passed);
+        for (std::size_t i = 0; i < report->higher.size(); ++i) {
+            Logger::get("PrimaryDatasetOverlapVeto")
+                ->info("    vetoed as duplicate of {}: {}", report->higher[i],
+                       sum.vetoed[i]);
+        }
+    }
+}
+
+/// Function to write the counts of all overlap vetoes applied with
+/// PrimaryDatasetOverlapVeto() to the current directory. For each veto, a tree
+/// with the name of the filter is written, titled with the processed PD and
+/// containing the total number of events, the number of passed events and
+/// the number of events vetoed for each PD with a higher priority as
+/// `<PD>_vetoed`.
+void WriteOverlapReports() {
+    for (auto const &report : OverlapReports()) {
+        auto sum = report->Sum();
+        TTree meta(report->name.c_str(), report->dataset.c_str());
+        meta.Branch("total", &sum.total);
+        meta.Branch("passed", &sum.passed);
+        for (std::size_t i = 0; i < report->higher.size(); ++i) {
+            meta.Branch((report->higher[i] + "_vetoed").c_str(),
+                        &sum.vetoed[i]);
+        }
+        meta.Fill();
+        meta.Write();
+    }
+}
+
+/**
+ * @brief Function to match the objects of a collection geometrically to the
+ * trigger objects of an hlt path. This is the shift-invariant stage of the
+ * trigger matching: the deltaR match, the triggerobject id and the
+ * triggerobject bit only depend on the eta and phi of the objects, which are
+ * not changed by energy scale shifts. The match is therefore computed once per
+ * collection object in the nominal path, and the pt and eta thresholds are
+ * applied per shift by trigger::GenerateTriggerORFlagFromMatch.
+ *
+ * For each object of the collection, the index of the closest trigger object
+ * within the given deltaR cone, with the required triggerobject id and
+ * triggerobject bit, is stored. If no trigger object matches, or if the hlt
+ * path did not fire, the index is -1.
+ *
+ * @param df The input dataframe
+ * @param outputname name of the output column (`ROOT::RVec<int>`)
+ * @param object_etas name of the eta column of the object collection
+ * @param object_phis name of the phi column of the object collection
+ * @param triggerobject_bits name of the trigger object bits column in the
+ * inputfile
+ * @param triggerobject_id name of the trigger object id column in the inputfile
+ * @param triggerobject_eta name of the trigger object eta column in the
+ * inputfile
+ * @param triggerobject_phi name of the trigger object phi column in the
+ * inputfile
+ * @param hltbits name of the bitmask column created by
+ * trigger::GenerateHLTBitset
+ * @param hltbit position of the hlt path in the bitmask
+ * @param trigger_particle_id_cut trigger id value the triggerobject has to
+ * match (details can be found in the documentation of trigger::matchParticle)
+ * @param triggerbit_cut trigger bit value the triggerobject has to match
+ * (details can be found in the documentation of trigger::matchParticle)
+ * @param DeltaR_threshold maximal value for the deltaR between the
+ * triggerobject and the object to consider a match
+ * @return a new dataframe containing the match column
+ */
+ROOT::RDF::RNode GeometricTriggerMatch(
+    ROOT::RDF::RNode df, const std::string &outputname,
+    const std::string &object_etas, const std::string &object_phis,
+    const std::string &triggerobject_bits, const std::string &triggerobject_id,
+    const std::string &triggerobject_eta, const std::string &triggerobject_phi,
+    const std::string &hltbits, const int &hltbit,
+    const int &trigger_particle_id_cut, const int &triggerbit_cut,
+    const float &DeltaR_threshold) {
+    auto geometricmatch = [hltbit, trigger_particle_id_cut, triggerbit_cut,
+                           DeltaR_threshold](
+                              const ROOT::RVec<float> &object_etas,
+                              const ROOT::RVec<float> &object_phis,
+                              const ULong64_t &hltbits,
+                              const ROOT::RVec<int> &triggerobject_bits,
+                              const ROOT::RVec<int> &triggerobject_ids,
+                              const ROOT::RVec<float> &triggerobject_etas,
+                              const ROOT::RVec<float> &triggerobject_phis) {
+        ROOT::RVec<int> matches(object_etas.size(), -1);
+        if (!((hltbits >> hltbit) & 1))
+            return matches;
+        for (std::size_t idx = 0; idx < object_etas.size(); ++idx) {
+            // same deltaR definition as in trigger::matchParticle
+            const ROOT::Math::PtEtaPhiMVector object(1., object_etas[idx],
+                                                     object_phis[idx], 0.);
+            float best_deltaR = DeltaR_threshold;
+            for (std::size_t trg = 0; trg < triggerobject_etas.size(); ++trg) {
+                if (triggerobject_ids[trg] != trigger_particle_id_cut)
+                    continue;
+                if (triggerbit_cut != -1 &&
+                    !IntBits(triggerobject_bits[trg]).test(triggerbit_cut))
+                    continue;
+                const auto triggerobject = ROOT::Math::RhoEtaPhiVectorF(
+                    0, triggerobject_etas[trg], triggerobject_phis[trg]);
+                const float deltaR =
+                    ROOT::Math::VectorUtil::DeltaR(triggerobject, object);
+                if (deltaR < best_deltaR) {
+                    best_deltaR = deltaR;
+                    matches[idx] = trg;
+                }
+            }
+        }
+        Logger::get("GeometricTriggerMatch")
+            ->debug("trigger object matches: {}", matches);
+        return matches;
+    };
+    return df.Define(outputname, geometricmatch,
+                     {object_etas, object_phis, hltbits, triggerobject_bits,
+                      triggerobject_id, triggerobject_eta, triggerobject_phi});
+}
+
+/**
+ * @brief Function to generate a trigger flag from the geometric trigger
+ * object match created by trigger::GeometricTriggerMatch, where at least one
+ * of the leading objects of a collection has to be matched. This is the cheap
+ * per-shift stage of the trigger matching, only the pt and eta thresholds are
+ * checked for the (possibly shifted) objects. The result is identical to the
+ * one of trigger::GenerateDoubleTriggerORFlag and the related functions, if
+ * their objects are the leading objects of the collection.
+ *
+ * @param df The input dataframe
+ * @param triggerflag_name name of the output flag
+ * @param collection name of the column containing the indices of the selected
+ * objects, ordered as the objects to be checked
+ * @param object_pts name of the pt column of the object collection
+ * @param object_etas name of the eta column of the object collection
+ * @param matches name of the match column created by
+ * trigger::GeometricTriggerMatch
+ * @param nobjects number of leading objects of the collection to be checked
+ * @param pt_cut minimal pt value of the object
+ * @param eta_cut maximal absolute eta value of the object
+ * @return a new dataframe containing the trigger flag column
+ */
+ROOT::RDF::RNode GenerateTriggerORFlagFromMatch(
+    ROOT::RDF::RNode df, const std::string &triggerflag_name,
+    const std::string &collection, const std::string &object_pts,
+    const std::string &object_etas, const std::string &matches,
+    const int &nobjects, const float &pt_cut, const float &eta_cut) {
+    auto triggerflag = [nobjects, pt_cut, eta_cut](
+                           const ROOT::RVec<int> &collection,
+                           const ROOT::RVec<float> &object_pts,
+                           const ROOT::RVec<float> &object_etas,
+                           const ROOT::RVec<int> &matches) {
+        const int nchecked =
+            std::min(nobjects, static_cast<int>(collection.size()));
+        for (int position = 0; position < nchecked; ++position) {
+            const int index = collection[position];
+            if (index < 0 || index >= static_cast<int>(matches.size()))
+                continue;
+            if (matches[index] >= 0 && object_pts[index] > pt_cut &&
+                std::abs(object_etas[index]) < eta_cut)
+                return true;
+        }
+        return false;
+    };
+    return df.Define(triggerflag_name, triggerflag,
+                     {collection, object_pts, object_etas, matches});
+}
+
 ////
 /**
  * @brief Function to generate a trigger flag based on a trigger
@@ -0,0 +1,60 @@
+# Run a generated executable with different numbers of threads on the same
+# input and compare the outputs event by event. Called by the determinism
+# tests via
+#   cmake -DEXECUTABLE=... -DCOMPARE=... -DINPUT=... -DTHREAD_COUNTS=1,2,8,32
+#         -DOUTPUT=... [-DSUPPRESSIONS=...] -P determinism.cmake
+# The test fails if any run fails, e.g. because ThreadSanitizer reports a data
+# race in a -DSANITIZE_THREADS=true build, or if any output differs from the
+# output of the first thread count.
+
+foreach(VARIABLE EXECUTABLE COMPARE INPUT THREAD_COUNTS OUTPUT)
+    if (NOT DEFINED ${VARIABLE})
+        message(FATAL_ERROR "${VARIABLE} has to be set")
+    endif()
+endforeach()
+string(REPLACE "," ";" THREAD_COUNTS "${THREAD_COUNTS}")
+
+# only used by executables built with ThreadSanitizer
+set(ENV{TSAN_OPTIONS} "halt_on_error=1 exitcode=66 second_deadlock_stack=1")
+if (DEFINED SUPPRESSIONS)
+    set(ENV{TSAN_OPTIONS} "$ENV{TSAN_OPTIONS} suppressions=${SUPPRESSIONS}")
+endif()
+
+file(REMOVE_RECURSE ${OUTPUT})
+foreach(NTHREADS ${THREAD_COUNTS})
+    message(STATUS "Running ${EXECUTABLE} with ${NTHREADS} threads")
+    file(MAKE_DIRECTORY ${OUTPUT}/threads_${NTHREADS})
+    set(ENV{CROWN_THREADS} ${NTHREADS})
+    execute_process(
+        COMMAND ${EXECUTABLE} ${OUTPUT}/threads_${NTHREADS}/output.root ${INPUT}
+        OUTPUT_FILE ${OUTPUT}/threads_${NTHREADS}/log.txt
+        ERROR_FILE ${OUTPUT}/threads_${NTHREADS}/log.txt
+        RESULT_VARIABLE RESULT)
+    if (NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "Run with ${NTHREADS} threads failed with ${RESULT}, see ${OUTPUT}/threads_${NTHREADS}/log.txt")
+    endif()
+endforeach()
+
+list(GET THREAD_COUNTS 0 REFERENCE)
+file(GLOB OUTPUTFILES RELATIVE ${OUTPUT}/threads_${REFERENCE} ${OUTPUT}/threads_${REFERENCE}/*.root)
+if (NOT OUTPUTFILES)
+    message(FATAL_ERROR "No outputs written with ${REFERENCE} threads")
+endif()
+set(DIFFERENT "")
+foreach(NTHREADS ${THREAD_COUNTS})
+    if (NTHREADS EQUAL REFERENCE)
+        continue()
+    endif()
+    foreach(OUTPUTFILE ${OUTPUTFILES})
+        execute_process(
+            COMMAND ${COMPARE} ${OUTPUT}/threads_${REFERENCE}/${OUTPUTFILE} ${OUTPUT}/threads_${NTHREADS}/${OUTPUTFILE}
+            RESULT_VARIABLE RESULT)
+        if (NOT RESULT EQUAL 0)
+            list(APPEND DIFFERENT "${OUTPUTFILE} (${NTHREADS} threads)")
+        endif()
+    endforeach()
+endforeach()
+if (DIFFERENT)
+    message(FATAL_ERROR "Outputs differ from the run with ${REFERENCE} threads: ${DIFFERENT}")
+endif()
+message(STATUS "Outputs of ${THREAD_COUNTS} threads are identical")
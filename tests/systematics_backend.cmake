@@ -0,0 +1,51 @@
+# Run the executable of a -DSYSTEMATICS_BACKEND=vary build and the same
+# executable of a -DSYSTEMATICS_BACKEND=duplicate build on the same input and
+# compare the outputs event by event. Called by the systematics backend tests
+# via
+#   cmake -DEXECUTABLE=... -DREFERENCE=... -DCOMPARE=... -DINPUT=...
+#         -DOUTPUT=... -P systematics_backend.cmake
+# The test fails if any run fails or if any output of the vary backend differs
+# from the output of the duplicate backend.
+
+foreach(VARIABLE EXECUTABLE REFERENCE COMPARE INPUT OUTPUT)
+    if (NOT DEFINED ${VARIABLE})
+        message(FATAL_ERROR "${VARIABLE} has to be set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE ${OUTPUT})
+foreach(BACKEND duplicate vary)
+    if (BACKEND STREQUAL "duplicate")
+        set(BACKEND_EXECUTABLE ${REFERENCE})
+    else()
+        set(BACKEND_EXECUTABLE ${EXECUTABLE})
+    endif()
+    message(STATUS "Running ${BACKEND_EXECUTABLE} (${BACKEND} backend)")
+    file(MAKE_DIRECTORY ${OUTPUT}/${BACKEND})
+    execute_process(
+        COMMAND ${BACKEND_EXECUTABLE} ${OUTPUT}/${BACKEND}/output.root ${INPUT}
+        OUTPUT_FILE ${OUTPUT}/${BACKEND}/log.txt
+        ERROR_FILE ${OUTPUT}/${BACKEND}/log.txt
+        RESULT_VARIABLE RESULT)
+    if (NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "Run of the ${BACKEND} backend failed with ${RESULT}, see ${OUTPUT}/${BACKEND}/log.txt")
+    endif()
+endforeach()
+
+file(GLOB OUTPUTFILES RELATIVE ${OUTPUT}/duplicate ${OUTPUT}/duplicate/*.root)
+if (NOT OUTPUTFILES)
+    message(FATAL_ERROR "No outputs written by the duplicate backend")
+endif()
+set(DIFFERENT "")
+foreach(OUTPUTFILE ${OUTPUTFILES})
+    execute_process(
+        COMMAND ${COMPARE} ${OUTPUT}/duplicate/${OUTPUTFILE} ${OUTPUT}/vary/${OUTPUTFILE}
+        RESULT_VARIABLE RESULT)
+    if (NOT RESULT EQUAL 0)
+        list(APPEND DIFFERENT ${OUTPUTFILE})
+    endif()
+endforeach()
+if (DIFFERENT)
+    message(FATAL_ERROR "Outputs of the vary backend differ from the duplicate backend: ${DIFFERENT}")
+endif()
+message(STATUS "Outputs of the vary and duplicate backends are identical")
@@ -0,0 +1,181 @@
+#include "TFile.h"
+#include "TLeaf.h"
+#include "TTree.h"
+#include "include/utility/EventIndex.hxx"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Compare two CROWN output files event by event. The entries of both output
+// trees are matched via their event index (utility::eventindex), i.e. after
+// sorting by (run, lumi, event), so outputs written by a multithreaded event
+// loop in different entry orders can be compared. Both files have to contain
+// the same events and columns, and every value has to be identical, NaNs are
+// considered equal. The first differences of every column are printed.
+// Returns 0 if the outputs are identical, 1 otherwise.
+//
+// Example:
+// ./compare_outputs threads_1/output_mm.root threads_8/output_mm.root
+
+struct Column {
+    TLeaf *reference;
+    TLeaf *candidate;
+    bool integer;
+    long differences = 0;
+};
+
+bool Identical(const Column &column, int i) {
+    if (column.integer)
+        return column.reference->GetValueLong64(i) ==
+               column.candidate->GetValueLong64(i);
+    const double a = column.reference->GetValue(i);
+    const double b = column.candidate->GetValue(i);
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+bool Duplicates(const std::vector<utility::eventindex::EventKey> &keys) {
+    for (std::size_t i = 1; i < keys.size(); ++i) {
+        if (!(keys[i - 1] < keys[i]))
+            return true;
+    }
+    return false;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0]
+                  << " reference.root candidate.root [--tree ntuple] "
+                     "[--max-reports 10]"
+                  << std::endl;
+        return 1;
+    }
+    const std::string referencename = argv[1];
+    const std::string candidatename = argv[2];
+    std::string treename = "ntuple";
+    long max_reports = 10;
+    for (int i = 3; i < argc; i++) {
+        const std::string arg = argv[i];
+        if ((arg == "--tree" || arg == "--max-reports") && i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        if (arg == "--tree") {
+            treename = argv[++i];
+        } else if (arg == "--max-reports") {
+            max_reports = std::stol(argv[++i]);
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::unique_ptr<TFile> reference{
+        TFile::Open(referencename.c_str(), "READ")};
+    std::unique_ptr<TFile> candidate{
+        TFile::Open(candidatename.c_str(), "READ")};
+    if (!reference || reference->IsZombie() || !candidate ||
+        candidate->IsZombie()) {
+        std::cerr << "Could not open " << referencename << " and "
+                  << candidatename << std::endl;
+        return 1;
+    }
+    auto reference_tree = reference->Get<TTree>(treename.c_str());
+    auto candidate_tree = candidate->Get<TTree>(treename.c_str());
+    const auto reference_index = utility::eventindex::Read(*reference);
+    const auto candidate_index = utility::eventindex::Read(*candidate);
+    if (!reference_tree || !candidate_tree) {
+        std::cerr << "Both files have to contain the tree " << treename
+                  << std::endl;
+        return 1;
+    }
+    if (reference_tree->GetEntries() > 0 && reference_index.empty()) {
+        std::cerr << referencename << " does not contain an event index"
+                  << std::endl;
+        return 1;
+    }
+    // the order of events with identical (run, lumi, event) is not defined
+    if (Duplicates(reference_index) || Duplicates(candidate_index)) {
+        std::cerr << "The outputs contain duplicated events and can not be "
+                     "compared event by event"
+                  << std::endl;
+        return 1;
+    }
+    if (reference_index.size() != candidate_index.size()) {
+        std::cout << "Different number of events: " << reference_index.size()
+                  << " in " << referencename << ", " << candidate_index.size()
+                  << " in " << candidatename << std::endl;
+        return 1;
+    }
+    for (std::size_t i = 0; i < reference_index.size(); ++i) {
+        const auto &a = reference_index[i];
+        const auto &b = candidate_index[i];
+        if (a < b || b < a) {
+            std::cout << "Different events: " << a.run << ":" << a.lumi << ":"
+                      << a.event << " in " << referencename << ", " << b.run
+                      << ":" << b.lumi << ":" << b.event << " in "
+                      << candidatename << std::endl;
+            return 1;
+        }
+    }
+
+    bool identical = true;
+    std::vector<Column> columns;
+    for (auto object : *reference_tree->GetListOfLeaves()) {
+        auto leaf = static_cast<TLeaf *>(object);
+        auto other = candidate_tree->GetLeaf(leaf->GetName());
+        if (!other) {
+            std::cout << "Column " << leaf->GetName() << " is missing in "
+                      << candidatename << std::endl;
+            identical = false;
+            continue;
+        }
+        const std::string type = leaf->GetTypeName();
+        columns.push_back(
+            {leaf, other, type.find("Long64") != std::string::npos});
+    }
+    for (auto object : *candidate_tree->GetListOfLeaves()) {
+        if (!reference_tree->GetLeaf(object->GetName())) {
+            std::cout << "Column " << object->GetName() << " is missing in "
+                      << referencename << std::endl;
+            identical = false;
+        }
+    }
+
+    for (std::size_t i = 0; i < reference_index.size(); ++i) {
+        const auto &key = reference_index[i];
+        reference_tree->GetEntry(key.entry);
+        candidate_tree->GetEntry(candidate_index[i].entry);
+        for (auto &column : columns) {
+            const int length = column.reference->GetLen();
+            bool same = length == column.candidate->GetLen();
+            for (int j = 0; same && j < length; ++j)
+                same = Identical(column, j);
+            if (same)
+                continue;
+            if (++column.differences <= max_reports) {
+                std::cout << "Event " << key.run << ":" << key.lumi << ":"
+                          << key.event << ", column "
+                          << column.reference->GetName() << ": "
+                          << column.reference->GetValue(0) << " ("
+                          << column.reference->GetLen() << " values) vs "
+                          << column.candidate->GetValue(0) << " ("
+                          << column.candidate->GetLen() << " values)"
+                          << std::endl;
+            }
+        }
+    }
+    long differing = 0;
+    for (auto const &column : columns) {
+        if (column.differences == 0)
+            continue;
+        differing++;
+        std::cout << "Column " << column.reference->GetName() << " differs in "
+                  << column.differences << " events" << std::endl;
+    }
+    std::printf("Compared %zu events and %zu columns, %ld columns differ\n",
+                reference_index.size(), columns.size(), differing);
+    return identical && differing == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+#include "TFile.h"
+#include "TStopwatch.h"
+#include "TTree.h"
+#include "include/utility/EventIndex.hxx"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Extract single events from a CROWN output file, using the event index
+// written after the Snapshot (utility::eventindex). Events are given as
+// run:lumi:event on the command line or as a file with one event per line.
+// Without --output, the selected events are printed, otherwise they are
+// copied to a new file.
+//
+// Example:
+// ./event_lookup output_mm.root 1:2:12345 1:2:12346 --columns pt_1,pt_2,m_vis
+// ./event_lookup output_mm.root --events sync.txt --output selected.root
+
+struct Event {
+    UInt_t run;
+    UInt_t lumi;
+    ULong64_t event;
+};
+
+bool ParseEvent(std::string line, Event &event) {
+    for (auto &c : line) {
+        if (c == ':' || c == ',')
+            c = ' ';
+    }
+    std::istringstream stream(line);
+    return static_cast<bool>(stream >> event.run >> event.lumi >> event.event);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0]
+                  << " file.root [run:lumi:event ...] [--events file.txt] "
+                     "[--columns a,b,...] [--output out.root] "
+                     "[--tree ntuple]"
+                  << std::endl;
+        return 1;
+    }
+    const std::string filename = argv[1];
+    std::string treename = "ntuple";
+    std::string columns = "";
+    std::string outputname = "";
+    std::vector<Event> events;
+    for (int i = 2; i < argc; i++) {
+        const std::string arg = argv[i];
+        if ((arg == "--events" || arg == "--columns" || arg == "--output" ||
+             arg == "--tree") &&
+            i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        if (arg == "--events") {
+            std::ifstream eventfile(argv[++i]);
+            std::string line;
+            while (std::getline(eventfile, line)) {
+                Event event;
+                if (ParseEvent(line, event))
+                    events.push_back(event);
+            }
+        } else if (arg == "--columns") {
+            columns = argv[++i];
+        } else if (arg == "--output") {
+            outputname = argv[++i];
+        } else if (arg == "--tree") {
+            treename = argv[++i];
+        } else {
+            Event event;
+            if (!ParseEvent(arg, event)) {
+                std::cerr << "Could not parse event " << arg
+                          << ", expected run:lumi:event" << std::endl;
+                return 1;
+            }
+            events.push_back(event);
+        }
+    }
+
+    TStopwatch timer;
+    timer.Start();
+    std::unique_ptr<TFile> file{TFile::Open(filename.c_str(), "READ")};
+    if (!file || file->IsZombie()) {
+        std::cerr << "Could not open " << filename << std::endl;
+        return 1;
+    }
+    auto tree = file->Get<TTree>(treename.c_str());
+    const auto index = utility::eventindex::Read(*file);
+    if (!tree || index.empty()) {
+        std::cerr << filename << " does not contain the tree " << treename
+                  << " and an event index" << std::endl;
+        return 1;
+    }
+    if (columns != "") {
+        tree->SetBranchStatus("*", 0);
+        std::istringstream stream(columns);
+        std::string column;
+        while (std::getline(stream, column, ','))
+            tree->SetBranchStatus(column.c_str(), 1);
+    }
+
+    std::unique_ptr<TFile> outputfile;
+    TTree *outputtree = nullptr;
+    if (outputname != "") {
+        outputfile.reset(TFile::Open(outputname.c_str(), "RECREATE"));
+        outputtree = tree->CloneTree(0);
+    }
+    int found = 0;
+    for (auto const &event : events) {
+        const auto entries = utility::eventindex::Find(index, event.run,
+                                                       event.lumi, event.event);
+        if (entries.empty()) {
+            std::cout << "Event " << event.run << ":" << event.lumi << ":"
+                      << event.event << " not found" << std::endl;
+            continue;
+        }
+        for (auto const &entry : entries) {
+            found++;
+            tree->GetEntry(entry);
+            if (outputtree) {
+                outputtree->Fill();
+            } else {
+                std::cout << "Event " << event.run << ":" << event.lumi << ":"
+                          << event.event << " (entry " << entry << ")"
+                          << std::endl;
+                tree->Show(entry);
+            }
+        }
+    }
+    if (outputtree) {
+        outputfile->cd();
+        outputtree->Write();
+        outputfile->Close();
+    }
+    timer.Stop();
+    std::printf("Found %d of %zu events in %.1f ms\n", found, events.size(),
+                1000. * timer.RealTime());
+    return 0;
+}
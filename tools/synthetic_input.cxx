@@ -0,0 +1,91 @@
+#include "TFile.h"
+#include "TTree.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Build a synthetic input for the multithreaded determinism tests from a
+// nanoAOD file. The Events tree is replicated several times, where the event
+// numbers of each copy are shifted, so that every (run, lumi, event) stays
+// unique. The copy is written with small clusters, so that the event loop is
+// split into enough tasks to keep all threads busy. The Runs and
+// LuminosityBlocks trees are copied once.
+//
+// Example:
+// ./synthetic_input nanoAOD.root synthetic_nanoAOD.root --copies 8
+//     --cluster-size 100
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0]
+                  << " input.root output.root [--copies 8] "
+                     "[--cluster-size 100]"
+                  << std::endl;
+        return 1;
+    }
+    const std::string inputname = argv[1];
+    const std::string outputname = argv[2];
+    long copies = 8;
+    long cluster_size = 100;
+    for (int i = 3; i < argc; i++) {
+        const std::string arg = argv[i];
+        if ((arg == "--copies" || arg == "--cluster-size") && i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        if (arg == "--copies") {
+            copies = std::max(1L, std::stol(argv[++i]));
+        } else if (arg == "--cluster-size") {
+            cluster_size = std::max(1L, std::stol(argv[++i]));
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::unique_ptr<TFile> input{TFile::Open(inputname.c_str(), "READ")};
+    if (!input || input->IsZombie()) {
+        std::cerr << "Could not open " << inputname << std::endl;
+        return 1;
+    }
+    auto events = input->Get<TTree>("Events");
+    if (!events) {
+        std::cerr << inputname << " does not contain an Events tree"
+                  << std::endl;
+        return 1;
+    }
+    ULong64_t event = 0;
+    events->SetBranchAddress("event", &event);
+    ULong64_t offset = 0;
+    for (Long64_t entry = 0; entry < events->GetEntries(); ++entry) {
+        events->GetEntry(entry);
+        offset = std::max(offset, event + 1);
+    }
+
+    std::unique_ptr<TFile> output{
+        TFile::Open(outputname.c_str(), "RECREATE")};
+    if (!output || output->IsZombie()) {
+        std::cerr << "Could not create " << outputname << std::endl;
+        return 1;
+    }
+    auto synthetic = events->CloneTree(0);
+    synthetic->SetAutoFlush(cluster_size);
+    for (long copy = 0; copy < copies; ++copy) {
+        for (Long64_t entry = 0; entry < events->GetEntries(); ++entry) {
+            events->GetEntry(entry);
+            event += copy * offset;
+            synthetic->Fill();
+        }
+    }
+    synthetic->Write();
+    for (const char *name : {"Runs", "LuminosityBlocks"}) {
+        if (auto tree = input->Get<TTree>(name))
+            tree->CloneTree(-1, "fast")->Write();
+    }
+    std::cout << "Wrote " << synthetic->GetEntries() << " events ("
+              << copies << " copies of " << events->GetEntries()
+              << " events, clusters of " << cluster_size << " events) to "
+              << outputname << std::endl;
+    return 0;
+}